@@ -25,6 +25,14 @@
     #include <stdint.h>
     
     
+    // === DEFINES: CRC ========================================================
+    
+    /// Enable the slice-by-4 CRC-16: blocks are processed 4 bytes at a time
+    /// using 4 lookup tables (2048 bytes of flash) instead of 1 lookup table
+    /// (512 bytes of flash) byte-by-byte.
+    #define ENABLE_CRC16_SLICE_BY_4                         (false)
+    
+    
     // === DEFINES: DEBUG ======================================================
     
     /// Enable the serial wire debug (SWD) functionality. Note that the SWD SDAT
@@ -54,9 +62,124 @@
     /// Enable/disable the locked I2C bus detection and recovery.
     #define ENABLE_I2C_LOCKED_BUS_DETECTION                 (true)
     
+    /// The default scheduling policy between the I2C transfer lanes (slave IRQ
+    /// reads and host transfers). If true, slave IRQ reads always take
+    /// priority (strict priority); otherwise the lanes are serviced by
+    /// weighted round-robin using the lane weights below.
+    #define ENABLE_I2C_STRICT_PRIORITY_LANES                (false)
+    
+    /// The default number of consecutive slave IRQ reads serviced before the
+    /// host lane gets a turn (weighted round-robin policy).
+    #define I2C_SLAVE_IRQ_LANE_WEIGHT                       (2u)
+    
+    /// The default number of consecutive host transfers serviced before the
+    /// slave IRQ lane gets a turn (weighted round-robin policy). This bounds
+    /// the latency of a slave IRQ read while the host is busy.
+    #define I2C_HOST_LANE_WEIGHT                            (1u)
+    
+    /// The default bit rate of the I2C bus in bits per second (100000, 400000
+    /// or 1000000); applied at startup unless the host saved another bit rate
+    /// (see BridgeCommand_I2cSpeed).
+    #define I2C_DEFAULT_BIT_RATE                            (100000u)
+    
+    /// The number of I2C slaves (for example touch controllers on the same bus)
+    /// the bridge reads the reports of; 1 to 8. Each slave context has its own
+    /// IRQ line: pin i of the slaveIrqPin component is the IRQ line of slave
+    /// context i so the component must be this many pins wide in the top
+    /// design. The slaves with an asserted IRQ are read round-robin. Slave
+    /// context 0 has the slave app address and slave context i the slave app
+    /// address + i by default; see BridgeCommand_SlaveAddress. With more than
+    /// one slave, the reports are sent in BridgeCommand_SlaveReport frames
+    /// tagged with the slave address; ENABLE_UART_TX_DELTA_REPORTS requires a
+    /// single slave.
+    #define I2C_SLAVE_COUNT                                 (1u)
+    
+    /// Enable the speculative read of the slave reports: on a slave IRQ, the
+    /// report header and the data payload expected from the last reports of
+    /// the same command are read in one transaction; the report is only read
+    /// again if its length byte shows more data. If disabled, the header is
+    /// read first and then the whole report. Adds 76 bytes to the touch heap.
+    #define ENABLE_I2C_SPECULATIVE_READ                     (true)
+    
+    /// The max number of bytes (header included) of a speculative read. Longer
+    /// reports are read the regular way; this bounds the bus time wasted if
+    /// the expected report is longer than the actual report.
+    #define I2C_SPECULATIVE_READ_MAX_SIZE                   (32u)
+    
+    
+    // === DEFINES: QUEUE ======================================================
+    
+    /// Enable the queue statistics (high-water marks, enqueue failures and
+    /// byte counters); see QueueStats. Adds 16 bytes to every queue.
+    #define ENABLE_QUEUE_STATS                              (true)
+    
     
     // === DEFINES: UART =======================================================
     
+    /// Enable the word-at-a-time (SWAR) scan for bytes that need to be escaped
+    /// when encoding transmit frames; clean runs between the escaped bytes are
+    /// block copied. If disabled, the source is scanned byte-by-byte.
+    #define ENABLE_UART_TX_SWAR_ESCAPE_SCAN                 (true)
+    
+    /// Enable the receive FIFO level trigger: the receive ISR only fires once
+    /// several bytes are in the receive FIFO and the bytes below the trigger
+    /// level are drained by the main loop (uartTranslate_processRx and
+    /// uartUpdate_process). If disabled, the receive ISR fires when the receive
+    /// FIFO is not empty. Either way, the ISR drains the whole receive FIFO.
+    #define ENABLE_UART_RX_FIFO_TRIGGER                     (true)
+    
+    /// Enable deferred receive parsing in translate mode: the receive ISR only
+    /// copies the raw bytes into a byte queue and the main loop removes the
+    /// framing protocol (uartTranslate_processRx). The receive queue memory is
+    /// split between the raw and the decoded receive queues. Update mode
+    /// always parses in the receive ISR.
+    #define ENABLE_UART_RX_DEFERRED_PARSING                 (true)
+    
+    /// Enable the interrupt-driven transmitter in translate mode: the transmit
+    /// FIFO level interrupt writes the transmit queue to the transmit FIFO in
+    /// place and uartTranslate_processTx only starts the transmitter. If
+    /// disabled, uartTranslate_processTx writes the transmit queue and waits
+    /// whenever the transmit FIFO is full.
+    #define ENABLE_UART_TX_INTERRUPT                        (true)
+    
+    /// Enable lazy transmit encoding: the transmit queue stores the raw command
+    /// and payload of each frame and the framing and escape characters are
+    /// added as the bytes are written to the UART. This halves the worst-case
+    /// transmit queue memory per frame. If disabled, the frames are encoded
+    /// when they're added to the transmit queue.
+    #define ENABLE_UART_TX_LAZY_ENCODING                    (true)
+    
+    /// Enable auto-baud detection in translate mode: after several receive
+    /// frame errors without a valid frame in between, the host UART steps to
+    /// the next standard baud rate until the frames sent by the host (each
+    /// starting with the 0xaa start frame byte) are received cleanly.
+    #define ENABLE_UART_AUTO_BAUD                           (true)
+    
+    /// Enable flow control of the host UART receive line with the hostUartRts
+    /// pin (RTS, active low): RTS is deasserted while the receive queue filled
+    /// by the receive ISR is nearly full so the host pauses instead of
+    /// overflowing it. The SCB of the device has no hardware RTS so the pin is
+    /// driven by the firmware; add the pin to the top design before enabling.
+    #define ENABLE_UART_RTS                                 (false)
+    
+    /// Enable the delta mode of the reports the I2C slave sends on its own
+    /// (see BridgeCommand_Delta): once the host enables it, a report is sent
+    /// XORed with the previous report of its report command and run-length
+    /// encoded, with a periodic full keyframe. The previous reports take 260
+    /// bytes of the transmit queue memory so the transmit queue gets smaller.
+    #define ENABLE_UART_TX_DELTA_REPORTS                    (false)
+    
+    /// Enable the statistics of the bridge commands (invocations and system
+    /// clock cycles spent in the handler); see StatsCommand_Commands. Adds 8
+    /// bytes of RAM per command handler (256 bytes).
+    #define ENABLE_UART_COMMAND_STATS                       (false)
+    
+    /// The default receive frame timeout in microseconds: if the receive line
+    /// is idle this long within a frame, the partial frame is discarded and the
+    /// receive state machine waits for the next start of frame. The host can
+    /// change it at runtime; 0 disables it.
+    #define UART_RX_FRAME_TIMEOUT_US                        (2000u)
+    
     
     // === DEFINES: PRINTF =====================================================
     
@@ -18,8 +18,67 @@
 #include <string.h>
 
 
+// === DEFINES =================================================================
+
+/// Memory barrier: guarantees that the data is completely written before the
+/// new tail is published to the consumer and that the consumer is done with
+/// the data before the new head is published to the producer. Also acts as a
+/// compiler barrier.
+#if defined(__arm__)
+    #define MEMORY_BARRIER()    __asm volatile ("dmb" ::: "memory")
+#else
+    #define MEMORY_BARRIER()    __sync_synchronize()
+#endif
+
+
 // === PRIVATE FUNCTIONS =======================================================
 
+/// Get the data array index of a head or tail position. Positions run from 0
+/// to (2 * maxSize - 1) so a full queue can be distinguished from an empty
+/// queue without a shared size counter.
+/// @param[in]  queue       The queue.
+/// @param[in]  position    The head or tail position.
+/// @return The index in the data array.
+static uint16_t getIndex(ByteQueue const volatile* queue, uint16_t position)
+{
+    return (position < queue->maxSize) ? position : (position - queue->maxSize);
+}
+
+
+/// Advance a head or tail position.
+/// @param[in]  queue       The queue.
+/// @param[in]  position    The head or tail position.
+/// @param[in]  size        The number of bytes to advance; must not exceed
+///                         maxSize.
+/// @return The advanced position.
+static uint16_t advancePosition(ByteQueue const volatile* queue, uint16_t position, uint16_t size)
+{
+    uint32_t next = (uint32_t)position + size;
+    if (next >= ((uint32_t)queue->maxSize << 1))
+        next -= ((uint32_t)queue->maxSize << 1);
+    return (uint16_t)next;
+}
+
+
+/// Get the number of bytes in the queue based on a head and tail position.
+/// @param[in]  queue   The queue.
+/// @param[in]  head    The head position.
+/// @param[in]  tail    The tail position.
+/// @return The number of bytes in the queue.
+static uint16_t getSize(ByteQueue const volatile* queue, uint16_t head, uint16_t tail)
+{
+    return (tail >= head) ? (tail - head) : (uint16_t)((uint32_t)tail + ((uint32_t)queue->maxSize << 1) - head);
+}
+
+
+/// Check if the queue is valid (has a data array).
+/// @param[in]  queue   The queue.
+/// @return If the queue is valid.
+static bool isValid(ByteQueue const volatile* queue)
+{
+    return (queue != NULL) && (queue->data != NULL) && (queue->maxSize > 0);
+}
+
 
 // === PUBLIC FUNCTIONS ========================================================
 
@@ -29,7 +88,6 @@ void byteQueue_empty(ByteQueue volatile* queue)
     {
         queue->head = 0;
         queue->tail = 0;
-        queue->size = 0;
     }
 }
 
@@ -37,8 +95,8 @@ void byteQueue_empty(ByteQueue volatile* queue)
 bool byteQueue_isFull(ByteQueue const volatile* queue)
 {
     bool status = true;
-    if (queue != NULL)
-        status = (queue->size >= queue->maxSize);
+    if (isValid(queue))
+        status = (getSize(queue, queue->head, queue->tail) >= queue->maxSize);
     return status;
 }
 
@@ -46,50 +104,72 @@ bool byteQueue_isFull(ByteQueue const volatile* queue)
 bool byteQueue_isEmpty(ByteQueue const volatile* queue)
 {
     bool status = true;
-    if (queue != NULL)
-        status = (queue->size <= 0);
+    if (isValid(queue))
+        status = (queue->head == queue->tail);
     return status;
 }
 
 
-bool bytequeue_enqueue(ByteQueue volatile* queue, uint8_t const data[], uint16_t size)
+uint16_t byteQueue_getFreeSize(ByteQueue const volatile* queue)
+{
+    uint16_t size = 0;
+    if (isValid(queue))
+        size = queue->maxSize - getSize(queue, queue->head, queue->tail);
+    return size;
+}
+
+
+uint16_t byteQueue_getTail(ByteQueue const volatile* queue)
+{
+    uint16_t tail = 0;
+    if (isValid(queue))
+        tail = queue->tail;
+    return tail;
+}
+
+
+uint16_t byteQueue_getOffset(ByteQueue const volatile* queue, uint16_t position)
+{
+    uint16_t offset = 0;
+    if (isValid(queue))
+        offset = getSize(queue, queue->head, position);
+    return offset;
+}
+
+
+bool byteQueue_enqueue(ByteQueue volatile* queue, uint8_t const data[], uint16_t size)
 {
     bool status = false;
-    if (!byteQueue_isFull(queue) && (data != NULL) && (size > 0) && (size <= (queue->maxSize - queue->size)))
+    if (isValid(queue) && (data != NULL) && (size > 0))
     {
-        uint16_t copySize = queue->maxSize - queue->tail;
-        if (copySize > size)
-            copySize = size;
-        memcpy(&queue->data[queue->tail], data, copySize);
-        if (copySize < size)
+        uint16_t tail = queue->tail;
+        if (size <= (queue->maxSize - getSize(queue, queue->head, tail)))
         {
-            data += copySize;
-            copySize = size - copySize;
-            memcpy(queue->data, data, copySize);
-            queue->tail = copySize;
+            uint16_t index = getIndex(queue, tail);
+            uint16_t copySize = queue->maxSize - index;
+            if (copySize > size)
+                copySize = size;
+            memcpy(&queue->data[index], data, copySize);
+            if (copySize < size)
+                memcpy(queue->data, &data[copySize], size - copySize);
+            MEMORY_BARRIER();
+            queue->tail = advancePosition(queue, tail, size);
+            status = true;
         }
-        else
-        {
-            queue->tail += copySize;
-            if (queue->tail >= queue->maxSize)
-                queue->tail = 0;
-        }
-        queue->size += size;
-        status = true;
     }
     return status;
 }
 
 
-bool bytequeue_enqueueByte(ByteQueue volatile* queue, uint8_t data)
+bool byteQueue_enqueueByte(ByteQueue volatile* queue, uint8_t data)
 {
     bool status = false;
     if (!byteQueue_isFull(queue))
     {
-        queue->data[queue->tail++] = data;
-        if (queue->tail >= queue->maxSize)
-            queue->tail = 0;
-        --queue->size;
+        uint16_t tail = queue->tail;
+        queue->data[getIndex(queue, tail)] = data;
+        MEMORY_BARRIER();
+        queue->tail = advancePosition(queue, tail, 1u);
         status = true;
     }
     return status;
@@ -100,15 +180,7 @@ uint16_t byteQueue_dequeue(ByteQueue volatile* queue, uint8_t data[], uint16_t s
 {
     uint16_t dequeueSize = byteQueue_peak(queue, data, size);
     if (dequeueSize > 0)
-    {
-        uint32_t head = queue->head + dequeueSize;
-        if (head >= queue->maxSize)
-            head -= queue->maxSize;
-        queue->head = (uint16_t)head;
-        queue->size -= dequeueSize;
-        if (byteQueue_isEmpty(queue))
-            byteQueue_empty(queue);
-    }
+        byteQueue_dequeueSpan(queue, dequeueSize);
     return dequeueSize;
 }
 
@@ -116,15 +188,8 @@ uint16_t byteQueue_dequeue(ByteQueue volatile* queue, uint8_t data[], uint16_t s
 int byteQueue_dequeueByte(ByteQueue volatile* queue)
 {
     int byte = byteQueue_peakByte(queue);
-    if (byte < 0)
-    {
-        queue->head++;
-        if (queue->head >= queue->maxSize)
-            queue->head = 0;
-        queue->size--;
-        if (byteQueue_isEmpty(queue))
-            byteQueue_empty(queue);
-    }
+    if (byte >= 0)
+        byteQueue_dequeueSpan(queue, 1u);
     return byte;
 }
 
@@ -133,20 +198,18 @@ uint16_t byteQueue_peak(ByteQueue const volatile* queue, uint8_t data[], uint16_
 {
     if (!byteQueue_isEmpty(queue) && (data != NULL) && (size > 0))
     {
-        if (size > queue->size)
-            size = queue->size;
+        uint16_t head = queue->head;
+        uint16_t queueSize = getSize(queue, head, queue->tail);
+        MEMORY_BARRIER();
+        if (size > queueSize)
+            size = queueSize;
+        uint16_t index = getIndex(queue, head);
         uint16_t copySize = size;
-        if ((queue->head + copySize) > queue->maxSize)
-        {
-            copySize = queue->maxSize - queue->head;
-        }    
-        memcpy(data, &queue->data[queue->head], copySize);
+        if ((index + copySize) > queue->maxSize)
+            copySize = queue->maxSize - index;
+        memcpy(data, &queue->data[index], copySize);
         if (copySize < size)
-        {
-            data += copySize;
-            copySize = size - copySize;
-            memcpy(data, queue->data, copySize);
-        }
+            memcpy(&data[copySize], queue->data, size - copySize);
     }
     else
         size = 0;
@@ -158,9 +221,45 @@ int byteQueue_peakByte(ByteQueue const volatile* queue)
 {
     int data = -1;
     if (!byteQueue_isEmpty(queue))
-        data = (int)queue->data[queue->head];
+    {
+        MEMORY_BARRIER();
+        data = (int)queue->data[getIndex(queue, queue->head)];
+    }
     return data;
 }
 
 
+uint16_t byteQueue_peakSpan(ByteQueue const volatile* queue, uint8_t const** data)
+{
+    uint16_t size = 0;
+    if (!byteQueue_isEmpty(queue) && (data != NULL))
+    {
+        uint16_t head = queue->head;
+        size = getSize(queue, head, queue->tail);
+        MEMORY_BARRIER();
+        uint16_t index = getIndex(queue, head);
+        if ((index + size) > queue->maxSize)
+            size = queue->maxSize - index;
+        *data = &queue->data[index];
+    }
+    return size;
+}
+
+
+uint16_t byteQueue_dequeueSpan(ByteQueue volatile* queue, uint16_t size)
+{
+    uint16_t dequeueSize = 0;
+    if (isValid(queue) && (size > 0))
+    {
+        uint16_t head = queue->head;
+        dequeueSize = getSize(queue, head, queue->tail);
+        if (dequeueSize > size)
+            dequeueSize = size;
+        MEMORY_BARRIER();
+        queue->head = advancePosition(queue, head, dequeueSize);
+    }
+    return dequeueSize;
+}
+
+
 /* [] END OF FILE */
@@ -26,33 +26,39 @@
     
     // === TYPE DEFINES ========================================================
     
-    /// Definition of the byte queue.
+    /// Definition of the byte queue. Size (32-bit) = 12.
+    ///
+    /// The byte queue is a lock-free single-producer/single-consumer ring: one
+    /// context (for example an ISR) may enqueue while another context (for
+    /// example the main loop) peaks and dequeues without disabling interrupts.
+    /// The producer owns tail, the consumer owns head and the number of bytes
+    /// is derived from head and tail.
     typedef struct ByteQueue
     {
         /// Pointer to array that holds the bytes.
         uint8_t* data;
         
-        /// The maximum number of bytes that can fit in data.
+        /// The maximum number of bytes that can fit in data (32767 max).
         uint16_t maxSize;
         
-        /// The head of the queue, data is dequeued (removed) from the head.
+        /// The head position of the queue, data is dequeued (removed) from the
+        /// head. Only modified by the consumer. Positions run from 0 to
+        /// (2 * maxSize - 1) so a full queue differs from an empty queue.
         uint16_t head;
         
-        /// The tail of the queue, data is enqueued (added) to the tail.
+        /// The tail position of the queue, data is enqueued (added) to the
+        /// tail. Only modified by the producer.
         uint16_t tail;
         
-        /// The number of bytes currently in the queue.
-        uint16_t size;
-        
     } ByteQueue;
     
     
     // === FUNCTIONS ===========================================================
     
     /// Empty the queue. Note that the data array holding will not be cleared;
-    /// residual data will remain. Because the empty operation modifies the
-    /// queue data structure, DO NOT empty the queue in an ISR unless the queue
-    /// is protected by a mutex, semaphore, or lock.
+    /// residual data will remain. Because the empty operation modifies both
+    /// the head and the tail, only empty the queue when neither the producer
+    /// nor the consumer is active.
     /// @param[in]  queue   The queue to perform the function's action on.
     void byteQueue_empty(ByteQueue volatile* queue);
     
@@ -69,26 +75,45 @@
     ///         invalid (NULL).
     bool byteQueue_isEmpty(ByteQueue const volatile* queue);
     
-    /// Enqueue (add) multiple new bytes into the queue tail (end). Because an
-    /// enqueue modifies the queue data structure, DO NOT enqueue in an ISR
-    /// unless the queue is protected by a mutex, semaphore, or lock.
+    /// Get the number of bytes that can be enqueued.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @return The number of free bytes in the queue. Returns 0 if the queue is
+    ///         invalid (NULL).
+    uint16_t byteQueue_getFreeSize(ByteQueue const volatile* queue);
+    
+    /// Get the tail position of the queue. The position marks the end of the
+    /// bytes enqueued so far (see byteQueue_getOffset). Only call from the
+    /// producer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @return The tail position.
+    uint16_t byteQueue_getTail(ByteQueue const volatile* queue);
+    
+    /// Get the number of bytes from the head of the queue to a position from
+    /// byteQueue_getTail. The position is only valid until the head moves past
+    /// it. Only call from the consumer context.
+    /// @param[in]  queue       The queue to perform the function's action on.
+    /// @param[in]  position    The position from byteQueue_getTail.
+    /// @return The number of bytes before the position; 0 if the queue is
+    ///         invalid (NULL).
+    uint16_t byteQueue_getOffset(ByteQueue const volatile* queue, uint16_t position);
+    
+    /// Enqueue (add) multiple new bytes into the queue tail (end). Only call
+    /// from the producer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[in]  data    The data to enqueue.
     /// @param[in]  size    The size of the data (in bytes) to enqueue.
     /// @return If the enqueue operation was successful.
-    bool bytequeue_enqueue(ByteQueue volatile* queue, uint8_t const data[], uint16_t size);
+    bool byteQueue_enqueue(ByteQueue volatile* queue, uint8_t const data[], uint16_t size);
     
-    /// Enqueue (add) a new byte into the queue tail (end). Because an enqueue
-    /// modifies the queue data structure, DO NOT enqueue in an ISR unless the
-    /// queue is protected by a mutex, semaphore, or lock.
+    /// Enqueue (add) a new byte into the queue tail (end). Only call from the
+    /// producer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[in]  data    The data to enqueue.
     /// @return If the enqueue operation was successful.
-    bool bytequeue_enqueueByte(ByteQueue volatile* queue, uint8_t data);
+    bool byteQueue_enqueueByte(ByteQueue volatile* queue, uint8_t data);
     
     /// Dequeue (remove) a variable number of bytes from the queue head (front).
-    /// Because a dequeue modifies the queue data structure, DO NOT dequeue in
-    /// an ISR unless the queue is protected by a mutex, semaphore, or lock.
+    /// Only call from the consumer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[out] data    The data buffer to copy the dequeued data to.
     /// @param[in]  size    The number of bytes to dequeue. Size must be greater
@@ -96,9 +121,8 @@
     /// @return The number of bytes that were dequeued.
     uint16_t byteQueue_dequeue(ByteQueue volatile* queue, uint8_t data[], uint16_t size);
     
-    /// Dequeue (remove) a byte from the queue head (front). Because a dequeue
-    /// modifies the queue data structure, DO NOT dequeue in an ISR unless the
-    /// queue is protected by a mutex, semaphore, or lock.
+    /// Dequeue (remove) a byte from the queue head (front). Only call from the
+    /// consumer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @return The dequeued byte. If -1, then an error occured.
     int byteQueue_dequeueByte(ByteQueue volatile* queue);
@@ -120,6 +144,24 @@
     /// @return The peaked byte. If -1, then an error occured.
     int byteQueue_peakByte(ByteQueue const volatile* queue);
     
+    /// Get direct access to the oldest bytes from the queue head (front)
+    /// without copying them. Only the bytes up to the end of the data array
+    /// are provided; the bytes that wrap to the start of the data array are
+    /// provided by the next call. Release the bytes with byteQueue_dequeueSpan
+    /// once they have been processed. Only call from the consumer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[out] data    Pointer to the oldest byte in the queue.
+    /// @return The number of contiguous bytes available at data.
+    uint16_t byteQueue_peakSpan(ByteQueue const volatile* queue, uint8_t const** data);
+    
+    /// Dequeue (remove) bytes from the queue head (front) without copying
+    /// them, usually the bytes returned by byteQueue_peakSpan. Only call from
+    /// the consumer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[in]  size    The number of bytes to dequeue.
+    /// @return The number of bytes that were dequeued.
+    uint16_t byteQueue_dequeueSpan(ByteQueue volatile* queue, uint16_t size);
+    
     
     #ifdef __cplusplus
         } // extern "C"
@@ -0,0 +1,62 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+#ifndef CRC16_H
+    #define CRC16_H
+    
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+    
+    // === DEPENDENCIES ========================================================
+    
+    #include <stdint.h>
+    
+    
+    // === DEFINES =============================================================
+    
+    /// The initial value of a CRC-16 calculation (CRC-16/CCITT-FALSE:
+    /// polynomial 0x1021, not reflected, no final XOR).
+    #define CRC16_INITIAL_VALUE         (0xffffu)
+    
+    /// The CRC-16 of a block of data followed by its own CRC-16 (big-endian)
+    /// is always this value; used to check a received block in one pass.
+    #define CRC16_RESIDUE               (0x0000u)
+    
+    
+    // === FUNCTIONS ===========================================================
+    
+    /// Update a CRC-16 with a byte.
+    /// @param[in]  crc     The CRC-16 so far; CRC16_INITIAL_VALUE to start.
+    /// @param[in]  data    The byte to add to the CRC-16.
+    /// @return The updated CRC-16.
+    uint16_t crc16_updateByte(uint16_t crc, uint8_t data);
+    
+    /// Update a CRC-16 with a block of data. The CRC-16 can be calculated
+    /// incrementally: updating with two blocks gives the same result as
+    /// updating with the concatenation of the blocks. If
+    /// ENABLE_CRC16_SLICE_BY_4 is set, the data is processed 4 bytes at a time.
+    /// @param[in]  crc     The CRC-16 so far; CRC16_INITIAL_VALUE to start.
+    /// @param[in]  data    The data to add to the CRC-16.
+    /// @param[in]  size    The number of bytes of data.
+    /// @return The updated CRC-16.
+    uint16_t crc16_update(uint16_t crc, uint8_t const data[], uint16_t size);
+    
+    
+    #ifdef __cplusplus
+        } // extern "C"
+    #endif
+    
+#endif // CRC16_H
+
+
+/* [] END OF FILE */
@@ -15,6 +15,10 @@
 
     /*Define your macro callbacks here */
     /*For more information, refer to the Writing Code topic in the PSoC Creator Help.*/
+    
+    /* Flag the completion of the I2C master transfers to the comm FSM (i2c.c). */
+    #define slaveI2c_I2C_ISR_EXIT_CALLBACK
+    void slaveI2c_I2C_ISR_ExitCallback(void);
 
     
 #endif /* CYAPICALLBACKS_H */   
@@ -74,4 +74,44 @@ uint32_t hwSystemTime_getCurrentMs(void)
 }
 
 
+uint32_t hwSystemTime_getCurrentTicks(void)
+{
+    return SysTick->VAL;
+}
+
+
+uint32_t hwSystemTime_getElapsedTicks(uint32_t startTicks)
+{
+    // The system timer counts down so the counter wraps from 0 to the reload
+    // value.
+    uint32_t currentTicks = SysTick->VAL;
+    if (startTicks >= currentTicks)
+        return startTicks - currentTicks;
+    return startTicks + SysTick->LOAD + 1u - currentTicks;
+}
+
+
+uint32_t hwSystemTime_getTimestamp(void)
+{
+    // Read again if the system tick interrupt updates the current time while
+    // reading the counter. If the counter wrapped but the interrupt is still
+    // pending (interrupts are masked), the period is added here.
+    uint32_t currentTimeMs;
+    uint32_t currentTicks;
+    bool pending;
+    do
+    {
+        currentTimeMs = g_currentTimeMs;
+        currentTicks = SysTick->VAL;
+        pending = ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0);
+        if (pending)
+            currentTicks = SysTick->VAL;
+    } while (currentTimeMs != g_currentTimeMs);
+    
+    if (pending)
+        currentTimeMs += g_periodMs;
+    return (currentTimeMs * ONE_MILLISECOND) + (SysTick->LOAD - currentTicks);
+}
+
+
 /* [] END OF FILE */
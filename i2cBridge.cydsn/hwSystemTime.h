@@ -36,6 +36,25 @@
     /// @return The current system time in milliseconds.
     uint32_t hwSystemTime_getCurrentMs(void);
     
+    /// Gets the current value of the system timer counter in ticks (system
+    /// clock cycles). The counter counts down and reloads every period; use
+    /// hwSystemTime_getElapsedTicks to measure short intervals.
+    /// @return The current value of the system timer counter.
+    uint32_t hwSystemTime_getCurrentTicks(void);
+    
+    /// Gets the number of ticks (system clock cycles) that elapsed since the
+    /// start ticks. Only valid for intervals shorter than the period.
+    /// @param[in]  startTicks  The ticks from hwSystemTime_getCurrentTicks at
+    ///                         the start of the interval.
+    /// @return The number of ticks that elapsed.
+    uint32_t hwSystemTime_getElapsedTicks(uint32_t startTicks);
+    
+    /// Gets a free-running timestamp in ticks (system clock cycles) to measure
+    /// intervals longer than the period. The timestamp wraps around every 2^32
+    /// ticks; subtract two timestamps to get the elapsed ticks.
+    /// @return The current timestamp in ticks.
+    uint32_t hwSystemTime_getTimestamp(void);
+    
     
     #ifdef __cplusplus
         } // extern "C"
@@ -15,6 +15,7 @@
 #include "i2c.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "alarm.h"
 #include "debug.h"
@@ -23,6 +24,7 @@
 #include "i2cUpdate.h"
 #include "project.h"
 #include "queue.h"
+#include "settings.h"
 #include "utility.h"
 
 
@@ -37,6 +39,14 @@
 /// Name of the slave IRQ pin component.
 #define SLAVE_IRQ_PIN                   slaveIrqPin_
 
+/// Mask of the IRQ lines of the slave contexts; pin i of the slave IRQ pin
+/// component is the IRQ line of slave context i.
+#define SLAVE_IRQ_MASK                  ((1u << I2C_SLAVE_COUNT) - 1u)
+
+#if (I2C_SLAVE_COUNT < 1) || (I2C_SLAVE_COUNT > 8)
+    #error "i2c.c: I2C_SLAVE_COUNT must be 1 to 8 (one bit per slave context)."
+#endif
+
 /// Enable/disable checking if on slave IRQ, if a write to change to the slave
 /// app's response buffer must be done before reading.
 /// true:   always change to the response buffer on every interrupt.
@@ -57,6 +67,23 @@
 /// queue.
 #define XFER_QUEUE_DATA_SIZE            (600u)
 
+/// The maximum number of transfer queue elements that are peaked and acted on
+/// back-to-back before the communication state machine returns to waiting.
+#define XFER_BATCH_SIZE                 (4u)
+
+#if ENABLE_I2C_SPECULATIVE_READ
+
+    /// The number of app commands (0x00-0x0d; see AppCommand) whose report
+    /// sizes are tracked for the speculative read; the reports of the other
+    /// commands share the entry of the invalid command 0x00.
+    #define SPECULATIVE_READ_COMMAND_COUNT  (14u)
+
+    /// The number of last report sizes per command the size of the speculative
+    /// read is found from.
+    #define SPECULATIVE_READ_HISTORY_SIZE   (4u)
+
+#endif // ENABLE_I2C_SPECULATIVE_READ
+
 
 // === TYPE DEFINES ============================================================
 
@@ -75,6 +102,31 @@ typedef uint16_t mstatus_t;
 typedef uint32_t mreturn_t;
 
 
+/// Configuration of the slaveI2c SCB for an I2C bit rate; see i2c_setBitRate.
+typedef struct BitRateConfig
+{
+    /// The bit rate in bits per second.
+    uint32_t bitRate;
+    
+    /// The divider of the SCB clock from HFCLK.
+    uint8_t clockDivider;
+    
+    /// The number of SCB clock cycles of the SCL low phase.
+    uint8_t lowPhaseOversampling;
+    
+    /// The number of SCB clock cycles of the SCL high phase.
+    uint8_t highPhaseOversampling;
+    
+    /// The SCL period in 1/4 microseconds; see findExtendedTimeoutMs.
+    uint8_t periodQuarterUs;
+    
+    /// Flag indicating if the analog glitch filters of the SDA and SCL inputs
+    /// are used; if not, the digital median filter is used instead.
+    bool analogFilter;
+    
+} BitRateConfig;
+
+
 /// Pre-defined 7-bit addresses of slave devices on the I2C bus.
 typedef enum SlaveAddress
 {
@@ -95,8 +147,16 @@ typedef enum XferQueueDataOffset
     /// The I2C address.
     XferQueueDataOffset_Xfer            = 0u,
     
-    /// The start of the data payload.
-    XferQueueDataOffset_Data            = 1u,
+    /// The tag of the transfer; see i2cTouch_read.
+    XferQueueDataOffset_Tag             = 1u,
+    
+    /// The start of the data payload: for a read, the number of bytes to read;
+    /// for a write, the data to write.
+    XferQueueDataOffset_Data            = 2u,
+    
+    /// For a read, the start of the optional data to write before the read
+    /// (write-read transfer; see i2cTouch_writeRead).
+    XferQueueDataOffset_WriteReadData   = 3u,
     
 } XferQueueDataOffset;
 
@@ -222,6 +282,10 @@ typedef enum CommState
     /// type of transfer.
     CommState_XferDequeueAndAct,
     
+    /// Read with a repeated START once the write of a write-read transfer
+    /// queue transaction has completed.
+    CommState_XferWriteReadRestart,
+    
     /// Check if the last read transfer queue transaction has completed.
     CommState_XferRxCheckComplete,
     
@@ -264,6 +328,26 @@ typedef union I2cXfer
 } I2cXfer;
 
 
+/// The state of a slave device that reads are triggered for by its IRQ line.
+typedef struct SlaveContext
+{
+    /// The 7-bit slave address.
+    uint8_t address;
+    
+#if !ENABLE_ALL_CHANGE_TO_RESPONSE
+    
+    /// Flag indicating we're in the response buffer is active for the slave app.
+    bool appResponseActive;
+    
+    /// Flag indicating on receive, if a write needs to be done to switch to the
+    /// response buffer.
+    bool appRxSwitchToResponse;
+    
+#endif // !ENABLE_ALL_CHANGE_TO_RESPONSE
+    
+} SlaveContext;
+
+
 /// Contains the results of the processRxLength function.
 typedef struct AppRxLengthResult
 {
@@ -315,20 +399,103 @@ typedef struct CommFsm
     /// Number of bytes that need to be received (pending).
     uint16_t pendingRxSize;
     
-    /// The slave IRQ was triggered so the slave indicating there's data to be
-    /// read. This needs to be volatile because it's modified in an ISR.
-    volatile bool rxPending;
+    /// Bit i is set when the IRQ of slave context i was triggered indicating
+    /// there's data to be read. This needs to be volatile because it's modified
+    /// in an ISR.
+    volatile uint8_t rxPendingMask;
+    
+    /// The slave context of the slave IRQ read being processed; also the last
+    /// slave context read for the round-robin between the slave IRQs.
+    uint8_t slave;
+    
+    /// The 7-bit address of the transfer being processed. Passed to the receive
+    /// callback.
+    uint8_t address;
     
     /// Flag indicating if another attempt at a read should be performed but
     /// switch to the response buffer first.
     bool rxSwitchToResponseBuffer;
     
+    /// The tag of the transfer being processed; 0 for the reads triggered by
+    /// the slave IRQ. Passed to the callbacks.
+    uint8_t tag;
+    
     /// The current state.
     CommState state;
     
+    /// Transfer queue elements peaked in the current batch; they're only
+    /// released after their transfer completes so the write data remains
+    /// valid while the state machine yields between calls.
+    QueueSpan xferSpans[XFER_BATCH_SIZE];
+    
+    /// The number of transfers in the current batch.
+    uint8_t xferSpanCount;
+    
+    /// The number of transfers of the current batch acted on.
+    uint8_t xferCount;
+    
+    /// Alarm that bounds the I2C transfer in progress; if it elapses before
+    /// the completion is flagged, the driver status is checked.
+    Alarm xferAlarm;
+    
+    /// Flag indicating an I2C transfer was started and its completion hasn't
+    /// been processed yet.
+    bool xferInProgress;
+    
+    /// Flag indicating the I2C transfer completed; set by the I2C ISR (see
+    /// COMPONENT(SLAVE_I2C, I2C_ISR_ExitCallback)). This needs to be volatile
+    /// because it's modified in an ISR.
+    volatile bool xferDone;
+    
 } CommFsm;
 
 
+/// Structure to hold variables associated with scheduling the transfer lanes
+/// (see I2cLane).
+typedef struct LaneScheduler
+{
+    /// The counters of each lane.
+    I2cLaneStats stats[I2cLane_Count];
+    
+    /// The number of consecutive transactions each lane is serviced for before
+    /// the other lane gets a turn (weighted round-robin).
+    uint8_t weights[I2cLane_Count];
+    
+    /// The lane that currently has the turn (weighted round-robin).
+    uint8_t lane;
+    
+    /// The number of transactions remaining in the current lane's turn
+    /// (weighted round-robin).
+    uint8_t turns;
+    
+    /// The scheduling policy.
+    I2cLanePolicy policy;
+    
+} LaneScheduler;
+
+
+#if ENABLE_I2C_SPECULATIVE_READ
+    
+    /// The data payload sizes of the last slave reports used to find the size
+    /// of the speculative read (see findRxReadSize).
+    typedef struct SpeculativeRead
+    {
+        /// The data payload sizes of the last reports of each command; each
+        /// command's sizes are a ring buffer.
+        uint8_t payloadSizes[SPECULATIVE_READ_COMMAND_COUNT][SPECULATIVE_READ_HISTORY_SIZE];
+        
+        /// The index of the oldest payload size of each command.
+        uint8_t indexes[SPECULATIVE_READ_COMMAND_COUNT];
+        
+        /// The command of the last report; the next report is expected to be
+        /// a report of the same command.
+        uint8_t command;
+        
+    } SpeculativeRead;
+    
+#endif // ENABLE_I2C_SPECULATIVE_READ
+
+
 #if ENABLE_I2C_LOCKED_BUS_DETECTION
     
     /// Locked bus variables.
@@ -372,10 +539,13 @@ typedef struct Heap
     /// Size of the raw receive data buffer.
     uint16_t rxBufferSize;
     
-    /// The I2C address and direction associated with the transaction that is
-    /// waiting to be enqueued into the transfer queue. This must be set prior
-    /// to enqueueing data into the transfer queue.
-    I2cXfer pendingQueueXfer;
+#if ENABLE_I2C_SPECULATIVE_READ
+    
+    /// Pointer to the report sizes of the speculative read; NULL in update
+    /// mode.
+    SpeculativeRead* speculativeRead;
+    
+#endif // ENABLE_I2C_SPECULATIVE_READ
     
 } Heap;
 
@@ -391,9 +561,10 @@ typedef struct TouchHeapData
     QueueElement xferQueueElements[XFER_QUEUE_MAX_SIZE];
     
     /// Array to hold the data of the elements in the transfer queue. Note that
-    /// each transfer queue element has at least 2 bytes:
+    /// each transfer queue element has at least 3 bytes:
     /// [0]: I2cXfer (adress and direction)
-    /// [1]:
+    /// [1]: tag
+    /// [2]:
     ///     read: number of bytes to read.
     ///     write: data payload...
     uint8_t xferQueueData[XFER_QUEUE_DATA_SIZE];
@@ -401,6 +572,13 @@ typedef struct TouchHeapData
     /// The raw receive buffer.
     uint8_t rxBuffer[TOUCH_RX_BUFFER_SIZE];
     
+#if ENABLE_I2C_SPECULATIVE_READ
+    
+    /// The report sizes of the speculative read.
+    SpeculativeRead speculativeRead;
+    
+#endif // ENABLE_I2C_SPECULATIVE_READ
+    
 } TouchHeapData;
 
 
@@ -509,11 +687,23 @@ static uint8_t const G_AppRxPacketLengthSize = AppRxPacketOffset_Length + 1u;
 /// The value of the length byte which indicates the packet is invalid.
 static uint8_t const G_InvalidRxAppPacketLength = 0xff;
 
+/// The mask of the command in the command byte of a receive packet.
+static uint8_t const G_AppRxCommandMask = 0x7f;
+
 /// The default amount of time to allow for a I2C stop condition to be sent
 /// before timing out. If a time out occurs, the I2C module is reset. This is
 /// in milliseconds.
 static uint32_t const G_DefaultSendStopTimeoutMs = 5u;
 
+/// The time in milliseconds added to the duration of an I2C transfer (see
+/// findExtendedTimeoutMs) before it's considered timed out; covers the clock
+/// stretching of the slave.
+static uint32_t const G_XferTimeoutMarginMs = 5u;
+
+/// The driver status flags that indicate the I2C transfer completed (with or
+/// without errors).
+static mstatus_t const G_XferDoneMask = COMPONENT(SLAVE_I2C, I2C_MSTAT_RD_CMPLT) | COMPONENT(SLAVE_I2C, I2C_MSTAT_WR_CMPLT);
+
 /// Message to write to the I2C slave to clear the IRQ. This can also be used
 /// to switch to the response buffer.
 static uint8_t const G_ClearIrqMessage[] = { AppBufferOffset_Response, 0 };
@@ -528,6 +718,14 @@ static uint8_t const G_ResponseBufferSize = sizeof(G_ClearIrqMessage) - 1u;
 /// Default transfer mode mask for the low-level I2C driver reads/writes.
 static uint8_t const G_DefaultTransferMode = COMPONENT(SLAVE_I2C, I2C_MODE_COMPLETE_XFER);
 
+/// The transfer mode of the write of a write-read transfer: the bus is held
+/// (no STOP) for the read that follows.
+static uint8_t const G_WriteReadWriteMode = COMPONENT(SLAVE_I2C, I2C_MODE_NO_STOP);
+
+/// The transfer mode of the read of a write-read transfer: the read starts with
+/// a repeated START.
+static uint8_t const G_WriteReadReadMode = COMPONENT(SLAVE_I2C, I2C_MODE_REPEAT_START);
+
 /// Default timeout for the alarm for detecting a locked bus condition.
 static uint32_t const G_DefaultLockedBusDetectTimeoutMs = 100u;
 
@@ -541,6 +739,21 @@ static uint8_t const G_MaxRecoveryAttempts = 10u;
 /// The default I2cStatus with no error flags set.
 static I2cStatus const G_NoErrorI2cStatus = { 0u };
 
+/// The supported I2C bit rates; the SCB clocks and the SCL oversampling follow
+/// the I2C master data rate table of the PSoC 4 TRM (HFCLK is 48 MHz). Fm+
+/// (1 MHz) uses the digital median filter instead of the analog filters.
+static BitRateConfig const G_BitRateConfigs[] =
+{
+    // 1.6 MHz SCB clock.
+    { 100000u,  (uint8_t)(CYDEV_BCLK__HFCLK__HZ / 1600000u),    8u,     8u,     40u,    true },
+    
+    // 8 MHz SCB clock.
+    { 400000u,  (uint8_t)(CYDEV_BCLK__HFCLK__HZ / 8000000u),    13u,    7u,     10u,    true },
+    
+    // 16 MHz SCB clock.
+    { 1000000u, (uint8_t)(CYDEV_BCLK__HFCLK__HZ / 16000000u),   9u,     7u,     4u,     false },
+};
+
 
 // === PRIVATE GLOBALS =========================================================
 
@@ -549,13 +762,29 @@ static I2cStatus const G_NoErrorI2cStatus = { 0u };
 /// have not been dynamically allocated and the module has not started.
 static Heap* g_heap = NULL;
 
-/// The current 7-bit slave address. When the slaveIRQ line is asserted, a read
-/// will be performed from this address.
-static uint8_t g_slaveAddress = SlaveAddress_App;
+/// The slave contexts. When the IRQ line of a slave context is asserted, a read
+/// will be performed from its address. Slave context 0 is the slave app by
+/// default; slave context i defaults to the slave app address + i.
+static SlaveContext g_slaves[I2C_SLAVE_COUNT] = { [0] = { .address = SlaveAddress_App } };
+
+/// The configuration of the active I2C bit rate; the top design configures the
+/// slaveI2c component for 100 kHz.
+static BitRateConfig const* g_bitRateConfig = &G_BitRateConfigs[0];
 
 /// App receive state machine variables.
 static CommFsm g_commFsm;
 
+/// Transfer lane scheduling variables.
+static LaneScheduler g_laneScheduler =
+{
+    .weights = { I2C_SLAVE_IRQ_LANE_WEIGHT, I2C_HOST_LANE_WEIGHT },
+#if ENABLE_I2C_STRICT_PRIORITY_LANES
+    .policy = I2cLanePolicy_StrictPriority,
+#else
+    .policy = I2cLanePolicy_WeightedRoundRobin,
+#endif // ENABLE_I2C_STRICT_PRIORITY_LANES
+};
+
 #if ENABLE_I2C_LOCKED_BUS_DETECTION
     
     /// Container for locked-bus related variables.
@@ -563,17 +792,6 @@ static CommFsm g_commFsm;
     
 #endif // ENABLE_I2C_LOCKED_BUS_DETECTION
 
-#if !ENABLE_ALL_CHANGE_TO_RESPONSE
-    
-    /// Flag indicating we're in the response buffer is active for the slave app.
-    static bool g_slaveAppResponseActive = false;
-    
-    /// Flag indicating on receive, if a write needs to be done to switch to the
-    /// response buffer.
-    static bool g_appRxSwitchToResponse = false;
-    
-#endif // !ENABLE_ALL_CHANGE_TO_RESPONSE
-
 /// The receive callback function.
 static I2cRxCallback g_rxCallback = NULL;
 
@@ -597,42 +815,6 @@ static I2cCallsite g_callsite = { 0u };
 
 // === PRIVATE FUNCTIONS =======================================================
 
-/// Generates the transfer queue data to include the I2C address and direction
-/// as the first byte (see I2cXfer union). The transfer dequeue function
-/// will take care of properly pulling out the I2C address, direction, and the
-/// actual data payload to for the transaction. Note that g_pendingQueueXfer
-/// must be set properly before invoking this function.
-/// @param[in]  source      The source buffer.
-/// @param[in]  sourceSize  The number of bytes in the source.
-/// @param[out] target      The target buffer (where the formatted data is
-///                         stored).
-/// @param[in]  targetSize  The number of bytes available in the target.
-/// @return The number of bytes in the target buffer or the number of bytes
-///         to transmit.  If 0, then the source buffer was either invalid or
-///         there's not enough bytes in target buffer to store the formatted
-///         data.
-static uint16_t prepareXferQueueData(uint8_t target[], uint16_t targetSize, uint8_t const source[], uint16_t sourceSize)
-{
-    static uint16_t const MinSourceSize = XferQueueDataOffset_Xfer + 1u;
-    
-    uint16_t size = 0;
-    if ((source != NULL) && (sourceSize >= MinSourceSize) && (target != NULL) && (targetSize > sourceSize))
-    {
-        target[size++] = g_heap->pendingQueueXfer.value;
-        memcpy(&target[size], source, sourceSize);
-        size += sourceSize;
-    }
-    return size;
-}
-
-
-/// Resets the variables associated with the pending transmit enqueue.
-void resetPendingTxEnqueue(void)
-{
-    g_heap->pendingQueueXfer.value = 0;
-}
-
-
 /// Checks if the app needs to switch to the response buffer when an IRQ occurs
 /// indicating data is ready to be read (receive).
 /// @return If the app needs to switch to the response buffer before performing
@@ -642,7 +824,8 @@ static bool switchToAppResponseBuffer(void)
     bool result = true;
     
 #if !ENABLE_ALL_CHANGE_TO_RESPONSE
-    result &= (g_appRxSwitchToResponse || !g_slaveAppResponseActive);
+    SlaveContext const* slave = &g_slaves[g_commFsm.slave];
+    result &= (slave->appRxSwitchToResponse || !slave->appResponseActive);
 #endif // !ENABLE_ALL_CHANGE_TO_RESPONSE
 
     return result;
@@ -656,7 +839,6 @@ static bool switchToAppResponseBuffer(void)
 ///         data payload (additional data to receive).
 static AppRxLengthResult processAppRxLength(uint8_t data[], uint8_t size)
 {
-    static uint8_t const CommandMask = 0x7f;
     static uint8_t const InvalidCommand = 0x00;
     
     AppRxLengthResult result = { { false }, 0u };
@@ -666,14 +848,15 @@ static AppRxLengthResult processAppRxLength(uint8_t data[], uint8_t size)
         if (result.dataPayloadSize >= G_InvalidRxAppPacketLength)
             result.invalidLength = true;
 
-        if ((data[AppRxPacketOffset_Command] & CommandMask) == InvalidCommand)
+        if ((data[AppRxPacketOffset_Command] & G_AppRxCommandMask) == InvalidCommand)
         {
             result.invalidCommand = true;
         #if !ENABLE_ALL_CHANGE_TO_RESPONSE
-            if (!g_appRxSwitchToResponse)
+            SlaveContext* slave = &g_slaves[g_commFsm.slave];
+            if (!slave->appRxSwitchToResponse)
             {
                 result.invalidAppBuffer = true;
-                g_appRxSwitchToResponse = true;
+                slave->appRxSwitchToResponse = true;
             }
         #endif // !ENABLE_ALL_CHANGE_TO_RESPONSE    
             
@@ -685,37 +868,191 @@ static AppRxLengthResult processAppRxLength(uint8_t data[], uint8_t size)
 }
 
 
-/// Checks to see if the slave IRQ pin has been asserted, meaning there's data
-/// ready to be read from the slave device.
-/// @return If the slave IRQ pin is asserted.
-static bool isIrqAsserted(void)
+/// Find the number of bytes of the first read of a slave report. With the
+/// speculative read, the report header is read along with the largest data
+/// payload of the last reports of the command of the last report unless the
+/// read would exceed I2C_SPECULATIVE_READ_MAX_SIZE; otherwise, only the header
+/// is read.
+/// @return The number of bytes to read.
+static uint16_t findRxReadSize(void)
+{
+    uint16_t size = G_AppRxPacketLengthSize;
+#if ENABLE_I2C_SPECULATIVE_READ
+    SpeculativeRead const* speculativeRead = g_heap->speculativeRead;
+    if (speculativeRead != NULL)
+    {
+        uint8_t const* payloadSizes = speculativeRead->payloadSizes[speculativeRead->command];
+        uint8_t payloadSize = 0u;
+        for (uint8_t i = 0; i < SPECULATIVE_READ_HISTORY_SIZE; ++i)
+        {
+            if (payloadSizes[i] > payloadSize)
+                payloadSize = payloadSizes[i];
+        }
+        if ((size + payloadSize) <= I2C_SPECULATIVE_READ_MAX_SIZE)
+            size += payloadSize;
+    }
+#endif // ENABLE_I2C_SPECULATIVE_READ
+    return size;
+}
+
+
+#if ENABLE_I2C_SPECULATIVE_READ
+    
+    /// Record the data payload size of a slave report for the speculative
+    /// read (see findRxReadSize).
+    /// @param[in]  command     The command byte of the report.
+    /// @param[in]  payloadSize The size of the data payload of the report.
+    static void recordRxPayloadSize(uint8_t command, uint8_t payloadSize)
+    {
+        SpeculativeRead* speculativeRead = g_heap->speculativeRead;
+        if (speculativeRead != NULL)
+        {
+            command &= G_AppRxCommandMask;
+            if (command >= SPECULATIVE_READ_COMMAND_COUNT)
+                command = 0u;
+            uint8_t index = speculativeRead->indexes[command];
+            speculativeRead->payloadSizes[command][index] = payloadSize;
+            speculativeRead->indexes[command] = (index + 1u) % SPECULATIVE_READ_HISTORY_SIZE;
+            speculativeRead->command = command;
+        }
+    }
+    
+#endif // ENABLE_I2C_SPECULATIVE_READ
+
+
+/// Checks which slave IRQ pins have been asserted, meaning there's data ready
+/// to be read from the slave devices.
+/// @return The mask of the slave contexts whose IRQ pin is asserted.
+static uint8_t getAssertedIrqMask(void)
+{
+    return (uint8_t)(~COMPONENT(SLAVE_IRQ_PIN, Read)() & SLAVE_IRQ_MASK);
+}
+
+
+/// Finds the next slave context to read from: the slave contexts with a
+/// pending IRQ that's still asserted are serviced round-robin, starting after
+/// the slave context read last, so a slave that reports continuously can't
+/// starve the others.
+/// @return The slave context; I2C_SLAVE_COUNT if no slave IRQ is pending.
+static uint8_t findPendingSlave(void)
 {
-    return (COMPONENT(SLAVE_IRQ_PIN, Read)() == 0);
+    uint8_t pendingMask = g_commFsm.rxPendingMask & getAssertedIrqMask();
+    uint8_t slave = g_commFsm.slave;
+    for (uint8_t i = 0; (pendingMask > 0) && (i < I2C_SLAVE_COUNT); ++i)
+    {
+        slave = ((slave + 1u) < I2C_SLAVE_COUNT) ? (slave + 1u) : (0u);
+        if ((pendingMask & (1u << slave)) > 0)
+            return slave;
+    }
+    return I2C_SLAVE_COUNT;
+}
+
+
+/// Finds the slave context of a slave address.
+/// @param[in]  address The 7-bit I2C address.
+/// @return The slave context; NULL if no slave context has the address.
+static SlaveContext* findSlaveContext(uint8_t address)
+{
+    for (uint8_t i = 0; i < I2C_SLAVE_COUNT; ++i)
+    {
+        if (g_slaves[i].address == address)
+            return &g_slaves[i];
+    }
+    return NULL;
 }
 
 
 /// Calculates how much to extend a timeout based on having to perform some
-/// additional I2C transactions. This function assumes that the SCL is running
-/// at approximately 100 kHz (bit-rate).
+/// additional I2C transactions at the active bit rate (see i2c_setBitRate).
 /// Note that this is an approximation because we perform the calculation in
-/// microseconds but we return the value in milliseconds. Instead of using a
-/// 10^3 (1000) conversion factor, we use a 2^10 (1024) conversion factor and
-/// round up with an adjustment.
+/// 1/4 microseconds but we return the value in milliseconds. Instead of using
+/// a 4 * 10^3 (4000) conversion factor, we use a 2^12 (4096) conversion factor
+/// and round up with an adjustment.
 /// @param[in]  transactionSize The size in bytes of the additional transaction.
 /// @return The additional time to add to the timeout in milliseconds.
 static uint32_t findExtendedTimeoutMs(uint16_t transactionSize)
 {
     static uint32_t const WordSize = 9u;
-    static uint32_t const PeriodUs = 10u;
-    static uint32_t const Shift = 10u;
+    static uint32_t const Shift = 12u;
     static uint32_t const Adjustment = 1u;
     
-    uint32_t extendedTimeoutMs = transactionSize * WordSize * PeriodUs;
+    uint32_t extendedTimeoutMs = transactionSize * WordSize * g_bitRateConfig->periodQuarterUs;
     extendedTimeoutMs = (extendedTimeoutMs >> Shift) + Adjustment;
     return extendedTimeoutMs;
 }
 
 
+/// Finds the configuration of an I2C bit rate.
+/// @param[in]  bitRate The bit rate in bits per second.
+/// @return The configuration of the bit rate; NULL if the bit rate isn't
+///         supported.
+static BitRateConfig const* findBitRateConfig(uint32_t bitRate)
+{
+    for (uint8_t i = 0; i < (sizeof(G_BitRateConfigs) / sizeof(G_BitRateConfigs[0])); ++i)
+    {
+        if (G_BitRateConfigs[i].bitRate == bitRate)
+            return &G_BitRateConfigs[i];
+    }
+    return NULL;
+}
+
+
+/// Writes the SCL oversampling and the input filters of the active bit rate to
+/// the slaveI2c SCB registers. The component's Init function writes the values
+/// of the top design so this must follow it. The SCB must be disabled.
+static void writeBitRateRegisters(void)
+{
+    static uint32_t const OversamplingMask = COMPONENT(SLAVE_I2C, I2C_CTRL_HIGH_PHASE_OVS_MASK) | COMPONENT(SLAVE_I2C, I2C_CTRL_LOW_PHASE_OVS_MASK);
+    static uint32_t const AnalogFilterMask = COMPONENT(SLAVE_I2C, I2C_CFG_SDA_IN_FILT_SEL) | COMPONENT(SLAVE_I2C, I2C_CFG_SCL_IN_FILT_SEL);
+    
+    uint32_t ctrl = COMPONENT(SLAVE_I2C, I2C_CTRL_REG) & ~OversamplingMask;
+    ctrl |= (uint32_t)(g_bitRateConfig->lowPhaseOversampling - 1u) << COMPONENT(SLAVE_I2C, I2C_CTRL_LOW_PHASE_OVS_POS);
+    ctrl |= (uint32_t)(g_bitRateConfig->highPhaseOversampling - 1u);
+    COMPONENT(SLAVE_I2C, I2C_CTRL_REG) = ctrl;
+    
+    if (g_bitRateConfig->analogFilter)
+    {
+        COMPONENT(SLAVE_I2C, I2C_CFG_REG) |= AnalogFilterMask;
+        COMPONENT(SLAVE_I2C, RX_CTRL_REG) &= ~COMPONENT(SLAVE_I2C, RX_CTRL_MEDIAN);
+    }
+    else
+    {
+        COMPONENT(SLAVE_I2C, I2C_CFG_REG) &= ~AnalogFilterMask;
+        COMPONENT(SLAVE_I2C, RX_CTRL_REG) |= COMPONENT(SLAVE_I2C, RX_CTRL_MEDIAN);
+    }
+}
+
+
+/// Switches the slaveI2c SCB to an I2C bit rate: the SCB clock divider, the
+/// SCL oversampling and the input filters. The bus must be idle.
+/// @param[in]  config  The configuration of the bit rate.
+static void applyBitRateConfig(BitRateConfig const* config)
+{
+    COMPONENT(SLAVE_I2C, Stop)();
+    COMPONENT(SLAVE_I2C, SCBCLK_Stop)();
+    COMPONENT(SLAVE_I2C, SCBCLK_SetFractionalDividerRegister)((uint16_t)(config->clockDivider - 1u), 0u);
+    COMPONENT(SLAVE_I2C, SCBCLK_Start)();
+    g_bitRateConfig = config;
+    writeBitRateRegisters();
+    COMPONENT(SLAVE_I2C, Enable)();
+}
+
+
+/// Restarts the slaveI2c SCB; aborts the transfer in progress and releases the
+/// bus. The active bit rate is kept.
+static void restartSlaveI2c(void)
+{
+    COMPONENT(SLAVE_I2C, Stop)();
+    // Try to clear the status register.
+    COMPONENT(SLAVE_I2C, I2C_STATUS_REG) = 0;
+    // Init is called instead of Start b/c of the initialization flag in the
+    // component has already been set.
+    COMPONENT(SLAVE_I2C, Init)();
+    writeBitRateRegisters();
+    COMPONENT(SLAVE_I2C, Enable)();
+}
+
+
 /// Check and update the driver status. No error processing or handling is done
 /// in this function; the caller must perform approriate error handling.
 /// @return The driver status mask.
@@ -732,10 +1069,12 @@ static mstatus_t checkDriverStatus(void)
 /// will be invoked.
 /// @param[in]  status      Status indicating if an error occured. See the
 ///                         definition of the I2cStatus union.
-static void processError(I2cStatus status)
+/// @param[in]  tag         The tag of the transfer the error applies to; 0 if
+///                         it doesn't apply to a tagged transfer.
+static void processError(I2cStatus status, uint8_t tag)
 {
     if (i2c_errorOccurred(status) && (g_errorCallback != NULL))
-        g_errorCallback(status, g_callsite.value);
+        g_errorCallback(status, g_callsite.value, tag);
 }
 
 
@@ -771,11 +1110,13 @@ static bool isBusReady(I2cStatus* status)
     g_lastDriverStatus = (uint16_t)COMPONENT(SLAVE_I2C, I2CMasterStatus)();
     COMPONENT(SLAVE_I2C, I2CMasterClearStatus)();
     bool ready = (g_lastDriverStatus & BusyMask) == 0;
+    if (ready)
+        g_commFsm.xferInProgress = false;
     I2cStatus localStatus = processPreviousTranferErrors(g_lastDriverStatus);
     if (i2c_errorOccurred(localStatus))
     {
         g_callsite.isBusReady = true;
-        processError(localStatus);
+        processError(localStatus, g_commFsm.tag);
     }
     if (status != NULL)
         *status = localStatus;
@@ -855,6 +1196,30 @@ I2cStatus updateDriverStatus(mreturn_t result)
 }
 
 
+/// Flags the start of an I2C transfer so its completion can be awaited without
+/// polling the driver (see COMPONENT(SLAVE_I2C, I2C_ISR_ExitCallback)). Call
+/// before starting the transfer.
+static void startXfer(void)
+{
+    g_commFsm.xferDone = false;
+    g_commFsm.xferInProgress = false;
+}
+
+
+/// Flags the I2C transfer as in progress once it started successfully and arms
+/// the alarm that bounds it.
+/// @param[in]  status  The status of the start of the transfer.
+/// @param[in]  size    The number of bytes transferred.
+static void startedXfer(I2cStatus status, uint16_t size)
+{
+    if (!i2c_errorOccurred(status))
+    {
+        g_commFsm.xferInProgress = true;
+        alarm_arm(&g_commFsm.xferAlarm, findExtendedTimeoutMs(size) + G_XferTimeoutMarginMs, AlarmType_ContinuousNotification);
+    }
+}
+
+
 /// Read data from a slave device on the I2C bus.
 /// @param[in]  address
 /// @param[out] data    Data buffer to copy the read data to.
@@ -863,10 +1228,12 @@ I2cStatus updateDriverStatus(mreturn_t result)
 /// @param[in]  mode    TransferMode settings.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
-static I2cStatus read(uint8_t address, uint8_t data[], uint16_t size)
+static I2cStatus read(uint8_t address, uint8_t data[], uint16_t size, uint8_t mode)
 {
-    g_lastDriverReturnValue = COMPONENT(SLAVE_I2C, I2CMasterReadBuf)(address, data, size, G_DefaultTransferMode);
+    startXfer();
+    g_lastDriverReturnValue = COMPONENT(SLAVE_I2C, I2CMasterReadBuf)(address, data, size, mode);
     I2cStatus status = updateDriverStatus(g_lastDriverReturnValue);
+    startedXfer(status, size);
     if (i2c_errorOccurred(status))
         g_callsite.lowLevelCall = 1u;
     return status;
@@ -881,20 +1248,23 @@ static I2cStatus read(uint8_t address, uint8_t data[], uint16_t size)
 /// @param[in]  mode    TransferMode settings.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
-static I2cStatus write(uint8_t address, uint8_t const data[], uint16_t size)
+static I2cStatus write(uint8_t address, uint8_t const data[], uint16_t size, uint8_t mode)
 {
     I2cStatus status;
     if ((data != NULL) && (size > 0))
     {
         // Note: typecast of data to (uint8_t*) to remove the const typing in
         // order to utilize the low-level driver function.
-        g_lastDriverReturnValue = (uint16_t)COMPONENT(SLAVE_I2C, I2CMasterWriteBuf)(address, (uint8_t*)data, size, G_DefaultTransferMode);
+        startXfer();
+        g_lastDriverReturnValue = (uint16_t)COMPONENT(SLAVE_I2C, I2CMasterWriteBuf)(address, (uint8_t*)data, size, mode);
         status = updateDriverStatus(g_lastDriverReturnValue);
+        startedXfer(status, size);
     #if !ENABLE_ALL_CHANGE_TO_RESPONSE
         if (!i2c_errorOccurred(status))
         {
-            if (address == g_slaveAddress)
-                g_slaveAppResponseActive = (data[XferQueueDataOffset_Xfer] >= AppBufferOffset_Response);
+            SlaveContext* slave = findSlaveContext(address);
+            if (slave != NULL)
+                slave->appResponseActive = (data[XferQueueDataOffset_Xfer] >= AppBufferOffset_Response);
         }
     #endif // !ENABLE_ALL_CHANGE_TO_RESPONSE
     }
@@ -906,6 +1276,41 @@ static I2cStatus write(uint8_t address, uint8_t const data[], uint16_t size)
 }
 
 
+/// Send a STOP to release the bus held by a write without a STOP (see
+/// G_WriteReadWriteMode).
+/// @return Status indicating if an error occured. See the definition of the
+///         I2cStatus union.
+static I2cStatus sendStop(void)
+{
+    g_lastDriverReturnValue = COMPONENT(SLAVE_I2C, I2CMasterSendStop)(G_DefaultSendStopTimeoutMs);
+    I2cStatus status = updateDriverStatus(g_lastDriverReturnValue);
+    if (i2c_errorOccurred(status))
+        g_callsite.lowLevelCall = 3u;
+    return status;
+}
+
+
+/// Ends the I2C transfer in progress so it can be dropped: waits for its
+/// completion (bounded by the transfer alarm) and sends a STOP if a write
+/// without a STOP holds the bus. A transfer that doesn't complete in time is
+/// aborted by restarting the slaveI2c SCB. Note that this is a blocking
+/// function.
+static void endXfer(void)
+{
+    while (!g_commFsm.xferDone && g_commFsm.xferAlarm.armed && !alarm_hasElapsed(&g_commFsm.xferAlarm))
+    {
+        // Wait for the I2C ISR to flag the completion.
+    }
+    
+    mstatus_t driverStatus = checkDriverStatus();
+    if ((driverStatus & COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_INP)) > 0)
+        restartSlaveI2c();
+    else if ((driverStatus & COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_HALT)) > 0)
+        sendStop();
+    g_commFsm.xferInProgress = false;
+}
+
+
 #if ENABLE_I2C_LOCKED_BUS_DETECTION
     
     /// Attempts to recover from the bus lock error in the case that the I2C bus
@@ -930,13 +1335,7 @@ static I2cStatus write(uint8_t address, uint8_t const data[], uint16_t size)
             
             #if true
             // First attempt to restart the I2C component.
-            COMPONENT(SLAVE_I2C, Stop)();
-            // Try to clear the status register.
-            COMPONENT(SLAVE_I2C, I2C_STATUS_REG) = 0;
-            // Init is called instead of Start b/c of the initialization flag in the
-            // component has already been set.
-            COMPONENT(SLAVE_I2C, Init)();
-            COMPONENT(SLAVE_I2C, Enable)();
+            restartSlaveI2c();
             status = i2c_ackApp(0);
             #endif
             g_lockedBus.recoveryAttempts++;
@@ -950,13 +1349,13 @@ static I2cStatus write(uint8_t address, uint8_t const data[], uint16_t size)
 #endif // ENABLE_I2C_LOCKED_BUS_DETECTION
 
 
-/// Create and sends the packet to the slave to instruct it to reset/clear the
-/// IRQ line.
+/// Create and sends the packet to the slave being read to instruct it to
+/// reset/clear the IRQ line.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
 static I2cStatus resetIrq(void)
 {
-    return write(g_slaveAddress, G_ClearIrqMessage, G_ClearIrqSize);
+    return write(g_commFsm.address, G_ClearIrqMessage, G_ClearIrqSize, G_DefaultTransferMode);
 }
 
 
@@ -966,18 +1365,104 @@ static I2cStatus resetIrq(void)
 ///         I2cStatus union.
 static I2cStatus changeSlaveAppToResponseBuffer(void)
 {
-    return write(g_slaveAddress, G_ClearIrqMessage, G_ResponseBufferSize);
+    return write(g_commFsm.address, G_ClearIrqMessage, G_ResponseBufferSize, G_DefaultTransferMode);
     // Note: The write function will change the flag to reflect if the app was
     // switched to the response buffer.
 }
 
 
+/// Clears the pending IRQ of a slave context.
+/// @param[in]  slave   The slave context.
+static void clearRxPending(uint8_t slave)
+{
+    // The slave IRQ ISR sets the bits of the other slave contexts.
+    COMPONENT(SLAVE_IRQ, Disable)();
+    g_commFsm.rxPendingMask &= (uint8_t)~(1u << slave);
+    COMPONENT(SLAVE_IRQ, Enable)();
+}
+
+
+/// Pick the next lane to service based on the scheduling policy and update the
+/// lane counters. If the slave IRQ lane is picked, the slave context to read is
+/// picked as well (see findPendingSlave).
+/// @param[in]  hostPending Flag indicating if the host lane has a pending
+///                         transfer.
+/// @return The next state of the communication state machine: the start of
+///         the slave IRQ read, the start of the next host transfer, or
+///         waiting if no lane has a pending transaction.
+static CommState scheduleLanes(bool hostPending)
+{
+    uint8_t slave = findPendingSlave();
+    bool irqPending = (slave < I2C_SLAVE_COUNT);
+    I2cLane lane;
+    if (irqPending && hostPending)
+    {
+        if (g_laneScheduler.policy == I2cLanePolicy_StrictPriority)
+            lane = I2cLane_SlaveIrq;
+        else if (g_laneScheduler.turns > 0)
+            lane = (I2cLane)g_laneScheduler.lane;
+        else
+            lane = (g_laneScheduler.lane == I2cLane_SlaveIrq) ? I2cLane_Host : I2cLane_SlaveIrq;
+        g_laneScheduler.stats[(lane == I2cLane_SlaveIrq) ? I2cLane_Host : I2cLane_SlaveIrq].deferred++;
+    }
+    else if (irqPending)
+        lane = I2cLane_SlaveIrq;
+    else if (hostPending)
+        lane = I2cLane_Host;
+    else
+        return CommState_Waiting;
+    
+    if (lane != g_laneScheduler.lane)
+    {
+        g_laneScheduler.lane = lane;
+        g_laneScheduler.turns = g_laneScheduler.weights[lane];
+    }
+    if (g_laneScheduler.turns > 0)
+        g_laneScheduler.turns--;
+    g_laneScheduler.stats[lane].serviced++;
+    if (lane == I2cLane_SlaveIrq)
+    {
+        g_commFsm.slave = slave;
+        return CommState_RxPending;
+    }
+    return CommState_XferDequeueAndAct;
+}
+
+
+/// Release the transfers of the current batch that were acted on from the
+/// transfer queue; the transfers not acted on are peaked again with the next
+/// batch.
+static void releaseXfers(void)
+{
+    queue_dequeueBatch(g_heap->queue, g_commFsm.xferCount);
+    g_commFsm.xferCount = 0u;
+    g_commFsm.xferSpanCount = 0u;
+}
+
+
+/// Find the next state of the communication state machine after a transfer
+/// from the transfer queue completes. If all the transfers of the batch have
+/// completed, they are released from the transfer queue.
+/// @return The next state of the communication state machine.
+static CommState findXferCompleteState(void)
+{
+    g_commFsm.tag = 0u;
+    if (g_commFsm.xferCount >= g_commFsm.xferSpanCount)
+        releaseXfers();
+    return scheduleLanes((g_commFsm.xferCount < g_commFsm.xferSpanCount) || !queue_isEmpty(g_heap->queue));
+}
+
+
 /// Communications finite state machine (FSM) to process any receive and
-/// transmit transactions pertaining to the I2C bus.
+/// transmit transactions pertaining to the I2C bus. The state machine doesn't
+/// wait for the I2C transfers: it returns once a transfer is started and
+/// resumes on a later call once the I2C ISR flagged the completion, so the main
+/// loop is free in the meantime. A transfer that doesn't complete in time (see
+/// G_XferTimeoutMarginMs) is dropped with a timeout error.
 /// @param[in]  timeoutMs   The amount of time the process can occur before it
-///                         times out and must finish. If 0, then there's no
-///                         timeout and the function blocks until all pending
-///                         actions are completed.
+///                         must return; the state is kept for the next call. If
+///                         0, then there's no timeout and the function blocks
+///                         until all pending actions are completed.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
 static I2cStatus processCommFsm(uint32_t timeoutMs)
@@ -990,31 +1475,48 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
     
     // Determine the next state when waiting.
     if (g_commFsm.state == CommState_Waiting)
-    {
-        if (g_commFsm.rxPending && isIrqAsserted())
-            g_commFsm.state = CommState_RxPending;
-        else if (!queue_isEmpty(g_heap->queue))
-            g_commFsm.state = CommState_XferDequeueAndAct;
-    }
+        g_commFsm.state = scheduleLanes(!queue_isEmpty(g_heap->queue));
     
     while (g_commFsm.state != CommState_Waiting)
     {
-        if (g_commFsm.timeoutAlarm.armed && alarm_hasElapsed(&g_commFsm.timeoutAlarm))
+        // Wait for the completion of the transfer in progress; yield unless
+        // blocking. The driver is only checked if the completion wasn't
+        // flagged in time; the write of a write-read transfer completes with
+        // the bus held so its state checks the driver itself.
+        if (g_commFsm.xferInProgress && !g_commFsm.xferDone)
         {
-            status.timedOut = true;
-            g_commFsm.state = CommState_Waiting;
-            break;
+            if (!alarm_hasElapsed(&g_commFsm.xferAlarm))
+            {
+                if (timeoutMs > 0)
+                    break;
+                continue;
+            }
+            if ((g_commFsm.state != CommState_XferWriteReadRestart) && !isBusReady(&status))
+            {
+                g_callsite.subValue = 0u;
+                g_callsite.subCall = 11u;
+                status.timedOut = true;
+                g_commFsm.xferInProgress = false;
+                g_commFsm.state = CommState_Waiting;
+                releaseXfers();
+                break;
+            }
         }
         
+        if (g_commFsm.timeoutAlarm.armed && alarm_hasElapsed(&g_commFsm.timeoutAlarm))
+            break;
+        
         switch (g_commFsm.state)
         {
             case CommState_RxPending:
             {
                 g_callsite.subValue = 0u;
                 g_callsite.subCall = 1u;
-                g_commFsm.rxPending = false;
+                clearRxPending(g_commFsm.slave);
                 g_commFsm.rxSwitchToResponseBuffer = false;
-                g_commFsm.pendingRxSize = G_AppRxPacketLengthSize;
+                g_commFsm.pendingRxSize = findRxReadSize();
+                g_commFsm.tag = 0u;
+                g_commFsm.address = g_slaves[g_commFsm.slave].address;
                 if (switchToAppResponseBuffer())
                 {
                     g_commFsm.rxSwitchToResponseBuffer = true;
@@ -1046,7 +1548,7 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 g_callsite.subCall = 3u;
                 if (isBusReady(&status))
                 {
-                    status = read(g_slaveAddress, g_heap->rxBuffer, g_commFsm.pendingRxSize);
+                    status = read(g_commFsm.address, g_heap->rxBuffer, g_commFsm.pendingRxSize, G_DefaultTransferMode);
                     if (!i2c_errorOccurred(status))
                         g_commFsm.state = CommState_RxProcessLength;
                     else
@@ -1064,14 +1566,17 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                     AppRxLengthResult lengthResult = processAppRxLength(g_heap->rxBuffer, g_commFsm.pendingRxSize);
                     if (!lengthResult.invalid)
                     {
-                        g_commFsm.pendingRxSize += lengthResult.dataPayloadSize;
-                        if (lengthResult.dataPayloadSize <= 0)
+                        // The report is only read again if the first read
+                        // didn't cover all of it.
+                        uint16_t packetSize = G_AppRxPacketLengthSize + lengthResult.dataPayloadSize;
+                        if (packetSize <= g_commFsm.pendingRxSize)
                             g_commFsm.state = CommState_RxProcessExtraData;
                         else
-                        {
-                            alarm_snooze(&g_commFsm.timeoutAlarm, findExtendedTimeoutMs(g_commFsm.pendingRxSize));
                             g_commFsm.state = CommState_RxReadExtraData;
-                        }
+                        g_commFsm.pendingRxSize = packetSize;
+                    #if ENABLE_I2C_SPECULATIVE_READ
+                        recordRxPayloadSize(g_heap->rxBuffer[AppRxPacketOffset_Command], lengthResult.dataPayloadSize);
+                    #endif // ENABLE_I2C_SPECULATIVE_READ
                     }
                     else if (lengthResult.invalidParameters)
                     {
@@ -1121,7 +1626,7 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 g_callsite.subCall = 5u;
                 if (isBusReady(&status))
                 {
-                    status = read(g_slaveAddress, g_heap->rxBuffer, g_commFsm.pendingRxSize);
+                    status = read(g_commFsm.address, g_heap->rxBuffer, g_commFsm.pendingRxSize, G_DefaultTransferMode);
                     if (!i2c_errorOccurred(status))
                         g_commFsm.state = CommState_RxProcessExtraData;
                     else
@@ -1137,7 +1642,7 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 if (isBusReady(&status))
                 {
                     if (g_rxCallback != NULL)
-                        g_rxCallback(g_heap->rxBuffer, g_commFsm.pendingRxSize);
+                        g_rxCallback(g_heap->rxBuffer, g_commFsm.pendingRxSize, g_commFsm.tag, g_commFsm.address, true);
                     g_commFsm.state = CommState_RxClearIrq;
                 }
                 break;
@@ -1170,34 +1675,55 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 g_callsite.subCall = 9u;
                 if (isBusReady(&status))
                 {
-                    uint8_t* data;
-                    uint16_t size = queue_dequeue(g_heap->queue, &data);
-                    if (size > XferQueueDataOffset_Data)
+                    if (g_commFsm.xferCount >= g_commFsm.xferSpanCount)
+                    {
+                        releaseXfers();
+                        g_commFsm.xferSpanCount = queue_peakBatch(g_heap->queue, g_commFsm.xferSpans, XFER_BATCH_SIZE);
+                    }
+                    uint8_t* data = NULL;
+                    uint16_t size = 0u;
+                    if (g_commFsm.xferCount < g_commFsm.xferSpanCount)
                     {
+                        data = g_commFsm.xferSpans[g_commFsm.xferCount].data;
+                        size = g_commFsm.xferSpans[g_commFsm.xferCount].size;
+                        g_commFsm.xferCount++;
+                    }
+                    
+                    if (data == NULL)
+                        g_commFsm.state = CommState_Waiting;
+                    else if (size > XferQueueDataOffset_Data)
+                    {
+                        CommState nextState = CommState_XferTxCheckComplete;
                         g_commFsm.pendingRxSize = 0u;
+                        g_commFsm.tag = data[XferQueueDataOffset_Tag];
                         I2cXfer xfer = { data[XferQueueDataOffset_Xfer] };
+                        g_commFsm.address = xfer.address;
                         if (xfer.direction == I2cDirection_Write)
                         {
-                            // Exclude the I2cXfer byte in the transmit size.
-                            size--;
-                            alarm_snooze(&g_commFsm.timeoutAlarm, findExtendedTimeoutMs(size));
-                            status = write(xfer.address, &data[XferQueueDataOffset_Data], size);
+                            // Exclude the I2cXfer and tag bytes in the
+                            // transmit size.
+                            size -= XferQueueDataOffset_Data;
+                            status = write(xfer.address, &data[XferQueueDataOffset_Data], size, G_DefaultTransferMode);
                         }
                         else if (xfer.direction == I2cDirection_Read)
                         {
                             g_commFsm.pendingRxSize = data[XferQueueDataOffset_Data];
-                            alarm_snooze(&g_commFsm.timeoutAlarm, findExtendedTimeoutMs(g_commFsm.pendingRxSize));
-                            status = read(xfer.address, g_heap->rxBuffer, data[XferQueueDataOffset_Data]);
-                        }
-                        if (!i2c_errorOccurred(status))
-                        {
-                            // If pendingRxSize > 0, then a read is occurring,
-                            // otherwise a write is occurring.
-                            if (g_commFsm.pendingRxSize > 0)
-                                g_commFsm.state = CommState_XferRxCheckComplete;
+                            if (size > XferQueueDataOffset_WriteReadData)
+                            {
+                                // Write-read: the write holds the bus and
+                                // the read follows with a repeated START.
+                                size -= XferQueueDataOffset_WriteReadData;
+                                status = write(xfer.address, &data[XferQueueDataOffset_WriteReadData], size, G_WriteReadWriteMode);
+                                nextState = CommState_XferWriteReadRestart;
+                            }
                             else
-                                g_commFsm.state = CommState_XferTxCheckComplete;
+                            {
+                                status = read(xfer.address, g_heap->rxBuffer, g_commFsm.pendingRxSize, G_DefaultTransferMode);
+                                nextState = CommState_XferRxCheckComplete;
+                            }
                         }
+                        if (!i2c_errorOccurred(status))
+                            g_commFsm.state = nextState;
                         else
                             g_commFsm.state = CommState_Waiting;
                     }
@@ -1210,6 +1736,38 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 break;
             }
             
+            case CommState_XferWriteReadRestart:
+            {
+                g_callsite.subValue = 0u;
+                g_callsite.subCall = 12u;
+                mstatus_t driverStatus = checkDriverStatus();
+                if ((driverStatus & COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_INP)) > 0)
+                {
+                    // The completion of the write wasn't flagged in time;
+                    // abort it so it doesn't hold the bus. The transfer is
+                    // released with the batch in the waiting state.
+                    restartSlaveI2c();
+                    status.timedOut = true;
+                    g_commFsm.xferInProgress = false;
+                    g_commFsm.state = CommState_Waiting;
+                    break;
+                }
+                
+                status = processPreviousTranferErrors(driverStatus);
+                if (!i2c_errorOccurred(status))
+                    status = read(g_commFsm.address, g_heap->rxBuffer, g_commFsm.pendingRxSize, G_WriteReadReadMode);
+                if (!i2c_errorOccurred(status))
+                    g_commFsm.state = CommState_XferRxCheckComplete;
+                else
+                {
+                    // Release the bus if the write still holds it.
+                    if ((driverStatus & COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_HALT)) > 0)
+                        sendStop();
+                    g_commFsm.state = CommState_Waiting;
+                }
+                break;
+            }
+            
             case CommState_XferRxCheckComplete:
             {
                 g_callsite.subValue = 0u;
@@ -1217,8 +1775,8 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 if (isBusReady(&status))
                 {
                     if (g_rxCallback != NULL)
-                        g_rxCallback(g_heap->rxBuffer, g_commFsm.pendingRxSize);
-                    g_commFsm.state = CommState_Waiting;
+                        g_rxCallback(g_heap->rxBuffer, g_commFsm.pendingRxSize, g_commFsm.tag, g_commFsm.address, false);
+                    g_commFsm.state = findXferCompleteState();
                 }
                 break;
             }
@@ -1228,7 +1786,7 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
                 g_callsite.subValue = 0u;
                 g_callsite.subCall = 10u;
                 if (isBusReady(&status))
-                    g_commFsm.state = CommState_Waiting;
+                    g_commFsm.state = findXferCompleteState();
                 break;
             }
             
@@ -1244,10 +1802,53 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
         
         // The state machine can only be in the waiting state in the while loop
         // if it transitioned to it because the receive is complete. If this
-        // occurs, disarm the alarm.
+        // occurs, disarm the alarm and release the completed transfers.
         if (g_commFsm.state == CommState_Waiting)
+        {
             alarm_disarm(&g_commFsm.timeoutAlarm);
+            releaseXfers();
+        }
+    }
+    return status;
+}
+
+
+/// Enqueue a transaction into the transfer queue. The transfer queue element
+/// is built in place: the I2cXfer byte (address and direction) and the tag are
+/// followed by the number of bytes to read (reads only) and the data to write
+/// (see XferQueueDataOffset).
+/// @param[in]  address     The 7-bit I2C address.
+/// @param[in]  direction   The direction of the transaction.
+/// @param[in]  tag         The tag passed to the callbacks for the transfer.
+/// @param[in]  readSize    The number of bytes to read; ignored for a write.
+/// @param[in]  data        The data to write; for a read, the data written
+///                         before the read with a repeated START (NULL if
+///                         none).
+/// @param[in]  size        The number of bytes to write.
+/// @return Status indicating if an error occured. See the definition of the
+///         I2cStatus union.
+static I2cStatus xferEnqueue(uint8_t address, I2cDirection direction, uint8_t tag, uint8_t readSize, uint8_t const data[], uint16_t size)
+{
+    I2cStatus status = G_NoErrorI2cStatus;
+    uint16_t offset = (direction == I2cDirection_Read) ? (XferQueueDataOffset_WriteReadData) : (XferQueueDataOffset_Data);
+    uint16_t elementSize = offset + size;
+    uint8_t* element = queue_reserve(g_heap->queue, elementSize);
+    if (element != NULL)
+    {
+        I2cXfer xfer = { 0u };
+        xfer.address = address;
+        xfer.direction = direction;
+        element[XferQueueDataOffset_Xfer] = xfer.value;
+        element[XferQueueDataOffset_Tag] = tag;
+        if (direction == I2cDirection_Read)
+            element[XferQueueDataOffset_Data] = readSize;
+        if (size > 0)
+            memcpy(&element[offset], data, size);
+        if (!queue_commit(g_heap->queue, elementSize))
+            status.queueFull = true;
     }
+    else
+        status.queueFull = true;
     return status;
 }
 
@@ -1255,26 +1856,16 @@ static I2cStatus processCommFsm(uint32_t timeoutMs)
 /// Enqueue a read transaction into the transfer queue.
 /// @param[in]  address The 7-bit I2C address.
 /// @param[in]  size    The number of bytes to read.
+/// @param[in]  tag     The tag passed to the callbacks for the transfer.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
-I2cStatus xferEnqueueRead(uint8_t address, uint16_t size)
+static I2cStatus xferEnqueueRead(uint8_t address, uint16_t size, uint8_t tag)
 {
     I2cStatus status = G_NoErrorI2cStatus;
     if (g_heap != NULL)
     {
         if ((size > 0) && (size <= UINT8_MAX))
-        {
-            if (!queue_isFull(g_heap->queue))
-            {
-                uint8_t readSize = size;
-                g_heap->pendingQueueXfer.address = address;
-                g_heap->pendingQueueXfer.direction = I2cDirection_Read;
-                if (!queue_enqueue(g_heap->queue, &readSize, sizeof(readSize)))
-                    status.queueFull = true;
-            }
-            else
-                status.queueFull = true;
-        }
+            status = xferEnqueue(address, I2cDirection_Read, tag, size, NULL, 0u);
         else
             status.invalidInputParameters = true;
     }
@@ -1288,25 +1879,41 @@ I2cStatus xferEnqueueRead(uint8_t address, uint16_t size)
 /// @param[in]  address The 7-bit I2C address.
 /// @param[in]  data    The data buffer to that contains the data to write.
 /// @param[in]  size    The number of bytes to write.
+/// @param[in]  tag     The tag passed to the callbacks for the transfer.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
-I2cStatus xferEnqueueWrite(uint8_t address, uint8_t const data[], uint16_t size)
+static I2cStatus xferEnqueueWrite(uint8_t address, uint8_t const data[], uint16_t size, uint8_t tag)
 {
     I2cStatus status = G_NoErrorI2cStatus;
     if (g_heap != NULL)
     {
         if ((data != NULL) && (size > 0))
-        {
-            if (!queue_isFull(g_heap->queue))
-            {
-                g_heap->pendingQueueXfer.address = address;
-                g_heap->pendingQueueXfer.direction = I2cDirection_Write;
-                if (!queue_enqueue(g_heap->queue, data, size))
-                    status.queueFull = true;
-            }
-            else
-                status.queueFull = true;
-        }
+            status = xferEnqueue(address, I2cDirection_Write, tag, 0u, data, size);
+        else
+            status.invalidInputParameters = true;
+    }
+    else
+        status.deactivated = true;
+    return status;
+}
+
+
+/// Enqueue a write-read transaction into the transfer queue: the data is
+/// written without a STOP and the read follows with a repeated START.
+/// @param[in]  address     The 7-bit I2C address.
+/// @param[in]  data        The data buffer that contains the data to write.
+/// @param[in]  size        The number of bytes to write.
+/// @param[in]  readSize    The number of bytes to read.
+/// @param[in]  tag         The tag passed to the callbacks for the transfer.
+/// @return Status indicating if an error occured. See the definition of the
+///         I2cStatus union.
+static I2cStatus xferEnqueueWriteRead(uint8_t address, uint8_t const data[], uint16_t size, uint16_t readSize, uint8_t tag)
+{
+    I2cStatus status = G_NoErrorI2cStatus;
+    if (g_heap != NULL)
+    {
+        if ((data != NULL) && (size > 0) && (readSize > 0) && (readSize <= UINT8_MAX))
+            status = xferEnqueue(address, I2cDirection_Read, tag, readSize, data, size);
         else
             status.invalidInputParameters = true;
     }
@@ -1335,6 +1942,8 @@ bool isLastTransferComplete(I2cStatus* status)
             status->driverError = true;
         complete = true;
     }
+    if (complete)
+        g_commFsm.xferInProgress = false;
     return complete;
 }
 
@@ -1345,16 +1954,19 @@ bool isLastTransferComplete(I2cStatus* status)
 /// @param[in]  address The 7-bit I2C address.
 /// @param[in]  timeout The amount of time in milliseconds the function can wait
 ///                     for the I2C bus to free up before timing out. If 0, then
-///                     the function will wait for a default timeout period.
+///                     the function will wait for the duration of the ACK
+///                     transaction at the active bit rate plus a margin.
 /// @return Status indicating if an error occured. See the definition of the
 ///         I2cStatus union.
 I2cStatus ack(uint8_t address, uint32_t timeoutMs)
 {
-    static uint32_t const DefaultAckTimeout = 2u;
+    // The address byte and the dummy byte.
+    static uint16_t const AckTransactionSize = 2u;
+    static uint32_t const AckTimeoutMarginMs = 1u;
     
     Alarm alarm;
     if (timeoutMs <= 0)
-        timeoutMs = DefaultAckTimeout;
+        timeoutMs = findExtendedTimeoutMs(AckTransactionSize) + AckTimeoutMarginMs;
     alarm_arm(&alarm, timeoutMs, AlarmType_ContinuousNotification);
     
     bool ackSent = false;
@@ -1375,7 +1987,7 @@ I2cStatus ack(uint8_t address, uint32_t timeoutMs)
             uint8_t dummy;
             if (isBusReady(NULL))
             {
-                status = read(address, &dummy, sizeof(dummy));
+                status = read(address, &dummy, sizeof(dummy), G_DefaultTransferMode);
                 if (i2c_errorOccurred(status))
                     done = true;
                 else
@@ -1393,26 +2005,41 @@ I2cStatus ack(uint8_t address, uint32_t timeoutMs)
 
 
 /// Resets the comm finite state machine to the default/starting condition.
+/// The transfer in progress is ended first (see endXfer) and the transfers of
+/// the current batch that were acted on are released from the transfer queue
+/// so they aren't replayed.
 static void resetCommFsm(void)
 {
+    if (g_commFsm.xferInProgress)
+        endXfer();
+    if ((g_heap != NULL) && (g_heap->queue != NULL))
+        releaseXfers();
     alarm_disarm(&g_commFsm.timeoutAlarm);
+    alarm_disarm(&g_commFsm.xferAlarm);
     g_commFsm.pendingRxSize = 0u;
-    g_commFsm.rxPending = false;
+    g_commFsm.rxPendingMask = 0u;
     g_commFsm.rxSwitchToResponseBuffer = false;
     g_commFsm.state = CommState_Waiting;
+    g_commFsm.xferSpanCount = 0u;
+    g_commFsm.xferCount = 0u;
+    g_commFsm.xferInProgress = false;
+    g_commFsm.xferDone = false;
 }
 
 
-/// Resets the slave status flags to the default states. The following flags
-/// are reset:
-/// 1. g_slaveAppResponseActive (false)
-/// 2. g_slaveNoStop (false)
+/// Resets the slave status flags of every slave context to the default states.
+/// The following flags are reset:
+/// 1. appResponseActive (false)
+/// 2. appRxSwitchToResponse (false)
 static void resetSlaveStatusFlags(void)
 {
 #if !ENABLE_ALL_CHANGE_TO_RESPONSE
     
-    g_slaveAppResponseActive = false;
-    g_appRxSwitchToResponse = false;
+    for (uint8_t i = 0; i < I2C_SLAVE_COUNT; ++i)
+    {
+        g_slaves[i].appResponseActive = false;
+        g_slaves[i].appRxSwitchToResponse = false;
+    }
     
 #endif // !ENABLE_ALL_CHANGE_TO_RESPONSE
 }
@@ -1436,15 +2063,20 @@ static void reinitAll(void)
 ///                     specifically the queue data.
 static void initTouchHeap(TouchHeap* heap)
 {
-    queue_registerEnqueueCallback(&heap->heapData.xferQueue, prepareXferQueueData);
+    queue_deregisterEnqueueCallback(&heap->heapData.xferQueue);
     heap->heapData.xferQueue.data = heap->heapData.xferQueueData;
     heap->heapData.xferQueue.elements = heap->heapData.xferQueueElements;
     heap->heapData.xferQueue.maxDataSize = XFER_QUEUE_DATA_SIZE;
     heap->heapData.xferQueue.maxSize = XFER_QUEUE_MAX_SIZE;
     queue_empty(&heap->heapData.xferQueue);
+    queue_resetStats(&heap->heapData.xferQueue);
     g_heap->queue = &heap->heapData.xferQueue;
     g_heap->rxBuffer = heap->heapData.rxBuffer;
     g_heap->rxBufferSize = TOUCH_RX_BUFFER_SIZE;
+#if ENABLE_I2C_SPECULATIVE_READ
+    memset(&heap->heapData.speculativeRead, 0, sizeof(heap->heapData.speculativeRead));
+    g_heap->speculativeRead = &heap->heapData.speculativeRead;
+#endif // ENABLE_I2C_SPECULATIVE_READ
 }
 
 
@@ -1457,6 +2089,9 @@ static void initUpdateHeap(UpdateHeap* heap)
     g_heap->queue = NULL;
     g_heap->rxBuffer = heap->heapData.rxBuffer;
     g_heap->rxBufferSize = UPDATE_RX_BUFFER_SIZE;
+#if ENABLE_I2C_SPECULATIVE_READ
+    g_heap->speculativeRead = NULL;
+#endif // ENABLE_I2C_SPECULATIVE_READ
 }
 
 
@@ -1484,8 +2119,19 @@ static bool deactivate(void)
 CY_ISR(slaveIsr)
 {
     COMPONENT(SLAVE_IRQ, ClearPending)();
-    COMPONENT(SLAVE_IRQ_PIN, ClearInterrupt)();
-    g_commFsm.rxPending = true;
+    // The pin interrupt status has a bit per pin (slave context).
+    g_commFsm.rxPendingMask |= COMPONENT(SLAVE_IRQ_PIN, ClearInterrupt)() & SLAVE_IRQ_MASK;
+}
+
+
+/// Invoked by the slaveI2c component at the end of its ISR (enabled in
+/// cyapicallbacks.h): flags the completion of the master transfer so the comm
+/// FSM doesn't have to poll the driver status. The status isn't cleared here;
+/// isBusReady processes it.
+void COMPONENT(SLAVE_I2C, I2C_ISR_ExitCallback)(void)
+{
+    if ((COMPONENT(SLAVE_I2C, I2CMasterStatus)() & G_XferDoneMask) > 0)
+        g_commFsm.xferDone = true;
 }
 
 
@@ -1493,32 +2139,70 @@ CY_ISR(slaveIsr)
 
 void i2c_init(void)
 {
+    for (uint8_t i = 1; i < I2C_SLAVE_COUNT; ++i)
+        g_slaves[i].address = SlaveAddress_App + i;
     reinitAll();
     i2c_resetSlaveAddress();
     
     COMPONENT(SLAVE_I2C, Start)();
     COMPONENT(SLAVE_IRQ, StartEx)(slaveIsr);
+    
+    // Apply the saved bit rate; an unsupported bit rate falls back to the
+    // default.
+    Settings settings = { 0u };
+    settings_load(&settings);
+    if ((settings.i2cBitRate == 0) || !i2c_setBitRate(settings.i2cBitRate))
+        i2c_setBitRate(I2C_DEFAULT_BIT_RATE);
+}
+
+
+bool i2c_setBitRate(uint32_t bitRate)
+{
+    static mstatus_t const BusyMask = COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_INP) | COMPONENT(SLAVE_I2C, I2C_MSTAT_XFER_HALT);
+    
+    BitRateConfig const* config = findBitRateConfig(bitRate);
+    if (config == NULL)
+        return false;
+    if (config == g_bitRateConfig)
+        return true;
+    
+    bool idle = (g_commFsm.state == CommState_Waiting) && !g_commFsm.xferInProgress;
+    idle &= (COMPONENT(SLAVE_I2C, I2CMasterStatus)() & BusyMask) == 0;
+    if (idle)
+        applyBitRateConfig(config);
+    return idle;
+}
+
+
+uint32_t i2c_getBitRate(void)
+{
+    return g_bitRateConfig->bitRate;
 }
 
 
 
 void i2c_setSlaveAddress(uint8_t address)
 {
-    if (address != g_slaveAddress)
+    i2c_setSlaveContextAddress(0u, address);
+}
+
+
+bool i2c_setSlaveContextAddress(uint8_t slave, uint8_t address)
+{
+    if (slave >= I2C_SLAVE_COUNT)
+        return false;
+    if (address != g_slaves[slave].address)
     {
-        g_slaveAddress = address;
+        g_slaves[slave].address = address;
         reinitAll();
     }
+    return true;
 }
 
 
 void i2c_resetSlaveAddress(void)
 {
-    if (g_slaveAddress != SlaveAddress_App)
-    {
-        g_slaveAddress = SlaveAddress_App;
-        reinitAll();
-    }
+    i2c_setSlaveContextAddress(0u, SlaveAddress_App);
 }
 
 
@@ -1554,7 +2238,7 @@ I2cStatus i2c_ack(uint8_t address, uint32_t timeoutMs)
     g_callsite.topCall = 4u;
     
     I2cStatus status = ack(address, timeoutMs);
-    processError(status);
+    processError(status, 0u);
     return status;
 }
 
@@ -1564,8 +2248,8 @@ I2cStatus i2c_ackApp(uint32_t timeoutMs)
     g_callsite.value = 0u;
     g_callsite.topCall = 5u;
     
-    I2cStatus status = ack(g_slaveAddress, timeoutMs);
-    processError(status);
+    I2cStatus status = ack(g_slaves[0].address, timeoutMs);
+    processError(status, 0u);
     return status;
 }
 
@@ -1592,7 +2276,7 @@ I2cStatus i2c_read(uint8_t address, uint8_t data[], uint16_t size, uint32_t time
         {
             if (isBusReady(NULL))
             {
-                status = read(address, data, size);
+                status = read(address, data, size, G_DefaultTransferMode);
                 if (i2c_errorOccurred(status))
                     done = true;
                 else
@@ -1605,7 +2289,7 @@ I2cStatus i2c_read(uint8_t address, uint8_t data[], uint16_t size, uint32_t time
             done = isLastTransferComplete(&status);
         }
     }
-    processError(status);
+    processError(status, 0u);
     return status;
 }
 
@@ -1632,7 +2316,7 @@ I2cStatus i2c_write(uint8_t address, uint8_t const data[], uint16_t size, uint32
         {
             if (isBusReady(NULL))
             {
-                status = write(address, data, size);
+                status = write(address, data, size, G_DefaultTransferMode);
                 if (i2c_errorOccurred(status))
                     done = true;
                 else
@@ -1645,7 +2329,7 @@ I2cStatus i2c_write(uint8_t address, uint8_t const data[], uint16_t size, uint32
             done = isLastTransferComplete(&status);
         }
     }
-    processError(status);
+    processError(status, 0u);
     return status;
 }
 
@@ -1713,33 +2397,94 @@ I2cStatus i2cTouch_process(uint32_t timeoutMs)
         else
             status.deactivated = true;
     }
-    processError(status);
+    processError(status, g_commFsm.tag);
     return status;
 }
 
 
-I2cStatus i2cTouch_read(uint8_t address, uint16_t size)
+I2cStatus i2cTouch_read(uint8_t address, uint16_t size, uint8_t tag)
 {
     g_callsite.value = 0u;
     g_callsite.topCall = 2u;
     
-    I2cStatus status = xferEnqueueRead(address, size);
-    processError(status);
+    I2cStatus status = xferEnqueueRead(address, size, tag);
+    processError(status, tag);
     return status;
 }
 
 
-I2cStatus i2cTouch_write(uint8_t address, uint8_t const data[], uint16_t size)
+I2cStatus i2cTouch_write(uint8_t address, uint8_t const data[], uint16_t size, uint8_t tag)
 {
     g_callsite.value = 0u;
     g_callsite.topCall = 3u;
     
-    I2cStatus status = xferEnqueueWrite(address, data, size);
-    processError(status);
+    I2cStatus status = xferEnqueueWrite(address, data, size, tag);
+    processError(status, tag);
     return status;
 }
 
 
+I2cStatus i2cTouch_writeRead(uint8_t address, uint8_t const data[], uint16_t size, uint16_t readSize, uint8_t tag)
+{
+    g_callsite.value = 0u;
+    g_callsite.topCall = 6u;
+    
+    I2cStatus status = xferEnqueueWriteRead(address, data, size, readSize, tag);
+    processError(status, tag);
+    return status;
+}
+
+
+QueueStats i2cTouch_getXferQueueStats(void)
+{
+    QueueStats stats = { 0u };
+    if (i2cTouch_isActivated())
+        stats = queue_getStats(g_heap->queue);
+    return stats;
+}
+
+
+void i2cTouch_resetXferQueueStats(void)
+{
+    if (i2cTouch_isActivated())
+        queue_resetStats(g_heap->queue);
+}
+
+
+void i2cTouch_setLanePolicy(I2cLanePolicy policy, uint8_t slaveIrqWeight, uint8_t hostWeight)
+{
+    g_laneScheduler.policy = policy;
+    g_laneScheduler.weights[I2cLane_SlaveIrq] = (slaveIrqWeight > 0) ? slaveIrqWeight : 1u;
+    g_laneScheduler.weights[I2cLane_Host] = (hostWeight > 0) ? hostWeight : 1u;
+    g_laneScheduler.turns = 0u;
+}
+
+
+I2cLanePolicy i2cTouch_getLanePolicy(uint8_t* slaveIrqWeight, uint8_t* hostWeight)
+{
+    if (slaveIrqWeight != NULL)
+        *slaveIrqWeight = g_laneScheduler.weights[I2cLane_SlaveIrq];
+    if (hostWeight != NULL)
+        *hostWeight = g_laneScheduler.weights[I2cLane_Host];
+    return g_laneScheduler.policy;
+}
+
+
+I2cLaneStats i2cTouch_getLaneStats(I2cLane lane)
+{
+    I2cLaneStats stats = { 0u };
+    if (lane < I2cLane_Count)
+        stats = g_laneScheduler.stats[lane];
+    return stats;
+}
+
+
+void i2cTouch_resetLaneStats(void)
+{
+    memset(g_laneScheduler.stats, 0, sizeof(g_laneScheduler.stats));
+}
+
+
 // === PUBLIC FUNCTIONS: i2cUpdate =============================================
 
 
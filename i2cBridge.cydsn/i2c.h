@@ -75,19 +75,44 @@
     /// Definition of the receive callback function that should be invoked when
     /// data is received. Note that if the callback function needs to copy the
     /// received data into its own buffer if the callback needs to perform any
-    /// action to the data (like modify the data).
-    typedef bool (*I2cRxCallback)(uint8_t const*, uint16_t);
+    /// action to the data (like modify the data). The third parameter is the
+    /// tag of the read (see i2cTouch_read); 0 for the reads triggered by a
+    /// slave IRQ, but also for the untagged reads of the host, so it can't
+    /// tell them apart. The fourth parameter is the 7-bit I2C address the
+    /// data was read from; for the reads triggered by a slave IRQ, it
+    /// identifies the slave context (see i2c_setSlaveContextAddress). The
+    /// last parameter flags the reads triggered by a slave IRQ (the reports
+    /// the slave sends on its own) apart from the reads the host requested.
+    typedef bool (*I2cRxCallback)(uint8_t const*, uint16_t, uint8_t, uint8_t, bool);
     
     /// Definition of the error callback function that should be invoked when
-    /// an error occurs.
-    typedef void (*I2cErrorCallback)(I2cStatus, uint16_t);
+    /// an error occurs. The parameters are the status, the callsite and the tag
+    /// of the transfer that failed (see i2cTouch_read); 0 if the error doesn't
+    /// apply to a tagged transfer.
+    typedef void (*I2cErrorCallback)(I2cStatus, uint16_t, uint8_t);
     
     
     // === FUNCTIONS ===========================================================
     
-    /// Initialize the slave I2C hardware.
+    /// Initialize the slave I2C hardware. The bit rate saved in the settings
+    /// (see settings_load) is applied; I2C_DEFAULT_BIT_RATE if none is saved.
     void i2c_init(void);
     
+    /// Set the bit rate (SCL frequency) of the I2C bus by reprogramming the
+    /// SCB clock divider, the SCL oversampling and the input filters of the
+    /// slaveI2c component. The supported bit rates are 100000 (Sm), 400000
+    /// (Fm) and 1000000 (Fm+); Fm+ also requires pins and pull-ups that
+    /// support it. The default timeouts of the transfers are derived from the
+    /// bit rate.
+    /// @param[in]  bitRate The bit rate in bits per second.
+    /// @return If the bit rate is active; false if the bit rate isn't
+    ///         supported or a transfer is in progress (nothing changed).
+    bool i2c_setBitRate(uint32_t bitRate);
+    
+    /// Accessor to get the active bit rate of the I2C bus.
+    /// @return The bit rate in bits per second.
+    uint32_t i2c_getBitRate(void);
+    
     /// Registers the receive callback function that should be invoked when
     /// data is received.
     /// @param[in]  callback    The callback function.
@@ -100,11 +125,21 @@
     
     /// Registers a new slave address which ensures the write I2C slave device
     /// is addressed when attempting to read when the slaveIRQ line is asserted.
+    /// This is the address of slave context 0.
     /// @param[in]  address The new slave address to set.
     void i2c_setSlaveAddress(uint8_t address);
     
-    /// Resets the slave address to the default. The slave address is used when
-    /// the IRQ line is asserted and a slave read is to be performed.
+    /// Registers a new slave address for a slave context: the slave device
+    /// read when the IRQ line of the slave context (pin i of the slaveIrqPin
+    /// component for slave context i) is asserted. See I2C_SLAVE_COUNT.
+    /// @param[in]  slave   The slave context.
+    /// @param[in]  address The new slave address to set.
+    /// @return If the slave context exists.
+    bool i2c_setSlaveContextAddress(uint8_t slave, uint8_t address);
+    
+    /// Resets the slave address of slave context 0 to the default. The slave
+    /// address is used when the IRQ line is asserted and a slave read is to be
+    /// performed.
     void i2c_resetSlaveAddress(void);
     
     /// Accessor to get the driver status mask from the last low-level I2C
@@ -25,10 +25,54 @@
     #include <stdint.h>
     
     #include "i2c.h"
+    #include "queue.h"
     
     
     // === TYPE DEFINES ========================================================
     
+    /// Transfer lanes of the I2C communication; each lane is a source of I2C
+    /// transactions that are scheduled against each other.
+    typedef enum I2cLane
+    {
+        /// Reads from the slave device triggered by the slave IRQ line.
+        I2cLane_SlaveIrq,
+        
+        /// Reads and writes requested by the host (the transfer queue). Host
+        /// reads and writes share a lane so they stay in order.
+        I2cLane_Host,
+        
+        /// The number of lanes.
+        I2cLane_Count,
+        
+    } I2cLane;
+    
+    
+    /// Scheduling policy used to pick the next lane to service when more than
+    /// one lane has a pending transaction.
+    typedef enum I2cLanePolicy
+    {
+        /// The slave IRQ lane always takes priority over the host lane.
+        I2cLanePolicy_StrictPriority,
+        
+        /// Each lane is serviced for up to its weight in consecutive
+        /// transactions before the other lane gets a turn.
+        I2cLanePolicy_WeightedRoundRobin,
+        
+    } I2cLanePolicy;
+    
+    
+    /// Counters of a single transfer lane.
+    typedef struct I2cLaneStats
+    {
+        /// The number of transactions started from the lane.
+        uint32_t serviced;
+        
+        /// The number of times the lane had a pending transaction but another
+        /// lane was serviced instead.
+        uint32_t deferred;
+        
+    } I2cLaneStats;
+    
     
     // === FUNCTIONS ===========================================================
     
@@ -71,17 +115,70 @@
     /// received data.
     /// @param[in]  address The 7-bit I2C address.
     /// @param[in]  size    The number of bytes to read.
+    /// @param[in]  tag     Opaque value passed to the receive callback (and the
+    ///                     error callback if the read fails); 0 if unused.
     /// @return Status indicating if an error occured. See the definition of the
     ///         I2cStatus union.
-    I2cStatus i2cTouch_read(uint8_t address, uint16_t size);
+    I2cStatus i2cTouch_read(uint8_t address, uint16_t size, uint8_t tag);
     
     /// Queue up a write to the I2C bus.
     /// @param[in]  address The 7-bit I2C address.
     /// @param[in]  data    The data buffer to that contains the data to write.
     /// @param[in]  size    The number of bytes to write.
+    /// @param[in]  tag     Opaque value passed to the error callback if the
+    ///                     write fails; 0 if unused.
+    /// @return Status indicating if an error occured. See the definition of the
+    ///         I2cStatus union.
+    I2cStatus i2cTouch_write(uint8_t address, uint8_t const data[], uint16_t size, uint8_t tag);
+    
+    /// Queue up a combined write-read on the I2C bus: the data is written
+    /// without a STOP and the read follows with a repeated START (for example,
+    /// a register address followed by the register contents). The received
+    /// data is handled like i2cTouch_read.
+    /// @param[in]  address     The 7-bit I2C address.
+    /// @param[in]  data        The data buffer that contains the data to write.
+    /// @param[in]  size        The number of bytes to write.
+    /// @param[in]  readSize    The number of bytes to read.
+    /// @param[in]  tag         Opaque value passed to the receive callback (and
+    ///                         the error callback if the transfer fails); 0 if
+    ///                         unused.
     /// @return Status indicating if an error occured. See the definition of the
     ///         I2cStatus union.
-    I2cStatus i2cTouch_write(uint8_t address, uint8_t const data[], uint16_t size);
+    I2cStatus i2cTouch_writeRead(uint8_t address, uint8_t const data[], uint16_t size, uint16_t readSize, uint8_t tag);
+    
+    /// Accessor to get the statistics of the transfer queue.
+    /// @return The transfer queue statistics; all 0 if the module is not
+    ///         activated for touch mode.
+    QueueStats i2cTouch_getXferQueueStats(void);
+    
+    /// Reset the statistics of the transfer queue.
+    void i2cTouch_resetXferQueueStats(void);
+    
+    /// Set the scheduling policy between the transfer lanes.
+    /// @param[in]  policy          The scheduling policy.
+    /// @param[in]  slaveIrqWeight  The number of consecutive slave IRQ reads
+    ///                             before the host lane gets a turn; only used
+    ///                             for weighted round-robin. Minimum of 1.
+    /// @param[in]  hostWeight      The number of consecutive host transfers
+    ///                             before the slave IRQ lane gets a turn; only
+    ///                             used for weighted round-robin. Minimum of 1.
+    void i2cTouch_setLanePolicy(I2cLanePolicy policy, uint8_t slaveIrqWeight, uint8_t hostWeight);
+    
+    /// Accessor to get the scheduling policy between the transfer lanes.
+    /// @param[out] slaveIrqWeight  The number of consecutive slave IRQ reads
+    ///                             before the host lane gets a turn.
+    /// @param[out] hostWeight      The number of consecutive host transfers
+    ///                             before the slave IRQ lane gets a turn.
+    /// @return The scheduling policy.
+    I2cLanePolicy i2cTouch_getLanePolicy(uint8_t* slaveIrqWeight, uint8_t* hostWeight);
+    
+    /// Accessor to get the counters of a transfer lane.
+    /// @param[in]  lane    The lane to get the counters of.
+    /// @return The counters of the lane; all 0 if the lane is invalid.
+    I2cLaneStats i2cTouch_getLaneStats(I2cLane lane);
+    
+    /// Reset the counters of all the transfer lanes.
+    void i2cTouch_resetLaneStats(void);
     
     
     #ifdef __cplusplus
@@ -18,24 +18,245 @@
 #include <string.h>
 
 
+// === DEFINES =================================================================
+
+/// Memory barrier: guarantees that an element (and its data) is completely
+/// written before the new tail is published to the consumer and that the
+/// consumer is done with an element before the new head is published to the
+/// producer. Also acts as a compiler barrier.
+#if defined(__arm__)
+    #define MEMORY_BARRIER()    __asm volatile ("dmb" ::: "memory")
+#else
+    #define MEMORY_BARRIER()    __sync_synchronize()
+#endif
+
+
 // === PRIVATE FUNCTIONS =======================================================
 
+/// Get the element index of a head or tail position. Positions run from 0 to
+/// (2 * maxSize - 1) so a full queue can be distinguished from an empty queue
+/// without a shared size counter.
+/// @param[in]  queue       The queue.
+/// @param[in]  position    The head or tail position.
+/// @return The index in the element array.
+static uint8_t getIndex(Queue const volatile* queue, uint8_t position)
+{
+    return (position < queue->maxSize) ? position : (position - queue->maxSize);
+}
+
+
+/// Get the head or tail position that follows the specified position.
+/// @param[in]  queue       The queue.
+/// @param[in]  position    The head or tail position.
+/// @return The next position.
+static uint8_t getNextPosition(Queue const volatile* queue, uint8_t position)
+{
+    position++;
+    if (position >= (queue->maxSize << 1))
+        position = 0;
+    return position;
+}
+
+
+/// Get the number of elements in the queue based on a head and tail position.
+/// @param[in]  queue   The queue.
+/// @param[in]  head    The head position.
+/// @param[in]  tail    The tail position.
+/// @return The number of elements in the queue.
+static uint8_t getSize(Queue const volatile* queue, uint8_t head, uint8_t tail)
+{
+    return (tail >= head) ? (tail - head) : (tail + (queue->maxSize << 1) - head);
+}
+
+
+/// Get the element index of the last (newest) queue element. Only called by
+/// the producer.
+/// @param[in]  queue   The queue.
+/// @return The index in the element array.
+static uint8_t getLastIndex(Queue const volatile* queue)
+{
+    uint8_t index = getIndex(queue, queue->tail);
+    return (index > 0) ? (index - 1) : (queue->maxSize - 1);
+}
+
+
 /// Get the data offset in the data buffer that defines where the pending
-/// enqueue data starts.
+/// enqueue data starts. This is the offset immediately after the data of the
+/// last (newest) queue element. Only called by the producer.
 /// @param[in]  queue   The queue.
+/// @param[in]  head    The head position read once by the producer.
 /// @return The data offset in the data buffer of the queue.
-uint16_t getEnqueueDataOffset(Queue const volatile* queue)
+static uint16_t getEnqueueDataOffset(Queue const volatile* queue, uint8_t head)
 {
     uint16_t offset = 0;
-    if (!queue_isEmpty(queue))
+    if (head != queue->tail)
     {
-        uint16_t index = (queue->tail + queue->maxSize) % queue->maxSize;
+        uint8_t index = getLastIndex(queue);
         offset = queue->elements[index].dataOffset + queue->elements[index].dataSize;
     }
     return offset;
 }
 
 
+/// Check if the data of the queue elements wraps around the end of the data
+/// buffer; the newest element starts before the oldest element in the data
+/// buffer. Only called by the producer.
+/// @param[in]  queue   The queue.
+/// @param[in]  head    The head position read once by the producer.
+/// @return If the data of the queue elements is wrapped.
+static bool isDataWrapped(Queue const volatile* queue, uint8_t head)
+{
+    bool status = false;
+    if (head != queue->tail)
+        status = (queue->elements[getLastIndex(queue)].dataOffset < queue->elements[getIndex(queue, head)].dataOffset);
+    return status;
+}
+
+
+/// Get the number of contiguous free bytes in the data buffer starting at the
+/// specified data offset. The offset must be the start of a new element: the
+/// end of the newest element or the start of the data buffer. Only called by
+/// the producer.
+/// @param[in]  queue   The queue.
+/// @param[in]  head    The head position read once by the producer.
+/// @param[in]  offset  The data offset in the data buffer.
+/// @return The number of contiguous free bytes starting at the offset.
+static uint16_t getFreeDataSize(Queue const volatile* queue, uint8_t head, uint16_t offset)
+{
+    uint16_t limit = queue->maxDataSize;
+    if (head != queue->tail)
+    {
+        uint16_t headOffset = queue->elements[getIndex(queue, head)].dataOffset;
+        if (isDataWrapped(queue, head) || (offset < headOffset))
+            limit = headOffset;
+    }
+    return (offset < limit) ? (limit - offset) : 0;
+}
+
+
+/// Get the number of contiguous free bytes available at the start of the data
+/// buffer if the data of a new element wraps around the end of the data
+/// buffer. No bytes are available if the data is already wrapped. Only called
+/// by the producer.
+/// @param[in]  queue   The queue.
+/// @param[in]  head    The head position read once by the producer.
+/// @return The number of contiguous free bytes at the start of the data buffer.
+static uint16_t getWrapDataSize(Queue const volatile* queue, uint8_t head)
+{
+    uint16_t size = queue->maxDataSize;
+    if (isDataWrapped(queue, head))
+        size = 0;
+    else if (head != queue->tail)
+        size = queue->elements[getIndex(queue, head)].dataOffset;
+    return size;
+}
+
+
+/// Copy (or encode through the enqueue callback) data into a free region of
+/// the data buffer.
+/// @param[in]  queue       The queue.
+/// @param[in]  offset      The data offset in the data buffer to copy to.
+/// @param[in]  freeSize    The number of free bytes at the data offset.
+/// @param[in]  data        The data to copy.
+/// @param[in]  size        The size of the data (in bytes) to copy.
+/// @return The number of bytes written to the data buffer; 0 if the data does
+///         not fit in the free region.
+static uint16_t copyData(Queue volatile* queue, uint16_t offset, uint16_t freeSize, uint8_t const* data, uint16_t size)
+{
+    uint16_t copySize = 0;
+    if (freeSize > 0)
+    {
+        if (queue->enqueueCallback != NULL)
+            copySize = queue->enqueueCallback(&queue->data[offset], freeSize, data, size);
+        else if (size <= freeSize)
+        {
+            memcpy(&queue->data[offset], data, size);
+            copySize = size;
+        }
+    }
+    return copySize;
+}
+
+
+/// Update the statistics before a new element is published. Only called by the
+/// producer.
+/// @param[in]  queue   The queue.
+/// @param[in]  offset  The start offset of the element's data.
+/// @param[in]  size    The number of bytes of data in the element.
+static void updateEnqueueStats(Queue volatile* queue, uint16_t offset, uint16_t size)
+{
+#if ENABLE_QUEUE_STATS
+    uint8_t head = queue->head;
+    uint8_t elementCount = getSize(queue, head, queue->tail) + 1;
+    uint16_t dataSize = size;
+    if (elementCount > 1)
+    {
+        // The bytes in use run from the oldest element to the end of the new
+        // element, wrapping around the end of the data buffer if required.
+        uint16_t headOffset = queue->elements[getIndex(queue, head)].dataOffset;
+        if (offset >= headOffset)
+            dataSize = offset + size - headOffset;
+        else
+            dataSize = queue->maxDataSize - headOffset + offset + size;
+    }
+    
+    queue->stats.enqueuedBytes += size;
+    if (elementCount > queue->stats.peakSize)
+        queue->stats.peakSize = elementCount;
+    if (dataSize > queue->stats.peakDataSize)
+        queue->stats.peakDataSize = dataSize;
+#else
+    (void)queue;
+    (void)offset;
+    (void)size;
+#endif // ENABLE_QUEUE_STATS
+}
+
+
+/// Update the statistics after an enqueue fails. Only called by the producer.
+/// @param[in]  queue   The queue.
+static void updateEnqueueFailureStats(Queue volatile* queue)
+{
+#if ENABLE_QUEUE_STATS
+    if (queue->stats.enqueueFailures < UINT16_MAX)
+        queue->stats.enqueueFailures++;
+#else
+    (void)queue;
+#endif // ENABLE_QUEUE_STATS
+}
+
+
+/// Update the statistics after data is dequeued. Only called by the consumer.
+/// @param[in]  queue   The queue.
+/// @param[in]  size    The number of bytes dequeued.
+static void updateDequeueStats(Queue volatile* queue, uint16_t size)
+{
+#if ENABLE_QUEUE_STATS
+    queue->stats.dequeuedBytes += size;
+#else
+    (void)queue;
+    (void)size;
+#endif // ENABLE_QUEUE_STATS
+}
+
+
+/// Add a new element to the tail of the queue and publish it to the consumer.
+/// Only called by the producer.
+/// @param[in]  queue   The queue.
+/// @param[in]  offset  The start offset of the element's data.
+/// @param[in]  size    The number of bytes of data in the element.
+static void publishElement(Queue volatile* queue, uint16_t offset, uint16_t size)
+{
+    updateEnqueueStats(queue, offset, size);
+    uint8_t tail = queue->tail;
+    QueueElement* element = &queue->elements[getIndex(queue, tail)];
+    element->dataOffset = offset;
+    element->dataSize = size;
+    MEMORY_BARRIER();
+    queue->tail = getNextPosition(queue, tail);
+}
+
+
 // === PUBLIC FUNCTIONS ========================================================
 
 void queue_empty(Queue volatile* queue)
@@ -44,7 +265,8 @@ void queue_empty(Queue volatile* queue)
     {
         queue->head = 0;
         queue->tail = 0;
-        queue->size = 0;
+        queue->pendingEnqueueSize = 0;
+        queue->reserved = false;
     }
 }
 
@@ -67,7 +289,7 @@ bool queue_isFull(Queue const volatile* queue)
 {
     bool status = false;
     if (queue != NULL)
-        status = (queue->size == queue->maxSize);
+        status = (getSize(queue, queue->head, queue->tail) >= queue->maxSize);
     return status;
 }
 
@@ -76,36 +298,67 @@ bool queue_isEmpty(Queue const volatile* queue)
 {
     bool status = false;
     if (queue != NULL)
-        status = (queue->size == 0);
+        status = (queue->head == queue->tail);
     return status;
 }
 
 
+uint8_t queue_getSize(Queue const volatile* queue)
+{
+    uint8_t size = 0;
+    if (queue != NULL)
+        size = getSize(queue, queue->head, queue->tail);
+    return size;
+}
+
+
+uint16_t queue_getFreeDataSize(Queue const volatile* queue)
+{
+    uint16_t size = 0;
+    if (queue != NULL)
+    {
+        uint8_t head = queue->head;
+        if (getSize(queue, head, queue->tail) < queue->maxSize)
+        {
+            uint16_t freeSize = getFreeDataSize(queue, head, getEnqueueDataOffset(queue, head));
+            uint16_t wrapSize = getWrapDataSize(queue, head);
+            size = (wrapSize > freeSize) ? (wrapSize) : (freeSize);
+        }
+    }
+    return size;
+}
+
+
 bool queue_enqueue(Queue volatile* queue, uint8_t const* data, uint16_t size)
 {
     bool status = false;
-    if ((queue != NULL) && (data != NULL) && (size > 0) && !queue_isFull(queue))
+    if ((queue != NULL) && (data != NULL) && (size > 0))
     {
-        uint16_t offset = getEnqueueDataOffset(queue);
-        if ((offset + size) <= queue->maxDataSize)
+        // An enqueue abandons the reservation.
+        queue->reserved = false;
+        uint8_t head = queue->head;
+        if (getSize(queue, head, queue->tail) < queue->maxSize)
         {
-            uint16_t enqueueSize = size;
-            if (queue->enqueueCallback != NULL)
-                enqueueSize = queue->enqueueCallback(&queue->data[offset], queue->maxDataSize - offset, data, size);
-            else
-                memcpy(&queue->data[offset], data, size);
+            // Try to place the data after the newest element first; if it does
+            // not fit, wrap around to the start of the data buffer.
+            uint16_t offset = getEnqueueDataOffset(queue, head);
+            uint16_t freeSize = getFreeDataSize(queue, head, offset);
+            uint16_t enqueueSize = copyData(queue, offset, freeSize, data, size);
+            if (enqueueSize == 0)
+            {
+                uint16_t wrapSize = getWrapDataSize(queue, head);
+                if (wrapSize > freeSize)
+                {
+                    offset = 0;
+                    enqueueSize = copyData(queue, offset, wrapSize, data, size);
+                }
+            }
             
             // The enqueue is successful if enqueueSize > 0; if this is the
             // case, update the queue to incdicate a successful enqueue.
             if (enqueueSize > 0)
             {
-                QueueElement* tail = &queue->elements[queue->tail];
-                tail->dataOffset = offset;
-                tail->dataSize = enqueueSize;
-                queue->size++;
-                queue->tail++;
-                if (queue->tail >= queue->maxSize)
-                    queue->tail = 0;
+                publishElement(queue, offset, enqueueSize);
                 status = true;
             }
             
@@ -114,66 +367,166 @@ bool queue_enqueue(Queue volatile* queue, uint8_t const* data, uint16_t size)
             // byte-by-byte data has been stomped on.
             queue->pendingEnqueueSize = 0;
         }
+        if (!status)
+            updateEnqueueFailureStats(queue);
     }
     return status;
 }
 
 
-bool queue_enqueueByte(Queue volatile* queue, uint8_t data, bool lastByte)
+bool queue_enqueueBytes(Queue volatile* queue, uint8_t const* data, uint16_t size, bool finalize)
 {
     bool status = false;
-    if ((queue != NULL) && !queue_isFull(queue))
+    if ((queue != NULL) && (data != NULL) && (size > 0))
     {
-        uint16_t enqueueSize = 1;
-        uint16_t dataOffset = getEnqueueDataOffset(queue) + queue->pendingEnqueueSize;
-        if (queue->enqueueCallback != NULL)
-            enqueueSize = queue->enqueueCallback(&queue->data[dataOffset], queue->maxDataSize - dataOffset, &data, enqueueSize);
-        else
-            queue->data[dataOffset] = data;
-            
-        // The enqueue is successful if enqueueSize > 0; if this is the case,
-        // update the queue to indicate a successful enqueue.
-        if (enqueueSize > 0)
+        // An enqueue abandons the reservation.
+        queue->reserved = false;
+        uint8_t head = queue->head;
+        if (getSize(queue, head, queue->tail) < queue->maxSize)
         {
-            queue->pendingEnqueueSize += enqueueSize;
-            if (lastByte)
-                status = queue_enqueueFinalize(queue);
+            if (queue->pendingEnqueueSize == 0)
+                queue->pendingEnqueueOffset = getEnqueueDataOffset(queue, head);
+            
+            uint16_t offset = queue->pendingEnqueueOffset + queue->pendingEnqueueSize;
+            uint16_t freeSize = getFreeDataSize(queue, head, queue->pendingEnqueueOffset) - queue->pendingEnqueueSize;
+            uint16_t enqueueSize = copyData(queue, offset, freeSize, data, size);
+            
+            // If the pending element reached the end of the data buffer, move
+            // the pending data to the start of the data buffer if there is
+            // room.
+            if ((enqueueSize == 0) && (queue->pendingEnqueueOffset > 0))
+            {
+                uint16_t wrapSize = getWrapDataSize(queue, head);
+                if (wrapSize > queue->pendingEnqueueSize)
+                {
+                    memmove(&queue->data[0], &queue->data[queue->pendingEnqueueOffset], queue->pendingEnqueueSize);
+                    queue->pendingEnqueueOffset = 0;
+                    offset = queue->pendingEnqueueSize;
+                    enqueueSize = copyData(queue, offset, wrapSize - offset, data, size);
+                }
+            }
+            
+            // The enqueue is successful if enqueueSize > 0; if this is the
+            // case, update the queue to indicate a successful enqueue.
+            if (enqueueSize > 0)
+            {
+                queue->pendingEnqueueSize += enqueueSize;
+                if (finalize)
+                    status = queue_enqueueFinalize(queue);
+                else
+                    status = true;
+            }
             else
-                status = true;
+                updateEnqueueFailureStats(queue);
         }
+        else
+            updateEnqueueFailureStats(queue);
     }
     return status;
 }
 
 
+bool queue_enqueueByte(Queue volatile* queue, uint8_t data, bool lastByte)
+{
+    return queue_enqueueBytes(queue, &data, sizeof(data), lastByte);
+}
+
+
 bool queue_enqueueFinalize(Queue volatile* queue)
 {
     bool status = false;
     if ((queue != NULL) && !queue_isFull(queue) && (queue->pendingEnqueueSize > 0))
     {
-        QueueElement* tail = &queue->elements[queue->tail];
-        tail->dataOffset = getEnqueueDataOffset(queue);
-        tail->dataSize = queue->pendingEnqueueSize;
-        queue->size++;
-        queue->tail++;
-        if (queue->tail >= queue->maxSize)
-            queue->tail = 0;
+        publishElement(queue, queue->pendingEnqueueOffset, queue->pendingEnqueueSize);
+        queue->pendingEnqueueSize = 0;
+        status = true;
+    }
+    else if ((queue != NULL) && (queue->pendingEnqueueSize > 0))
+        updateEnqueueFailureStats(queue);
+    return status;
+}
+
+
+void queue_enqueueDiscard(Queue volatile* queue)
+{
+    if (queue != NULL)
+    {
         queue->pendingEnqueueSize = 0;
+        queue->reserved = false;
+    }
+}
+
+
+bool queue_enqueueTruncate(Queue volatile* queue, uint16_t size)
+{
+    bool status = false;
+    if ((queue != NULL) && (queue->pendingEnqueueSize >= size))
+    {
+        queue->pendingEnqueueSize -= size;
         status = true;
     }
     return status;
 }
 
 
+uint8_t* queue_reserve(Queue volatile* queue, uint16_t size)
+{
+    uint8_t* reservation = NULL;
+    if ((queue != NULL) && (size > 0))
+    {
+        queue->reserved = false;
+        uint8_t head = queue->head;
+        if (getSize(queue, head, queue->tail) < queue->maxSize)
+        {
+            uint16_t offset = getEnqueueDataOffset(queue, head);
+            if (getFreeDataSize(queue, head, offset) < size)
+                offset = (getWrapDataSize(queue, head) >= size) ? (0) : (queue->maxDataSize);
+            if (offset < queue->maxDataSize)
+            {
+                queue->pendingEnqueueOffset = offset;
+                queue->reserved = true;
+                reservation = &queue->data[offset];
+            }
+            
+            // A reservation stomps on any previous byte-by-byte data.
+            queue->pendingEnqueueSize = 0;
+        }
+        if (reservation == NULL)
+            updateEnqueueFailureStats(queue);
+    }
+    return reservation;
+}
+
+
+bool queue_commit(Queue volatile* queue, uint16_t size)
+{
+    bool status = false;
+    if ((queue != NULL) && (size > 0))
+    {
+        uint8_t head = queue->head;
+        if (queue->reserved && (queue->pendingEnqueueSize == 0) &&
+            (getSize(queue, head, queue->tail) < queue->maxSize) &&
+            (size <= getFreeDataSize(queue, head, queue->pendingEnqueueOffset)))
+        {
+            publishElement(queue, queue->pendingEnqueueOffset, size);
+            status = true;
+        }
+        else
+            updateEnqueueFailureStats(queue);
+        queue->reserved = false;
+    }
+    return status;
+}
+
+
 uint16_t queue_dequeue(Queue volatile* queue, uint8_t** data)
 {
     uint16_t length = queue_peak(queue, data);
     if (length > 0)
     {
-        queue->size--;
-        queue->head++;
-        if (queue->head >= queue->maxSize)
-            queue->head = 0;
+        updateDequeueStats(queue, length);
+        MEMORY_BARRIER();
+        queue->head = getNextPosition(queue, queue->head);
     }
     return length;
 }
@@ -182,14 +535,102 @@ uint16_t queue_dequeue(Queue volatile* queue, uint8_t** data)
 uint16_t queue_peak(Queue const volatile* queue, uint8_t** data)
 {
     uint16_t length = 0;
-    if ((queue != NULL) && (data != NULL) && !queue_isEmpty(queue))
+    if ((queue != NULL) && (data != NULL))
     {
-        *data = NULL;
-        *data = &queue->data[queue->elements[queue->head].dataOffset];
-        length = queue->elements[queue->head].dataSize;
+        uint8_t head = queue->head;
+        if (head != queue->tail)
+        {
+            MEMORY_BARRIER();
+            QueueElement const* element = &queue->elements[getIndex(queue, head)];
+            *data = &queue->data[element->dataOffset];
+            length = element->dataSize;
+        }
     }
     return length;
 }
 
 
+uint8_t queue_peakBatch(Queue const volatile* queue, QueueSpan spans[], uint8_t maxCount)
+{
+    uint8_t count = 0;
+    if ((queue != NULL) && (spans != NULL))
+    {
+        uint8_t head = queue->head;
+        uint8_t size = getSize(queue, head, queue->tail);
+        if (size > maxCount)
+            size = maxCount;
+        if (size > 0)
+            MEMORY_BARRIER();
+        for (; count < size; ++count)
+        {
+            QueueElement const* element = &queue->elements[getIndex(queue, head)];
+            spans[count].data = &queue->data[element->dataOffset];
+            spans[count].size = element->dataSize;
+            head = getNextPosition(queue, head);
+        }
+    }
+    return count;
+}
+
+
+uint8_t queue_dequeueBatch(Queue volatile* queue, uint8_t count)
+{
+    if (queue != NULL)
+    {
+        uint8_t head = queue->head;
+        uint8_t size = getSize(queue, head, queue->tail);
+        if (count > size)
+            count = size;
+        if (count > 0)
+        {
+        #if ENABLE_QUEUE_STATS
+            uint16_t dataSize = 0;
+            uint8_t released = head;
+            for (uint8_t i = 0; i < count; ++i)
+            {
+                dataSize += queue->elements[getIndex(queue, released)].dataSize;
+                released = getNextPosition(queue, released);
+            }
+            updateDequeueStats(queue, dataSize);
+        #endif // ENABLE_QUEUE_STATS
+            
+            uint16_t position = head + count;
+            if (position >= (queue->maxSize << 1))
+                position -= (queue->maxSize << 1);
+            MEMORY_BARRIER();
+            queue->head = position;
+        }
+    }
+    else
+        count = 0;
+    return count;
+}
+
+
+QueueStats queue_getStats(Queue const volatile* queue)
+{
+    QueueStats stats = { 0u };
+    if (queue != NULL)
+    {
+    #if ENABLE_QUEUE_STATS
+        stats = queue->stats;
+    #endif // ENABLE_QUEUE_STATS
+        stats.maxDataSize = queue->maxDataSize;
+        stats.maxSize = queue->maxSize;
+    }
+    return stats;
+}
+
+
+void queue_resetStats(Queue volatile* queue)
+{
+#if ENABLE_QUEUE_STATS
+    if (queue != NULL)
+        memset((void*)&queue->stats, 0, sizeof(queue->stats));
+#else
+    (void)queue;
+#endif // ENABLE_QUEUE_STATS
+}
+
+
 /* [] END OF FILE */
@@ -24,6 +24,8 @@
     #endif
     #include <stdint.h>
     
+    #include "config.h"
+    
     
     // === TYPE DEFINES ========================================================
     
@@ -45,7 +47,64 @@
     } QueueElement;
     
     
-    /// Definition of the queue object. Size (32-bit) = 20.
+    /// Contiguous span of data of a single queue element (see
+    /// queue_peakBatch).
+    typedef struct QueueSpan
+    {
+        /// Pointer to the element's data in the queue's data array.
+        uint8_t* data;
+        
+        /// The number of bytes of data in the element.
+        uint16_t size;
+        
+    } QueueSpan;
+    
+    
+    /// Statistics of a queue used to size the queue from field data. The
+    /// producer updates the enqueue statistics and the consumer updates the
+    /// dequeue statistics so no locking is required. Size (32-bit) = 16.
+    typedef struct QueueStats
+    {
+        /// The total number of bytes enqueued.
+        uint32_t enqueuedBytes;
+        
+        /// The total number of bytes dequeued.
+        uint32_t dequeuedBytes;
+        
+        /// The number of enqueues (including reservations) that failed because
+        /// the queue was full or the data didn't fit.
+        uint16_t enqueueFailures;
+        
+        /// High-water mark of the number of bytes in use in the data array,
+        /// including the bytes skipped at the end of the data array when the
+        /// element data wraps.
+        uint16_t peakDataSize;
+        
+        /// The size of the data array; only populated by queue_getStats.
+        uint16_t maxDataSize;
+        
+        /// High-water mark of the number of elements in the queue.
+        uint8_t peakSize;
+        
+        /// The maximum number of elements; only populated by queue_getStats.
+        uint8_t maxSize;
+        
+    } QueueStats;
+    
+    
+    /// Definition of the queue object. The data of each element is stored
+    /// contiguously in the data array; the data array is used as a ring so
+    /// element data wraps around to the start of the data array when there is
+    /// no room at the end. Size (32-bit) = 24 (40 with ENABLE_QUEUE_STATS).
+    ///
+    /// The queue is a lock-free single-producer/single-consumer queue: one
+    /// context (for example an ISR) may enqueue while another context (for
+    /// example the main loop) peaks and dequeues without disabling interrupts.
+    /// The producer owns tail and the pending enqueue element; the consumer
+    /// owns head; the number of elements is derived from head and tail. The
+    /// consumer must finish with an element's data (queue_peak) before
+    /// releasing it (queue_dequeue) because the producer may reuse the data
+    /// as soon as the element is dequeued.
     typedef struct Queue
     {
         /// Data array that holds the raw data of each member of the queue.
@@ -67,17 +126,34 @@
         /// this value will remain 0.
         uint16_t pendingEnqueueSize;
         
-        /// The maximum number of elements that can be queued.
+        /// The start offset of the pending enqueue element from the queue's
+        /// data array. Only valid when pendingEnqueueSize > 0 or after a
+        /// reservation (queue_reserve).
+        uint16_t pendingEnqueueOffset;
+        
+        /// Flag indicating the region at pendingEnqueueOffset is reserved
+        /// (queue_reserve) and can be committed (queue_commit). Cleared by the
+        /// commit and by any other enqueue.
+        bool reserved;
+        
+        /// The maximum number of elements that can be queued (127 max).
         uint8_t maxSize;
         
-        /// The head of the queue, entries are dequeued (removed) from the head.
+        /// The head position of the queue, entries are dequeued (removed) from
+        /// the head. Only modified by the consumer. Positions run from 0 to
+        /// (2 * maxSize - 1) so a full queue differs from an empty queue.
         uint8_t head;
         
-        /// The tail of the queue, entries are enqueued (added) to the tail.
+        /// The tail position of the queue, entries are enqueued (added) to the
+        /// tail. Only modified by the producer.
         uint8_t tail;
+    
+    #if ENABLE_QUEUE_STATS
         
-        /// The number of elements currently in the queue.
-        uint8_t size;
+        /// Statistics of the queue.
+        QueueStats stats;
+    
+    #endif // ENABLE_QUEUE_STATS
         
     } Queue;
     
@@ -86,9 +162,8 @@
     
     /// Empty the queue; no queue elements will be in the queue. Note that the
     /// data array holding each queue element's data will not be cleared.
-    /// Because the empty operation modifies the queue data structure, DO NOT
-    /// empty the queue in an ISR unless the queue is protected by a mutex,
-    /// semaphore, or lock.
+    /// Because the empty operation modifies both the head and the tail, only
+    /// empty the queue when neither the producer nor the consumer is active.
     /// @param[in]  queue   The queue to perform the function's action on.
     void queue_empty(Queue volatile* queue);
     
@@ -117,9 +192,23 @@
     /// @return If the queue is empty.
     bool queue_isEmpty(Queue const volatile* queue);
     
-    /// Enqueue (add) a new queue element into the queue tail (end). Because an
-    /// enqueue modifies the queue data structure, DO NOT enqueue in an ISR
-    /// unless the queue is protected by a mutex, semaphore, or lock.
+    /// Get the number of queue elements in the queue.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @return The number of queue elements in the queue.
+    uint8_t queue_getSize(Queue const volatile* queue);
+    
+    /// Get the size of the largest queue element that can be enqueued. A
+    /// sequence of queue elements whose total size doesn't exceed it can be
+    /// enqueued as well (the elements that don't fit after the newest element
+    /// wrap to the start of the data array). The pending enqueue element is
+    /// not accounted for. Only call from the producer context or with the
+    /// producer paused.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @return The number of data bytes available; 0 if the queue is full.
+    uint16_t queue_getFreeDataSize(Queue const volatile* queue);
+    
+    /// Enqueue (add) a new queue element into the queue tail (end). Only call
+    /// from the producer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[in]  data    The data to enqueue.
     /// @param[in]  size    The size of the data (in bytes) to enqueue.
@@ -127,9 +216,7 @@
     bool queue_enqueue(Queue volatile* queue, uint8_t const* data, uint16_t size);
     
     /// Enqueue (add) a new queue element into the queue tail (end) in a
-    /// byte-by-byte fashion. Because enqueue modifies the queue data structure,
-    /// DO NOT enqueue in an ISR unless the queue is protected by a mutex,
-    /// semaphore, or lock.
+    /// byte-by-byte fashion. Only call from the producer context.
     /// @param[in]  queue       The queue to perform the function's action on.
     /// @param[in]  data        The data to enqueue.
     /// @param[in]  lastByte    Flag indicating if the byte being enqueued is
@@ -138,16 +225,68 @@
     /// @return If the enqueue operation was successful.
     bool queue_enqueueByte(Queue volatile* queue, uint8_t data, bool finalize);
     
+    /// Enqueue (add) multiple bytes to the pending queue element in the same
+    /// fashion as queue_enqueueByte; either all the bytes are added or none
+    /// are. Only call from the producer context.
+    /// @param[in]  queue       The queue to perform the function's action on.
+    /// @param[in]  data        The data to enqueue.
+    /// @param[in]  size        The size of the data (in bytes) to enqueue.
+    /// @param[in]  finalize    Flag indicating if the bytes being enqueued are
+    ///                         the last bytes in the element (so the full
+    ///                         element should be queued).
+    /// @return If the enqueue operation was successful.
+    bool queue_enqueueBytes(Queue volatile* queue, uint8_t const* data, uint16_t size, bool finalize);
+    
     /// Enqueue (add) a new queue lement into the queue tail (end) based on
     /// the pending data added byte-by-byte by the queue_enqueueByte function.
-    /// Because enqueue modifies the queue data structure, DO NOT enqueue in an
-    /// ISR unless the queue is protected by a mutet, semaphore, or lock.
+    /// Only call from the producer context.
     bool queue_enqueueFinalize(Queue volatile* queue);
     
+    /// Discard the pending data added byte-by-byte by the queue_enqueueByte
+    /// and queue_enqueueBytes functions without adding a new queue element.
+    /// Only call from the producer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    void queue_enqueueDiscard(Queue volatile* queue);
+    
+    /// Remove bytes from the end of the pending data added byte-by-byte by
+    /// the queue_enqueueByte and queue_enqueueBytes functions, for example a
+    /// trailer that was checked before queue_enqueueFinalize is called. Only
+    /// call from the producer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[in]  size    The number of bytes to remove.
+    /// @return If the bytes were removed; false if there are fewer pending
+    ///         bytes than size.
+    bool queue_enqueueTruncate(Queue volatile* queue, uint16_t size);
+    
+    /// Reserve a contiguous region in the queue's data array for a new queue
+    /// element so the element can be built in place (zero-copy) instead of
+    /// being built in a separate buffer and copied by an enqueue. The element
+    /// is not added to the queue until queue_commit is called. Any other
+    /// enqueue before the commit abandons the reservation. Only call from the
+    /// producer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[in]  size    The maximum size of the element (in bytes).
+    /// @return Pointer to the reserved region; NULL if the queue is full or
+    ///         there is no contiguous region large enough.
+    uint8_t* queue_reserve(Queue volatile* queue, uint16_t size);
+    
+    /// Enqueue (add) a new queue element into the queue tail (end) using the
+    /// region previously returned by queue_reserve. The enqueue callback is
+    /// not invoked; the data must already be in its final form. Only call
+    /// from the producer context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[in]  size    The number of bytes used in the reserved region;
+    ///                     must not exceed the reserved size.
+    /// @return If the enqueue operation was successful; false if there's no
+    ///         reservation (the reservation failed, was abandoned by another
+    ///         enqueue or was already committed).
+    bool queue_commit(Queue volatile* queue, uint16_t size);
+    
     /// Dequeue (remove) the oldest queue element from the queue head (front).
-    /// Also provides access to the data from this queue element.  Because a
-    /// dequeue modifies the queue data structure, DO NOT dequeue in an ISR
-    /// unless the queue is protected by a mutex, semaphore, or lock.
+    /// Also provides access to the data from this queue element. Only call
+    /// from the consumer context. The data is released to the producer so it
+    /// may be overwritten once the queue is shared with another context; use
+    /// queue_peak to process the data before dequeuing it.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[out] data    Pointer to the dequeued data from the queue.
     /// @return The size of the queue element that was dequeued.
@@ -155,12 +294,42 @@
     
     /// Get the data from the oldest queue element from the queue head (front).
     /// This operation is different from dequeue because the head queue element
-    /// will stay in the queue and the queue size will stay the same.
+    /// will stay in the queue and the queue size will stay the same. Only call
+    /// from the consumer context.
     /// @param[in]  queue   The queue to perform the function's action on.
     /// @param[out] data    Pointer to the dequeued data from the queue.
     /// @return The size of the queue element that was dequeued.
     uint16_t queue_peak(Queue const volatile* queue, uint8_t** data);
     
+    /// Get the data of up to maxCount of the oldest queue elements from the
+    /// queue head (front) in one call. Like queue_peak, the elements stay in
+    /// the queue; release them with queue_dequeueBatch once they have been
+    /// processed. Only call from the consumer context.
+    /// @param[in]  queue       The queue to perform the function's action on.
+    /// @param[out] spans       Array that is populated with the data span of
+    ///                         each element, oldest first.
+    /// @param[in]  maxCount    The maximum number of spans to populate.
+    /// @return The number of spans populated.
+    uint8_t queue_peakBatch(Queue const volatile* queue, QueueSpan spans[], uint8_t maxCount);
+    
+    /// Dequeue (remove) multiple elements from the queue head (front), usually
+    /// the elements returned by queue_peakBatch. Only call from the consumer
+    /// context.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @param[in]  count   The number of elements to dequeue.
+    /// @return The number of elements dequeued.
+    uint8_t queue_dequeueBatch(Queue volatile* queue, uint8_t count);
+    
+    /// Get a snapshot of the queue statistics. If the statistics are disabled
+    /// (ENABLE_QUEUE_STATS), only the capacity of the queue is populated.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    /// @return The queue statistics.
+    QueueStats queue_getStats(Queue const volatile* queue);
+    
+    /// Reset the queue statistics to 0.
+    /// @param[in]  queue   The queue to perform the function's action on.
+    void queue_resetStats(Queue volatile* queue);
+    
     
     #ifdef __cplusplus
         } // extern "C"
@@ -0,0 +1,121 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// === DEPENDENCIES ============================================================
+
+#include "settings.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "crc16.h"
+#include "project.h"
+
+
+// === DEFINES =================================================================
+
+/// The marker at the start of a valid settings record: "SET" followed by the
+/// version of the Settings structure. Change the version whenever the Settings
+/// structure changes so settings saved by an older firmware aren't applied.
+#define SETTINGS_MARKER                 (0x53455401u)
+
+
+// === TYPE DEFINES ============================================================
+
+/// The settings record saved at the start of the settings flash row.
+typedef struct SettingsRecord
+{
+    /// The marker of a valid record; see SETTINGS_MARKER.
+    uint32_t marker;
+    
+    /// The saved settings.
+    Settings settings;
+    
+    /// The CRC-16 of the record up to this field.
+    uint16_t crc;
+    
+} SettingsRecord;
+
+
+// === PRIVATE GLOBAL CONSTANTS ================================================
+
+/// The flash row reserved for the settings; the first bytes hold the
+/// SettingsRecord. This is volatile since it's changed by the flash row writes
+/// behind the compiler's back.
+static uint8_t const volatile G_SettingsRow[CY_FLASH_SIZEOF_ROW] __attribute__((aligned(CY_FLASH_SIZEOF_ROW))) = { 0u };
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Calculates the CRC-16 of a settings record.
+/// @param[in]  record  The settings record.
+/// @return The CRC-16 of the record up to the crc field.
+static uint16_t calculateRecordCrc(SettingsRecord const* record)
+{
+    return crc16_update(CRC16_INITIAL_VALUE, (uint8_t const*)record, offsetof(SettingsRecord, crc));
+}
+
+
+/// Checks if the settings flash row already has the contents of a row.
+/// @param[in]  row The contents of the row (CY_FLASH_SIZEOF_ROW bytes).
+/// @return If the settings flash row matches the row.
+static bool isRowWritten(uint8_t const row[])
+{
+    for (uint16_t i = 0; i < CY_FLASH_SIZEOF_ROW; ++i)
+    {
+        if (G_SettingsRow[i] != row[i])
+            return false;
+    }
+    return true;
+}
+
+
+// === PUBLIC FUNCTIONS ========================================================
+
+bool settings_load(Settings* settings)
+{
+    SettingsRecord record;
+    uint8_t* recordBytes = (uint8_t*)&record;
+    for (uint16_t i = 0; i < sizeof(record); ++i)
+        recordBytes[i] = G_SettingsRow[i];
+    
+    bool valid = (record.marker == SETTINGS_MARKER) && (record.crc == calculateRecordCrc(&record));
+    if (valid && (settings != NULL))
+        *settings = record.settings;
+    return valid;
+}
+
+
+bool settings_save(Settings const* settings)
+{
+    if (settings == NULL)
+        return false;
+    
+    // The row is an array of 32-bit words to keep the record word aligned; the
+    // rest of the row is 0.
+    uint32_t row[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+    memset(row, 0, sizeof(row));
+    SettingsRecord* record = (SettingsRecord*)row;
+    record->marker = SETTINGS_MARKER;
+    record->settings = *settings;
+    record->crc = calculateRecordCrc(record);
+    
+    // Skip the write (and the flash wear) if the settings didn't change.
+    if (isRowWritten((uint8_t const*)row))
+        return true;
+    
+    uint32_t rowNumber = ((uintptr_t)G_SettingsRow - CY_FLASH_BASE) / CY_FLASH_SIZEOF_ROW;
+    return CySysFlashWriteRow(rowNumber, (uint8_t const*)row) == CY_SYS_FLASH_SUCCESS;
+}
+
+
+/* [] END OF FILE */
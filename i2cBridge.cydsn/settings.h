@@ -0,0 +1,67 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+#ifndef SETTINGS_H
+    #define SETTINGS_H
+    
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+    
+    // === DEPENDENCIES ========================================================
+    
+    #ifndef __cplusplus
+        #include <stdbool.h>
+    #endif
+    #include <stdint.h>
+    
+    
+    // === TYPE DEFINES ========================================================
+    
+    /// The settings of the bridge that are saved in flash and applied at
+    /// startup. A value of 0 selects the default of the setting.
+    typedef struct Settings
+    {
+        /// The bit rate of the I2C bus in bits per second; see i2c_setBitRate.
+        /// The default is I2C_DEFAULT_BIT_RATE.
+        uint32_t i2cBitRate;
+        
+    } Settings;
+    
+    
+    // === FUNCTIONS ===========================================================
+    
+    /// Load the settings saved in flash.
+    /// @param[out] settings    The saved settings; unchanged if no valid
+    ///                         settings are saved.
+    /// @return If valid settings are saved.
+    bool settings_load(Settings* settings);
+    
+    /// Save the settings in flash (a flash row reserved for the settings). The
+    /// flash row is only written if the settings changed. The CPU is blocked
+    /// for the duration of the flash row write (several milliseconds) so
+    /// nothing received by the host UART can be serviced in the meantime.
+    /// Note that a row-sized buffer (CY_FLASH_SIZEOF_ROW bytes) is put on the
+    /// stack.
+    /// @param[in]  settings    The settings to save.
+    /// @return If the settings were saved.
+    bool settings_save(Settings const* settings);
+    
+    
+    #ifdef __cplusplus
+        } // extern "C"
+    #endif
+    
+#endif // SETTINGS_H
+
+
+/* [] END OF FILE */
@@ -14,10 +14,13 @@
 
 #include "uart.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "alarm.h"
+#include "byteQueue.h"
+#include "crc16.h"
 #include "debug.h"
 #include "error.h"
 #include "hwSystemTime.h"
@@ -26,6 +29,7 @@
 #include "i2cUpdate.h"
 #include "project.h"
 #include "queue.h"
+#include "settings.h"
 #include "uartTranslate.h"
 #include "uartUpdate.h"
 #include "utility.h"
@@ -37,19 +41,103 @@
 /// Name of the host UART component.
 #define HOST_UART                       hostUart_
 
+#if ENABLE_UART_RTS
+    
+    /// Name of the host UART RTS pin component.
+    #define HOST_UART_RTS                   hostUartRts_
+    
+    /// RTS is deasserted once fewer bytes are free in the receive queue filled
+    /// by the receive ISR; the host may still send a few bytes before it
+    /// pauses. RTS is asserted again once twice as many bytes are free.
+    #define UART_RTS_FREE_THRESHOLD         (64u)
+    
+#endif // ENABLE_UART_RTS
+
 /// The max size of the receive queue (the max number of queue elements).
 #define TRANSLATE_RX_QUEUE_MAX_SIZE     (8u)
 
-/// The size of the data array that holds the queue element data in the
-/// receive queue.
-#define TRANSLATE_RX_QUEUE_DATA_SIZE    (600u)
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    
+    /// The size of the data array that holds the queue element data in the
+    /// receive queue. The 600 bytes allocated to the receive queue when
+    /// parsing in the ISR are split between the raw receive queue (data and
+    /// queue structure) and the receive queue.
+    #define TRANSLATE_RX_QUEUE_DATA_SIZE    (340u)
+    
+    /// The size of the raw receive queue that holds the bytes received by the
+    /// receive ISR until they are parsed by the main loop.
+    #define TRANSLATE_RAW_RX_QUEUE_SIZE     (256u)
+    
+#else
+    
+    /// The size of the data array that holds the queue element data in the
+    /// receive queue.
+    #define TRANSLATE_RX_QUEUE_DATA_SIZE    (600u)
+    
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
 
 /// The max size of the transmit queue (the max number of queue elements).
 #define TRANSLATE_TX_QUEUE_MAX_SIZE     (8u)
 
-/// The size of the data array that holds the queue element data in the
-/// transmit queue.
-#define TRANSLATE_TX_QUEUE_DATA_SIZE    (800u)
+/// The first command byte of the command table; the bridge commands are ASCII
+/// letters.
+#define COMMAND_TABLE_BASE              (0x40u)
+
+/// The number of command bytes in the command table (0x40-0x7f).
+#define COMMAND_TABLE_SIZE              (64u)
+
+/// The max number of command handlers registered with
+/// uart_registerCommandHandler.
+#define COMMAND_REGISTERED_MAX_COUNT    (4u)
+
+/// The max number of command handlers: the registered handlers followed by the
+/// built-in handlers (see G_CommandHandlers).
+#define COMMAND_HANDLER_MAX_COUNT       (COMMAND_REGISTERED_MAX_COUNT + 28u)
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// The max size of a report that's delta-encoded; the size of the largest
+    /// read from the I2C slave (TOUCH_RX_BUFFER_SIZE in the I2C module).
+    #define UART_DELTA_REPORT_MAX_SIZE      (260u)
+    
+    /// The number of reference reports kept for the delta encoding (one per
+    /// report command); each takes UART_DELTA_REPORT_MAX_SIZE bytes of the
+    /// transmit queue memory.
+    #define UART_DELTA_REFERENCE_COUNT      (1u)
+    
+    /// The default number of delta frames sent between keyframes.
+    #define UART_DELTA_KEYFRAME_INTERVAL    (32u)
+    
+    /// The number of bytes of the transmit queue memory used by the reference
+    /// reports.
+    #define TRANSLATE_DELTA_SIZE            (UART_DELTA_REPORT_MAX_SIZE * UART_DELTA_REFERENCE_COUNT)
+    
+    #if (I2C_SLAVE_COUNT > 1)
+        #error "uart.c: the delta reports only support one I2C slave (I2C_SLAVE_COUNT)."
+    #endif
+    
+#else
+    
+    /// No transmit queue memory is used by reference reports.
+    #define TRANSLATE_DELTA_SIZE            (0u)
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// The size of the data array that holds the queue element data in the
+    /// transmit queue. The elements are stored raw (command + payload) so this
+    /// fits two of the largest reports (260 bytes read from the I2C slave)
+    /// unless the memory holds the reference reports of the delta encoding.
+    #define TRANSLATE_TX_QUEUE_DATA_SIZE    (600u - TRANSLATE_DELTA_SIZE)
+    
+#else
+    
+    /// The size of the data array that holds the queue element data in the
+    /// transmit queue.
+    #define TRANSLATE_TX_QUEUE_DATA_SIZE    (800u - TRANSLATE_DELTA_SIZE)
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
 
 /// The max size of the receive queue (the max number of queue elements).
 #define UPDATE_RX_QUEUE_MAX_SIZE        (4u)
@@ -68,6 +156,43 @@
 /// for the change in the receive/transmit balance.
 #define UPDATE_TX_QUEUE_DATA_SIZE       (100u)
 
+/// The transmit FIFO level trigger; the transmit interrupt fires when there
+/// are fewer bytes than this in the transmit FIFO (see
+/// ENABLE_UART_TX_INTERRUPT). The transmit FIFO is 8 bytes deep so the
+/// interrupt refills 4 or more bytes at a time with 4 byte periods left to
+/// service it before the transmitter goes idle.
+#define UART_TX_FIFO_TRIGGER_LEVEL      (4u)
+
+/// The receive FIFO level trigger; the receive ISR fires when there are more
+/// bytes than this in the receive FIFO (see ENABLE_UART_RX_FIFO_TRIGGER). The
+/// receive FIFO is 8 bytes deep so this leaves 4 byte periods to service the
+/// interrupt before the receive FIFO overflows.
+#define UART_RX_FIFO_TRIGGER_LEVEL      (3u)
+
+/// The number of bytes of the CRC-16 frame trailer (big-endian); see
+/// BridgeCommand_Crc.
+#define FRAME_CRC_SIZE                  (2u)
+
+/// The COBS code of a block of 254 non-zero bytes that isn't followed by a
+/// zero byte; see Framing_Cobs.
+#define COBS_MAX_CODE                   (0xffu)
+
+/// The number of fractional bits of the host UART SCB clock divider (16.5
+/// fractional divider); the clock dividers are handled in 1/32 steps.
+#define UART_CLOCK_DIVIDER_FRACTION_BITS    (5u)
+
+/// Mask of the fractional bits of a host UART SCB clock divider.
+#define UART_CLOCK_DIVIDER_FRACTION_MASK    ((1u << UART_CLOCK_DIVIDER_FRACTION_BITS) - 1u)
+
+/// The number of system timer ticks (system clock cycles) per microsecond.
+#define TICKS_PER_US                        (CYDEV_BCLK__SYSCLK__KHZ / 1000u)
+
+/// Replicates a byte in all 4 bytes of a 32-bit word.
+#define SWAR_REPLICATE(x)               ((uint32_t)(x) * 0x01010101u)
+
+/// Non-zero if any of the 4 bytes of the 32-bit word x is 0.
+#define SWAR_HAS_ZERO_BYTE(x)           (((x) - SWAR_REPLICATE(0x01)) & ~(x) & SWAR_REPLICATE(0x80))
+
 /// Shift to get the next character when writing hex unsigned integers as ASCII
 /// characters.
 #define ASCII_HEX_CHAR_SHIFT            (4u)
@@ -102,9 +227,71 @@ typedef enum RxState
     /// Process the update packet's data (data to be sent to the slave device).
     RxState_UpdatePacketData,
     
+    /// COBS framing: wait for the code byte of the first block of a frame.
+    RxState_CobsStart,
+    
+    /// COBS framing: wait for the code byte of the next block of the frame;
+    /// the delimiter ends the frame.
+    RxState_CobsCode,
+    
+    /// COBS framing: process the data bytes of a block.
+    RxState_CobsData,
+    
 } RxState;
 
 
+/// States of the transmit stream that encodes (frames and escapes) the data of
+/// a transmit queue element as it's written to the UART.
+typedef enum TxState
+{
+    /// No transmit queue element is being sent.
+    TxState_Idle,
+    
+    /// Write the start frame control byte.
+    TxState_StartFrame,
+    
+    /// Write the escape character that precedes the command.
+    TxState_CommandEscape,
+    
+    /// Write the escaped escape character that precedes the command.
+    TxState_CommandEscapeData,
+    
+    /// Write the command.
+    TxState_Command,
+    
+    /// Write the payload; the payload bytes that are control bytes are
+    /// preceded by an escape character.
+    TxState_Payload,
+    
+    /// Write the payload byte that follows an escape character.
+    TxState_PayloadEscapeData,
+    
+    /// Write the CRC-16 trailer; the trailer bytes that are control bytes are
+    /// preceded by an escape character.
+    TxState_Crc,
+    
+    /// Write the CRC-16 trailer byte that follows an escape character.
+    TxState_CrcEscapeData,
+    
+    /// Write the end frame control byte.
+    TxState_EndFrame,
+    
+    /// COBS framing: write the code byte of the next block.
+    TxState_CobsCode,
+    
+    /// COBS framing: write the data bytes of the block.
+    TxState_CobsData,
+    
+    /// COBS framing: write the delimiter that ends the frame.
+    TxState_CobsDelimiter,
+    
+    /// Write the data as is; the data is either already encoded or must not
+    /// be framed.
+    TxState_Unframed,
+    
+} TxState;
+
+
 /// Defines the different control bytes in the protocol which helps define a
 /// data frame.
 typedef enum ControlByte
@@ -119,6 +306,9 @@ typedef enum ControlByte
     /// byte.
     ControlByte_Escape                  = 0x55,
     
+    /// Delimiter that ends a frame with COBS framing (see Framing_Cobs).
+    ControlByte_CobsDelimiter           = 0x00,
+    
 } ControlByte;
 
 
@@ -139,18 +329,46 @@ typedef enum BridgeCommand
     /// kept for backwards compatibility.
     BridgeCommand_SlaveUpdate           = 'B',
     
+    /// Enable/disable the CRC-16 frame trailer in both directions; see
+    /// processCrcCommand.
+    BridgeCommand_Crc                   = 'C',
+    
+    /// Delta encoding of the slave reports; see DeltaCommand.
+    BridgeCommand_Delta                 = 'D',
+    
     /// Global error mode and error reporting.
     BridgeCommand_Error                 = 'E',
     
+    /// I2C bus bit rate (SCL frequency); see I2cSpeedCommand.
+    BridgeCommand_I2cSpeed              = 'F',
+    
     /// Access the I2C slave address.
     BridgeCommand_SlaveAddress          = 'I',
     
+    /// Receive credit of the host UART link; see processCreditCommand.
+    BridgeCommand_Credit                = 'K',
+    
+    /// Scheduling policy between the I2C transfer lanes (slave IRQ reads and
+    /// host transfers); see processLanePolicyCommand.
+    BridgeCommand_LanePolicy            = 'L',
+    
+    /// Batch of I2C sub-commands executed in order; see processBatchCommand.
+    BridgeCommand_Batch                 = 'M',
+    
     /// Bridge to I2C slave NAK over I2C.
     BridgeCommand_SlaveNak              = 'N',
     
+    /// Report an I2C slave sent on its own; the first byte of the data payload
+    /// is the 7-bit address of the slave followed by the report. Only used with
+    /// more than one slave context (see I2C_SLAVE_COUNT).
+    BridgeCommand_SlaveReport           = 'P',
+    
     /// Bridge I2C read from I2C slave.
     BridgeCommand_SlaveRead             = 'R',
     
+    /// Bridge statistics (queue occupancy and failures); see StatsCommand.
+    BridgeCommand_Stats                 = 'S',
+    
     /// I2C communication timeout between bridge and I2C slave.
     BridgeCommand_SlaveTimeout          = 'T',
     
@@ -163,15 +381,40 @@ typedef enum BridgeCommand
     /// Bridge to I2C slave ACK over I2C.
     BridgeCommand_SlaveAck              = 'a',
     
+    /// Host UART baud rate; see BaudCommand.
+    BridgeCommand_Baud                  = 'b',
+    
+    /// Report of the slave sent in delta mode; see DeltaFrame.
+    BridgeCommand_DeltaReport           = 'd',
+    
+    /// Host UART framing protocol; see Framing.
+    BridgeCommand_Framing               = 'f',
+    
+    /// Enable/disable the sequence IDs of the frames in both directions; see
+    /// processSequenceCommand.
+    BridgeCommand_Sequence              = 'q',
+    
     /// Bridge reset.
     BridgeCommand_Reset                 = 'r',
     
+    /// Host UART receive frame timeout; see processRxTimeoutCommand.
+    BridgeCommand_RxTimeout             = 't',
+    
     /// Bridge version information; updated.
     BridgeCommand_Version               = 'v',
     
+    /// Bridge I2C write-read (repeated START) with the I2C slave; see
+    /// processSlaveWriteReadCommand.
+    BridgeCommand_SlaveWriteRead        = 'w',
+    
 } BridgeCommand;
 
 
+/// 32-bit word that may alias any other type; used to scan byte buffers a
+/// word at a time.
+typedef uint32_t __attribute__((may_alias)) swarWord_t;
+
+
 /// Enumeration that defines the offsets of different types of bytes within the
 /// UICO UART frame protocol data payload.
 typedef enum PacketOffset
@@ -182,6 +425,11 @@ typedef enum PacketOffset
     /// Offset in the data frame for the data payload.
     PacketOffset_BridgeData             = 1u,
     
+    /// Offset in the data frame for the sequence ID when sequence IDs are
+    /// enabled (see BridgeCommand_Sequence); the sequence ID is removed before
+    /// the other offsets apply.
+    PacketOffset_SequenceId             = 1u,
+    
     /// Offset in the data frame for the I2C address in I2C transactions (read,
     /// write, ACK).
     PacketOffset_I2cAddress             = 1u,
@@ -190,9 +438,273 @@ typedef enum PacketOffset
     /// write).
     PacketOffset_I2cData                = 2u,
     
+    /// Offset in the data frame for the data to write in I2C write-read
+    /// transactions; the number of bytes to read is at PacketOffset_I2cData.
+    PacketOffset_I2cWriteReadData       = 3u,
+    
 } PacketOffset;
 
 
+/// Sub-commands of the BridgeCommand_Stats bridge command; the sub-command is
+/// the first byte of the data payload and is echoed in the response.
+typedef enum StatsCommand
+{
+    /// Report the statistics of the decoded receive, transmit and I2C transfer
+    /// queues (in that order). Each queue reports, big-endian: peak number of
+    /// elements (1), max number of elements (1), peak data bytes (2), data
+    /// array size (2), enqueue failures (2), enqueued bytes (4) and dequeued
+    /// bytes (4).
+    StatsCommand_Queue                  = 0u,
+    
+    /// Reset the statistics of the queues.
+    StatsCommand_ResetQueue             = 1u,
+    
+    /// Report the receive statistics; big-endian: ISR entries (4), bytes
+    /// received (4), system clock cycles spent in the receive ISR (4), frame
+    /// errors (2), receive FIFO overflows (2), raw receive queue overflows (2),
+    /// CRC-16 errors (2) and receive timeout resynchronizations (2).
+    StatsCommand_Rx                     = 2u,
+    
+    /// Reset the receive statistics.
+    StatsCommand_ResetRx                = 3u,
+    
+    /// Report the statistics of the bridge commands invoked since the last
+    /// reset (ENABLE_UART_COMMAND_STATS); for each command in command order,
+    /// big-endian: command (1), invocations (4) and system clock cycles spent
+    /// in the handler (4).
+    StatsCommand_Commands               = 4u,
+    
+    /// Reset the statistics of the bridge commands.
+    StatsCommand_ResetCommands          = 5u,
+    
+    /// Report the counters of the I2C transfer lanes (slave IRQ reads and host
+    /// transfers, in that order). Each lane reports, big-endian: transactions
+    /// serviced (4) and times deferred for the other lane (4).
+    StatsCommand_Lanes                  = 6u,
+    
+    /// Reset the counters of the I2C transfer lanes.
+    StatsCommand_ResetLanes             = 7u,
+    
+} StatsCommand;
+
+
+/// Sub-commands of the BridgeCommand_Baud bridge command; the sub-command is
+/// the first byte of the data payload. The response echoes the sub-command
+/// followed by the baud rate (big-endian, 4 bytes) that applies once the
+/// command is complete.
+typedef enum BaudCommand
+{
+    /// Report the current baud rate.
+    BaudCommand_Get                     = 0u,
+    
+    /// Switch to the baud rate that follows the sub-command (big-endian, 4
+    /// bytes). The response is sent at the current baud rate and reports the
+    /// baud rate generated by the SCB clock (the current baud rate if the
+    /// requested one can't be generated); the bridge switches once the
+    /// response is sent. The host must then send BaudCommand_Commit at the new
+    /// baud rate within G_BaudCommitTimeoutMs or the bridge rolls back.
+    BaudCommand_Switch                  = 1u,
+    
+    /// Commit the baud rate switch.
+    BaudCommand_Commit                  = 2u,
+    
+} BaudCommand;
+
+
+/// Defines the offsets in the data payload of the BridgeCommand_Baud command.
+typedef enum BaudOffset
+{
+    /// Offset for the sub-command; see BaudCommand.
+    BaudOffset_Command                  = 0u,
+    
+    /// Offset for the baud rate. Note this is a big-endian 32-bit value.
+    BaudOffset_BaudRate                 = 1u,
+    
+    /// The size of the data payload with the baud rate.
+    BaudOffset_End                      = 5u,
+    
+} BaudOffset;
+
+
+/// Sub-commands of the BridgeCommand_I2cSpeed bridge command; the sub-command
+/// is the first byte of the data payload. The response echoes the sub-command
+/// followed by the active I2C bit rate (big-endian, 4 bytes).
+typedef enum I2cSpeedCommand
+{
+    /// Report the active bit rate.
+    I2cSpeedCommand_Get                 = 0u,
+    
+    /// Switch to the bit rate that follows the sub-command (big-endian, 4
+    /// bytes): 100000, 400000 or 1000000 (see i2c_setBitRate). Fails if the
+    /// bit rate isn't supported or an I2C transfer is in progress.
+    I2cSpeedCommand_Set                 = 1u,
+    
+    /// Save the active bit rate in flash as the bit rate applied at startup.
+    /// The bridge doesn't service the host UART during the flash write so the
+    /// host must wait for the response before sending the next frame.
+    I2cSpeedCommand_Save                = 2u,
+    
+} I2cSpeedCommand;
+
+
+/// Defines the offsets in the data payload of the BridgeCommand_I2cSpeed
+/// command.
+typedef enum I2cSpeedOffset
+{
+    /// Offset for the sub-command; see I2cSpeedCommand.
+    I2cSpeedOffset_Command              = 0u,
+    
+    /// Offset for the bit rate. Note this is a big-endian 32-bit value.
+    I2cSpeedOffset_BitRate              = 1u,
+    
+    /// The size of the data payload with the bit rate.
+    I2cSpeedOffset_End                  = 5u,
+    
+} I2cSpeedOffset;
+
+
+/// Defines the offsets in the data payload of the BridgeCommand_LanePolicy
+/// command.
+typedef enum LanePolicyOffset
+{
+    /// Offset for the scheduling policy; see I2cLanePolicy.
+    LanePolicyOffset_Policy             = 0u,
+    
+    /// Offset for the number of consecutive slave IRQ reads before the host
+    /// lane gets a turn (weighted round-robin).
+    LanePolicyOffset_SlaveIrqWeight     = 1u,
+    
+    /// Offset for the number of consecutive host transfers before the slave
+    /// IRQ lane gets a turn (weighted round-robin).
+    LanePolicyOffset_HostWeight         = 2u,
+    
+    /// The size of the data payload that sets the policy.
+    LanePolicyOffset_End                = 3u,
+    
+} LanePolicyOffset;
+
+
+/// Defines the states of a baud rate switch.
+typedef enum BaudState
+{
+    /// No baud rate switch in progress.
+    BaudState_Idle,
+    
+    /// The switch response is being sent at the current baud rate.
+    BaudState_SwitchPending,
+    
+    /// Switched; waiting for the host to commit the new baud rate.
+    BaudState_CommitPending,
+    
+} BaudState;
+
+
+/// Defines the framing protocols of the host UART frames; the framing is
+/// selected with the BridgeCommand_Framing bridge command.
+typedef enum Framing
+{
+    /// The frames start and end with the 0xaa control byte and the control
+    /// bytes in the frame are preceded by the 0x55 escape character; the
+    /// frames sent by the bridge precede the command with two escape
+    /// characters. A frame may double in size.
+    Framing_Escape                      = 0u,
+    
+    /// Consistent Overhead Byte Stuffing: the frame (command, payload and
+    /// CRC-16 trailer) is split into blocks at the zero bytes; each block
+    /// starts with a code byte (the block size + 1) instead of the zero byte.
+    /// The frames end with the 0x00 delimiter. The frames sent by the bridge
+    /// always start with the command; data frames with BridgeCommand_None.
+    /// A frame grows by at most 1 byte per 254 bytes plus the delimiter.
+    Framing_Cobs                        = 1u,
+    
+} Framing;
+
+
+/// Sub-commands of the BridgeCommand_Delta bridge command; the sub-command is
+/// the first byte of the data payload. The response echoes the sub-command
+/// followed by the delta mode (1 byte: enabled) and the keyframe interval
+/// (1 byte) that apply once the command is complete.
+typedef enum DeltaCommand
+{
+    /// Report the delta mode.
+    DeltaCommand_Get                    = 0u,
+    
+    /// Enable the delta mode: the reports the slave sends on its own are sent
+    /// in BridgeCommand_DeltaReport frames. The optional byte that follows is
+    /// the number of delta frames sent between keyframes (0: no periodic
+    /// keyframes); UART_DELTA_KEYFRAME_INTERVAL by default.
+    DeltaCommand_Enable                 = 1u,
+    
+    /// Disable the delta mode; the reports are sent in data frames again.
+    DeltaCommand_Disable                = 2u,
+    
+    /// Drop the reference reports; the next report of each report command is
+    /// sent as a keyframe. The host resynchronizes this way after it lost a
+    /// frame.
+    DeltaCommand_Resync                 = 3u,
+    
+} DeltaCommand;
+
+
+/// Defines the type of a BridgeCommand_DeltaReport frame; the type is the first
+/// byte of the data payload.
+typedef enum DeltaFrame
+{
+    /// The full report follows; it becomes the reference report of its report
+    /// command (the first byte of the report).
+    DeltaFrame_Keyframe                 = 0u,
+    
+    /// The report command (1 byte) follows and then the report XORed with the
+    /// reference report of the report command, run-length encoded: pairs of
+    /// the number of zero bytes (1 byte) and the number of literal bytes (1
+    /// byte) followed by the literal bytes. The trailing zero bytes are
+    /// omitted; the report has the size of the reference report.
+    DeltaFrame_Delta                    = 1u,
+    
+} DeltaFrame;
+
+
+/// Defines the offsets in the data payload of the BridgeCommand_Credit frames.
+typedef enum CreditOffset
+{
+    /// Offset for the number of frames received (big-endian, 2 bytes); see
+    /// processCreditCommand.
+    CreditOffset_FrameCount             = 0u,
+    
+    /// Offset for the number of free decoded receive queue elements.
+    CreditOffset_FreeFrames             = 2u,
+    
+    /// Offset for the number of free bytes (big-endian, 2 bytes).
+    CreditOffset_FreeBytes              = 3u,
+    
+    /// The size of the data payload.
+    CreditOffset_End                    = 5u,
+    
+} CreditOffset;
+
+
+/// Defines the result of a BridgeCommand_Batch command; the result follows the
+/// number of sub-commands executed in the response.
+typedef enum BatchStatus
+{
+    /// All the sub-commands were executed.
+    BatchStatus_Complete                = 0u,
+    
+    /// The next sub-command is truncated, malformed or isn't allowed in a
+    /// batch; the rest of the batch is dropped.
+    BatchStatus_InvalidSubcommand       = 1u,
+    
+    /// The next sub-command failed (the I2C error is also reported like for
+    /// the standalone command); the rest of the batch is dropped.
+    BatchStatus_I2cError                = 2u,
+    
+    /// The transfer queue didn't have room for the next sub-command within
+    /// G_BatchStallTimeoutMs; the rest of the batch is dropped.
+    BatchStatus_Stalled                 = 3u,
+    
+} BatchStatus;
+
+
 /// Enumeration that defines the offsets of the different slave update settings
 /// in the data payload of the Bridgecommand_SlaveUpdate command.
 typedef enum UpdateOffset
@@ -420,19 +932,25 @@ typedef enum UpdateState
 } UpdateState;
 
 
-/// Settings pertaining to the transmit enqueue.
-typedef struct TxEnqueueSettings
+/// Region reserved in the transmit queue for a frame whose payload is built in
+/// place (see txReserve and txCommit).
+typedef struct TxReservation
 {
-    /// The bridge command associated with the transmit enqueue.
-    BridgeCommand command;
+    /// Start of the reserved region; the transmit queue element is written
+    /// here.
+    uint8_t* frame;
+    
+    /// Where the raw (not yet encoded) payload must be written.
+    uint8_t* payload;
     
-    /// Flag indicating if the transmit enqueue contains a command.
-    bool commandFlag : 1;
+    /// The maximum number of bytes in the payload.
+    uint16_t maxPayloadSize;
     
-    /// Flag indicating if the transmit enqueue contains data.
-    bool dataFlag : 1;
+    /// Flag indicating the sequence ID precedes the payload (see
+    /// BridgeCommand_Sequence).
+    bool sequenced;
     
-} TxEnqueueSettings;
+} TxReservation;
 
 
 /// Union that represents a bit-mask of different flags associated with the
@@ -569,10 +1087,70 @@ typedef struct Heap
     
     /// Transmit queue.
     Queue txQueue;
+
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    
+    /// Raw receive queue; the receive ISR is the producer and the main loop is
+    /// the consumer. Only used in translate mode.
+    volatile ByteQueue rawRxQueue;
+
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
     
 } Heap;
 
 
+/// Defines a handler of the command table (see processDecodedRxPacket).
+typedef struct CommandHandler
+{
+    /// The function that processes the data payload of the command.
+    UartCommandHandler handler;
+    
+    /// The bridge command.
+    uint8_t command;
+    
+    /// The min size of the data payload; shorter commands are dropped without
+    /// invoking the handler.
+    uint8_t minSize;
+    
+} CommandHandler;
+
+
+#if ENABLE_UART_COMMAND_STATS
+    
+    /// Statistics of a command handler.
+    typedef struct CommandStats
+    {
+        /// The number of times the handler was invoked.
+        uint32_t count;
+        
+        /// The number of system clock cycles spent in the handler.
+        uint32_t ticks;
+        
+    } CommandStats;
+    
+#endif // ENABLE_UART_COMMAND_STATS
+
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// Reference report of the delta encoding: the last report of a report
+    /// command sent to the host.
+    typedef struct DeltaReference
+    {
+        /// The reference report.
+        uint8_t data[UART_DELTA_REPORT_MAX_SIZE];
+        
+        /// The size of the reference report; 0 if there's no reference report.
+        uint16_t size;
+        
+        /// The number of delta frames sent since the last keyframe.
+        uint8_t deltaCount;
+        
+    } DeltaReference;
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+
 /// Data extension for the Heap structure. Defines the data buffers when in the
 /// translate mode.
 typedef struct TranslateHeapData
@@ -589,6 +1167,20 @@ typedef struct TranslateHeapData
     
     /// Array to hold the data of the elements in the transmit queue.
     uint8_t txQueueData[TRANSLATE_TX_QUEUE_DATA_SIZE];
+
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    
+    /// Array to hold the raw received bytes in the raw receive queue.
+    uint8_t rawRxQueueData[TRANSLATE_RAW_RX_QUEUE_SIZE];
+
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// The reference reports of the delta encoding.
+    DeltaReference deltaReferences[UART_DELTA_REFERENCE_COUNT];
+
+#endif // ENABLE_UART_TX_DELTA_REPORTS
     
 } TranslateHeapData;
 
@@ -619,8 +1211,178 @@ typedef struct UpdateHeapData
 } UpdateHeapData;
 
 
+/// Receive statistics used to verify the cost of the receive ISR.
+typedef struct RxStats
+{
+    /// The number of times the receive ISR was entered.
+    uint32_t isrCount;
+    
+    /// The number of bytes read from the receive FIFO.
+    uint32_t byteCount;
+    
+    /// The number of system clock cycles spent in the receive ISR.
+    uint32_t isrTicks;
+    
+    /// The number of frame errors.
+    uint16_t frameErrors;
+    
+    /// The number of receive FIFO overflows.
+    uint16_t overflows;
+    
+    /// The number of received bytes dropped because the raw receive queue was
+    /// full (see ENABLE_UART_RX_DEFERRED_PARSING).
+    uint16_t rawOverflows;
+    
+    /// The number of received frames dropped because the CRC-16 trailer
+    /// didn't match (see BridgeCommand_Crc).
+    uint16_t crcErrors;
+    
+    /// The number of partial frames discarded because the receive line was
+    /// idle for the receive frame timeout (see BridgeCommand_RxTimeout).
+    uint16_t resyncs;
+    
+} RxStats;
+
+
+/// State of the transmit stream. The transmit queue element at the head of
+/// the transmit queue is read in place and only dequeued once all its bytes
+/// have been written to the UART.
+typedef struct TxStream
+{
+    /// The next data byte of the transmit queue element to write.
+    uint8_t const* data;
+    
+    /// The number of data bytes of the transmit queue element left to write.
+    uint16_t size;
+    
+    /// The number of transmit queue elements sent; only modified by the
+    /// transmitter.
+    uint16_t sentCount;
+    
+    /// The number of sent transmit queue elements already reported by
+    /// uartTranslate_processTx; only modified by the main loop.
+    uint16_t reportedCount;
+    
+    /// The command of the transmit queue element.
+    uint8_t command;
+    
+    /// The current state of the transmit stream.
+    TxState state;
+    
+    /// If the CRC-16 trailer is added to the frame.
+    bool crcEnabled;
+    
+    /// The CRC-16 of the frame so far.
+    uint16_t crc;
+    
+    /// The CRC-16 trailer of the frame (big-endian).
+    uint8_t crcTrailer[FRAME_CRC_SIZE];
+    
+    /// If set, the transmit stream stops before it loads the next transmit
+    /// queue element once sentCount reaches holdCount.
+    bool hold;
+    
+    /// The sentCount at which the transmit stream stops if hold is set.
+    uint16_t holdCount;
+    
+    /// COBS framing: the code of the block being written.
+    uint8_t cobsCode;
+    
+    /// COBS framing: the number of data bytes of the block left to write.
+    uint8_t cobsSize;
+    
+    /// COBS framing: if data points to the CRC-16 trailer.
+    bool cobsTrailer;
+    
+} TxStream;
+
+
+/// State of the host UART baud rate; see BridgeCommand_Baud.
+typedef struct BaudSwitch
+{
+    /// Alarm that rolls back a baud rate switch the host doesn't commit.
+    Alarm commitAlarm;
+    
+    /// The current SCB clock divider in 1/32 steps.
+    uint32_t divider;
+    
+    /// The SCB clock divider to restore if the switch isn't committed.
+    uint32_t previousDivider;
+    
+    /// The SCB clock divider to switch to once the switch response is sent.
+    uint32_t pendingDivider;
+    
+    /// The state of the baud rate switch.
+    BaudState state;
+
+#if ENABLE_UART_AUTO_BAUD
+    
+    /// The number of receive frame errors at the last auto-baud check.
+    uint16_t frameErrors;
+    
+    /// The number of valid frames received at the last auto-baud check.
+    uint16_t frameCount;
+    
+    /// The number of receive frame errors since the last valid frame.
+    uint16_t errorCount;
+    
+    /// The index in G_AutoBaudRates of the last auto-baud candidate.
+    uint8_t autoBaudIndex;
+
+#endif // ENABLE_UART_AUTO_BAUD
+    
+} BaudSwitch;
+
+
+/// State of the BridgeCommand_Batch command being executed; a batch pauses
+/// while the I2C transfer queue is full and resumes from the next sub-command.
+typedef struct Batch
+{
+    /// Alarm that aborts a batch that can't make progress.
+    Alarm stallAlarm;
+    
+    /// The offset of the next sub-command in the data payload.
+    uint16_t offset;
+    
+    /// The number of sub-commands executed.
+    uint16_t count;
+    
+    /// Flag indicating the batch is paused; the decoded receive queue element
+    /// is kept until the batch completes.
+    bool paused;
+    
+    /// Flag indicating a sub-command is being executed.
+    bool executing;
+    
+} Batch;
+
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// State of the delta encoding of the slave reports (see
+    /// BridgeCommand_Delta).
+    typedef struct Delta
+    {
+        /// The reference reports; NULL in update mode.
+        DeltaReference* references;
+        
+        /// The number of delta frames sent between keyframes; 0 if there are
+        /// no periodic keyframes.
+        uint8_t keyframeInterval;
+        
+        /// The index of the reference report replaced next.
+        uint8_t nextReference;
+        
+        /// Flag indicating the delta mode is enabled.
+        bool enabled;
+        
+    } Delta;
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+
 /// Structure used to define the memory allocation of the heap + associated
-/// heap data in translate mode. Only used to determine the organization of the
+/// heap data in translate mode.Only used to determine the organization of the
 /// two data structures in unallocated memory to ensure alignment.
 typedef struct TranslateHeap
 {
@@ -649,21 +1411,87 @@ typedef struct UpdateHeap
 
 // === PRIVATE GLOBAL CONSTANTS ================================================
 
-/// Size (in bytes) for scratch buffers.
-static uint8_t const G_ScratchSize = 16u;
+/// The maximum size (in bytes) of an error message payload.
+static uint8_t const G_MaxErrorMessageSize = 16u;
 
-/// The amount of time between receipts of bytes before we automatically reset
-/// the receive state machine.
-static uint16_t const G_RxResetTimeoutMs = 2000u;
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// The command stored in a transmit queue element whose payload is written
+    /// as is, without framing. The start frame control byte can never be a
+    /// bridge command.
+    static uint8_t const G_TxUnframedCommand = ControlByte_StartFrame;
+    
+#else
+    
+    /// The maximum number of bytes a transmit frame adds to its payload: the
+    /// start frame byte, the command (escape, escape, command), the CRC-16
+    /// trailer (each byte may be escaped) and the end frame byte.
+    static uint8_t const G_TxFrameOverhead = 5u + (FRAME_CRC_SIZE << 1);
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
 
-/// ASCII hex table for writing hex unsigned integers as ASCII characters.
-static char const G_AsciiHexTable[] = "0123456789abcdef";
+/// The number of bytes to report the statistics of one queue.
+static uint8_t const G_QueueStatsSize = 16u;
 
-/// Valid code indicating the packet is meant for the bootloader.
-static uint8_t const G_UpdateCode = 0xff;
+/// The number of queues that report statistics.
+static uint8_t const G_QueueStatsCount = 3u;
 
-/// Valid key indicating that the packet is meant for the bootloader.
-static uint8_t const G_UpdateKey[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+#if ENABLE_UART_COMMAND_STATS
+    
+    /// The number of bytes to report the statistics of one command.
+    static uint8_t const G_CommandStatsSize = 9u;
+    
+#endif // ENABLE_UART_COMMAND_STATS
+
+/// The number of bytes to report the receive statistics.
+static uint8_t const G_RxStatsSize = 23u;
+
+/// The number of bytes to report the counters of one I2C transfer lane.
+static uint8_t const G_LaneStatsSize = 8u;
+
+/// The amount of time the host has to commit a baud rate switch before the
+/// bridge rolls back to the previous baud rate.
+static uint16_t const G_BaudCommitTimeoutMs = 1000u;
+
+/// The generated baud rate must be within 1/G_BaudRateErrorRatio (2%) of the
+/// requested baud rate.
+static uint8_t const G_BaudRateErrorRatio = 50u;
+
+/// The number of bits of a UART character: start bit, 8 data bits and stop
+/// bit.
+static uint8_t const G_UartCharacterBits = 10u;
+
+#if ENABLE_UART_AUTO_BAUD
+    
+    /// The number of receive frame errors without a valid frame in between
+    /// that make the auto-baud detection try the next baud rate.
+    static uint8_t const G_AutoBaudErrorThreshold = 3u;
+    
+    /// The baud rates tried by the auto-baud detection in order; the baud rates
+    /// the SCB clock can't generate are skipped.
+    static uint32_t const G_AutoBaudRates[] = { 115200u, 230400u, 460800u, 921600u, 1000000u, 2000000u, 3000000u };
+    
+#endif // ENABLE_UART_AUTO_BAUD
+
+/// The maximum receive frame timeout in microseconds.
+static uint32_t const G_RxTimeoutMaxUs = 1000000u;
+
+/// The amount of time a batch may wait for room in the I2C transfer queue
+/// before it's aborted.
+static uint16_t const G_BatchStallTimeoutMs = 100u;
+
+/// The sequence ID of the frames the bridge sends on its own (the slave IRQ
+/// reads); the host must not use it for its requests.
+static uint8_t const G_UnsolicitedSequenceId = 0u;
+
+/// ASCII hex table for writing hex unsigned integers as ASCII characters.
+static char const G_AsciiHexTable[] = "0123456789abcdef";
+
+/// Valid code indicating the packet is meant for the bootloader.
+static uint8_t const G_UpdateCode = 0xff;
+
+/// Valid key indicating that the packet is meant for the bootloader.
+static uint8_t const G_UpdateKey[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
 
 /// The default UpdateStatus with no error flags set.
 UpdateStatus const G_NoErrorUpdateStatus = { 0u };
@@ -681,11 +1509,22 @@ static UpdateFile g_updateFile = { NULL, NULL, 0, 0, 0, 0, 0, 0 };
 /// frame.
 static volatile RxState g_rxState = RxState_OutOfFrame;
 
-/// The last time data was received in milliseconds.
-static volatile uint32_t g_lastRxTimeMs = 0u;
+/// The timestamp (see hwSystemTime_getTimestamp) when the receive FIFO was last
+/// drained after receiving bytes. This needs to be volatile because it's
+/// modified in an ISR.
+static volatile uint32_t g_lastRxTicks = 0u;
+
+/// Flag indicating that the receive line was idle for the receive frame
+/// timeout since the last byte was received. This needs to be volatile because
+/// it's modified in an ISR.
+static volatile bool g_rxIdle = false;
 
-/// Settings associated with the pending transmit enqueue.
-static TxEnqueueSettings g_pendingTxEnqueue = { BridgeCommand_None, false, false };
+/// The receive frame timeout in microseconds; 0 if disabled.
+static uint32_t g_rxTimeoutUs = UART_RX_FRAME_TIMEOUT_US;
+
+/// The receive frame timeout in ticks (system clock cycles). This needs to be
+/// volatile because it's read in an ISR.
+static volatile uint32_t g_rxTimeoutTicks = UART_RX_FRAME_TIMEOUT_US * TICKS_PER_US;
 
 /// Callback function that is invoked when data is received out of the frame
 /// state machine.
@@ -699,6 +1538,145 @@ static UartRxFrameOverflowCallback g_rxFrameOverflowCallback = NULL;
 /// to help identify where an error may have occurred.
 static Callsite g_uartCallsite = { 0u };
 
+/// The receive statistics. This needs to be volatile because it's modified in
+/// an ISR.
+static volatile RxStats g_rxStats = { 0u };
+
+/// The state of the transmit stream. This needs to be volatile because it's
+/// modified in an ISR (see ENABLE_UART_TX_INTERRUPT).
+static volatile TxStream g_txStream = { NULL, 0u, 0u, 0u, BridgeCommand_None, TxState_Idle, false, 0u, { 0u }, false, 0u, 0u, 0u, false };
+
+/// The state of the host UART baud rate.
+static BaudSwitch g_baud;
+
+/// The state of the batch being executed.
+static Batch g_batch;
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// The state of the delta encoding of the slave reports.
+    static Delta g_delta;
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+/// The command table: maps the command byte (offset by COMMAND_TABLE_BASE) to
+/// the handler number + 1 (see getCommandHandler); 0 if there's no handler.
+static uint8_t g_commandTable[COMMAND_TABLE_SIZE];
+
+/// The command handlers registered with uart_registerCommandHandler; they take
+/// the place of the built-in handlers of their commands.
+static CommandHandler g_registeredCommandHandlers[COMMAND_REGISTERED_MAX_COUNT];
+
+#if ENABLE_UART_COMMAND_STATS
+    
+    /// The statistics of the command handlers by handler number.
+    static CommandStats g_commandStats[COMMAND_HANDLER_MAX_COUNT];
+    
+#endif // ENABLE_UART_COMMAND_STATS
+
+/// Flag indicating the frames carry a sequence ID after the command; see
+/// BridgeCommand_Sequence.
+static bool g_sequenceEnabled = false;
+
+/// The sequence ID of the frames being enqueued: the sequence ID of the request
+/// being processed or of the I2C transfer being reported.
+static uint8_t g_txSequenceId = 0u;
+
+/// The number of frames received up to their end of frame (wraps around),
+/// whether they were added to the decoded receive queue or dropped. This needs
+/// to be volatile because it's modified in an ISR.
+static volatile uint16_t g_rxCreditFrameCount = 0u;
+
+/// Flag indicating a credit frame is sent whenever receive credit was
+/// released; see BridgeCommand_Credit.
+static bool g_creditReportEnabled = false;
+
+/// Flag indicating receive credit was released since the last credit frame.
+/// This needs to be volatile because it's modified in an ISR.
+static volatile bool g_creditReportPending = false;
+
+/// Flag indicating that the received frames have a CRC-16 trailer. This needs
+/// to be volatile because it's read in an ISR.
+static volatile bool g_rxCrcEnabled = false;
+
+/// The CRC-16 of the frame being received. This needs to be volatile because
+/// it's modified in an ISR.
+static volatile uint16_t g_rxCrc = CRC16_INITIAL_VALUE;
+
+/// Flag indicating that the transmitted frames have a CRC-16 trailer. This
+/// needs to be volatile because it's read in an ISR.
+static volatile bool g_txCrcEnabled = false;
+
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// The CRC-16 trailer setting for the transmitted frames that takes effect
+    /// once the BridgeCommand_Crc response is sent. This needs to be volatile
+    /// because it's read in an ISR.
+    static volatile bool g_txCrcRequested = false;
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+
+/// The framing protocol of the received frames. This needs to be volatile
+/// because it's read in an ISR.
+static volatile Framing g_rxFraming = Framing_Escape;
+
+/// COBS framing: the code of the block being received. This needs to be
+/// volatile because it's modified in an ISR.
+static volatile uint8_t g_rxCobsCode = 0u;
+
+/// COBS framing: the number of data bytes of the block left to receive. This
+/// needs to be volatile because it's modified in an ISR.
+static volatile uint8_t g_rxCobsSize = 0u;
+
+/// The framing protocol of the transmitted frames. This needs to be volatile
+/// because it's read in an ISR.
+static volatile Framing g_txFraming = Framing_Escape;
+
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// The framing protocol of the transmitted frames that takes effect once
+    /// the BridgeCommand_Framing response is sent. This needs to be volatile
+    /// because it's read in an ISR.
+    static volatile Framing g_txFramingRequested = Framing_Escape;
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+
+#if ENABLE_UART_AUTO_BAUD
+    
+    /// The number of valid frames received; used by the auto-baud detection.
+    /// This needs to be volatile because it's modified in an ISR.
+    static volatile uint16_t g_rxFrameCount = 0u;
+    
+#endif // ENABLE_UART_AUTO_BAUD
+
+#if ENABLE_UART_RTS
+    
+    /// Flag indicating RTS is asserted (the host may send). This needs to be
+    /// volatile because it's modified in an ISR.
+    static volatile bool g_rtsAsserted = true;
+    
+#endif // ENABLE_UART_RTS
+
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    
+    /// Flag indicating that received bytes were dropped because the raw
+    /// receive queue was full. While set, the receive ISR drops all received
+    /// bytes so the bytes in the raw receive queue all precede the dropped
+    /// bytes. This needs to be volatile because it's modified in an ISR.
+    static volatile bool g_rawRxOverflowed = false;
+    
+    /// Flag indicating that the receive state machine resynchronizes once the
+    /// main loop parses the raw receive queue up to g_rxResyncPosition. This
+    /// needs to be volatile because it's modified in an ISR.
+    static volatile bool g_rxResyncPending = false;
+    
+    /// The raw receive queue position (see byteQueue_getTail) where the
+    /// receive line was idle for the receive frame timeout. This needs to be
+    /// volatile because it's modified in an ISR.
+    static volatile uint16_t g_rxResyncPosition = 0u;
+    
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+
 
 // === PRIVATE FUNCTIONS =======================================================
 
@@ -736,20 +1714,11 @@ static void resetUpdateChunk(void)
 }
 
 
-/// Sets all the global variables pertaining to the decoded receive buffer to
-/// an initial state.
+/// Restarts the receive frame timeout as if a byte was just received.
 static void resetRxTime(void)
 {
-    g_lastRxTimeMs = hwSystemTime_getCurrentMs();
-}
-
-
-/// Resets the variables associated with the pending transmit enqueue.
-static void resetPendingTxEnqueue(void)
-{
-    g_pendingTxEnqueue.command = BridgeCommand_None;
-    g_pendingTxEnqueue.commandFlag = false;
-    g_pendingTxEnqueue.dataFlag = false;
+    g_lastRxTicks = hwSystemTime_getTimestamp();
+    g_rxIdle = false;
 }
 
 
@@ -791,6 +1760,116 @@ static bool requiresEscapeCharacter(uint8_t data)
 }
 
 
+/// Find the first byte in the source that requires an escape character. Once
+/// the source is word-aligned, it is scanned a word at a time (SWAR) since
+/// most data (like touch reports) rarely has bytes that require an escape
+/// character. Note that the frame control bytes are all either 0xaa or 0x55.
+/// @param[in]  source  The source buffer.
+/// @param[in]  size    The number of bytes in the source.
+/// @return The offset of the first byte that requires an escape character; if
+///         none of the bytes require an escape character, then size.
+static uint16_t findEscapeOffset(uint8_t const source[], uint16_t size)
+{
+    uint16_t offset = 0;
+
+#if ENABLE_UART_TX_SWAR_ESCAPE_SCAN
+    static uint32_t const StartFrameWord = SWAR_REPLICATE(ControlByte_StartFrame);
+    static uint32_t const EscapeWord = SWAR_REPLICATE(ControlByte_Escape);
+    
+    // Scan byte-by-byte up to the first word boundary; the Cortex-M0 does not
+    // support unaligned word loads.
+    while ((offset < size) && ((((uintptr_t)&source[offset]) & (sizeof(uint32_t) - 1u)) != 0))
+    {
+        if (requiresEscapeCharacter(source[offset]))
+            return offset;
+        offset++;
+    }
+    
+    // Skip the whole words that don't require an escape character.
+    while ((offset + sizeof(uint32_t)) <= size)
+    {
+        uint32_t word = *(swarWord_t const*)&source[offset];
+        if (SWAR_HAS_ZERO_BYTE(word ^ StartFrameWord) || SWAR_HAS_ZERO_BYTE(word ^ EscapeWord))
+            break;
+        offset += sizeof(uint32_t);
+    }
+#endif // ENABLE_UART_TX_SWAR_ESCAPE_SCAN
+    
+    while ((offset < size) && !requiresEscapeCharacter(source[offset]))
+        offset++;
+    return offset;
+}
+
+
+/// Get the oversampling factor of the host UART: the number of SCB clock
+/// cycles per bit.
+/// @return The oversampling factor.
+static uint32_t getUartOversampling(void)
+{
+    return (COMPONENT(HOST_UART, CTRL_REG) & COMPONENT(HOST_UART, CTRL_OVS_MASK)) + 1u;
+}
+
+
+/// Get the SCB clock divider of the host UART.
+/// @return The SCB clock divider in 1/32 steps.
+static uint32_t getUartClockDivider(void)
+{
+    uint32_t divider = (uint32_t)COMPONENT(HOST_UART, SCBCLK_GetDividerRegister)() + 1u;
+    return (divider << UART_CLOCK_DIVIDER_FRACTION_BITS) + COMPONENT(HOST_UART, SCBCLK_GetFractionalDividerRegister)();
+}
+
+
+/// Calculates the baud rate generated by an SCB clock divider.
+/// @param[in]  divider The SCB clock divider in 1/32 steps.
+/// @return The baud rate.
+static uint32_t calculateBaudRate(uint32_t divider)
+{
+    return ((uint32_t)CYDEV_BCLK__HFCLK__HZ << UART_CLOCK_DIVIDER_FRACTION_BITS) / (divider * getUartOversampling());
+}
+
+
+/// Calculates the SCB clock divider that generates a baud rate. The
+/// oversampling factor of the design is kept.
+/// @param[in]  baudRate    The baud rate.
+/// @return The SCB clock divider in 1/32 steps; 0 if the baud rate can't be
+///         generated within 1/G_BaudRateErrorRatio.
+static uint32_t calculateClockDivider(uint32_t baudRate)
+{
+    uint32_t divider = 0;
+    if ((baudRate > 0) && (baudRate <= CYDEV_BCLK__HFCLK__HZ))
+    {
+        uint32_t bitClock = baudRate * getUartOversampling();
+        divider = (((uint32_t)CYDEV_BCLK__HFCLK__HZ << UART_CLOCK_DIVIDER_FRACTION_BITS) + (bitClock >> 1)) / bitClock;
+        uint32_t integer = divider >> UART_CLOCK_DIVIDER_FRACTION_BITS;
+        if ((integer < 1u) || (integer > (UINT16_MAX + 1u)))
+            divider = 0;
+        else
+        {
+            uint32_t actualBaudRate = calculateBaudRate(divider);
+            uint32_t error = (actualBaudRate > baudRate) ? (actualBaudRate - baudRate) : (baudRate - actualBaudRate);
+            if ((error * G_BaudRateErrorRatio) > baudRate)
+                divider = 0;
+        }
+    }
+    return divider;
+}
+
+
+/// Switches the host UART to an SCB clock divider (baud rate).
+/// @param[in]  divider The SCB clock divider in 1/32 steps.
+static void applyClockDivider(uint32_t divider)
+{
+    COMPONENT(HOST_UART, DisableInt)();
+    COMPONENT(HOST_UART, SCBCLK_Stop)();
+    COMPONENT(HOST_UART, SCBCLK_SetFractionalDividerRegister)(
+        (uint16_t)((divider >> UART_CLOCK_DIVIDER_FRACTION_BITS) - 1u),
+        (uint8_t)(divider & UART_CLOCK_DIVIDER_FRACTION_MASK));
+    COMPONENT(HOST_UART, SCBCLK_Start)();
+    COMPONENT(HOST_UART, EnableInt)();
+    g_baud.divider = divider;
+}
+
+
 /// Handle any byte in the processed via the receive state machine that would
 /// overflow because it doesn't fit in the receive buffer.
 /// @param[in]  data    The data byte that overflowed (didn't fit in the receive
@@ -802,80 +1881,408 @@ static void handleRxFrameOverflow(uint8_t data)
 }
 
 
-/// Generates the formatted packet that defines the UART frame protocol. The
-/// formatted packet will have the 0xaa frame characters and 0x55 escape
-/// characters as necessary along with command byte if the packet pertains to
-/// a bridge command. Note that the packet's type flags and command bytes must
-/// be primed before invoking this function.
-/// @param[in]  source      The source buffer.
-/// @param[in]  sourceSize  The number of bytes in the source.
-/// @param[out] target      The target buffer (where the formatted data is
-///                         stored).
-/// @param[in]  targetSize  The number of bytes available in the target.
-/// @return The number of bytes in the target buffer or the number of bytes
-///         to transmit.  If 0, then the source buffer was either invalid or
-///         there's not enough bytes in target buffer to store the formatted
-///         data.
-static uint16_t encodeData(uint8_t target[], uint16_t targetSize, uint8_t const source[], uint16_t sourceSize)
-{
-    uint16_t t = 0;
-    if ((targetSize > 0) && (target != NULL))
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// Enqueue a transmit queue element: the command followed by the payload. The
+    /// element is framed and escaped when it's written to the UART.
+    /// @param[in]  command The command of the element; see G_TxUnframedCommand.
+    /// @param[in]  data    The payload; may be NULL if size is 0.
+    /// @param[in]  size    The size of the payload.
+    /// @return If the element was successfully enqueued.
+    static bool txEnqueueElement(uint8_t command, uint8_t const data[], uint16_t size)
     {
-        // Always put the start frame control byte in the beginning.
-        target[t++] = ControlByte_StartFrame;
-        
-        bool processPendingData = true;
-        if (g_pendingTxEnqueue.commandFlag && (g_pendingTxEnqueue.command != BridgeCommand_None))
+        bool status = false;
+        if ((g_heap != NULL) && ((data != NULL) || (size == 0)))
         {
-            static uint8_t const CommandSize = 3u;
-            if ((t + CommandSize) > targetSize)
+            uint8_t* element = queue_reserve(&g_heap->txQueue, size + 1u);
+            if (element != NULL)
             {
-                processPendingData = false;
-                t = 0;
+                element[0] = command;
+                if (size > 0)
+                    memcpy(&element[1], data, size);
+                status = queue_commit(&g_heap->txQueue, size + 1u);
             }
-            else
+        }
+        return status;
+    }
+    
+    
+    /// Reserve room in the transmit queue for a packet whose payload is built in
+    /// place: write the payload to reservation->payload and then invoke txCommit.
+    /// @param[out] reservation     The reserved region.
+    /// @param[in]  maxPayloadSize  The maximum number of bytes in the payload.
+    /// @return If the region was successfully reserved.
+    static bool txReserve(TxReservation* reservation, uint16_t maxPayloadSize)
+    {
+        // The command and the sequence ID (if enabled) precede the payload.
+        uint8_t headerSize = (g_sequenceEnabled) ? (2u) : (1u);
+        reservation->frame = queue_reserve(&g_heap->txQueue, maxPayloadSize + headerSize);
+        reservation->payload = NULL;
+        reservation->maxPayloadSize = maxPayloadSize;
+        reservation->sequenced = g_sequenceEnabled;
+        if (reservation->frame != NULL)
+            reservation->payload = &reservation->frame[headerSize];
+        return (reservation->frame != NULL);
+    }
+    
+    
+    /// Enqueue the packet whose payload was built in a transmit queue reservation
+    /// (see txReserve).
+    /// @param[in]  reservation The reserved region with the payload.
+    /// @param[in]  command     The command associated with the transmit packet.
+    /// @param[in]  size        The number of bytes in the payload.
+    /// @return If the packet was successfully enqueued.
+    static bool txCommit(TxReservation const* reservation, BridgeCommand command, uint16_t size)
+    {
+        bool status = false;
+        if ((reservation->frame != NULL) && (size <= reservation->maxPayloadSize))
+        {
+            reservation->frame[0] = command;
+            if (reservation->sequenced)
+                reservation->frame[1] = g_txSequenceId;
+            status = queue_commit(&g_heap->txQueue, (uint16_t)(reservation->payload - reservation->frame) + size);
+        }
+        return status;
+    }
+    
+    
+    /// Enqueue a packet with a command and/or data into the transmit queue. The
+    /// packet is stored raw and encoded when it's written to the UART.
+    /// @param[in]  command The command associated with the transmit packet; if
+    ///                     BridgeCommand_None, the packet only has data.
+    /// @param[in]  data    The data to enqueue; may be NULL if size is 0.
+    /// @param[in]  size    The size of the data.
+    /// @return If the packet was successfully enqueued.
+    static bool txEnqueue(BridgeCommand command, uint8_t const data[], uint16_t size)
+    {
+        bool status = false;
+        if (!g_sequenceEnabled)
+            status = txEnqueueElement(command, data, size);
+        else if ((g_heap != NULL) && ((data != NULL) || (size == 0)))
+        {
+            TxReservation reservation;
+            if (txReserve(&reservation, size))
             {
-                target[t++] = ControlByte_Escape;
-                target[t++] = ControlByte_Escape;
-                target[t++] = g_pendingTxEnqueue.command;
+                if (size > 0)
+                    memcpy(reservation.payload, data, size);
+                status = txCommit(&reservation, command, size);
             }
         }
+        return status;
+    }
+    
+#else
+    
+    /// Calculates the number of bytes of the formatted packet that encodeData
+    /// generates for the command and source. If the CRC-16 trailer is
+    /// enabled, the trailer is counted as if both bytes need to be escaped.
+    /// @param[in]  command     The command associated with the packet; if
+    ///                         BridgeCommand_None, the packet only has data.
+    /// @param[in]  source      The source buffer.
+    /// @param[in]  sourceSize  The number of bytes in the source.
+    /// @return The number of bytes in the formatted packet.
+    static uint16_t getEncodedSize(BridgeCommand command, uint8_t const source[], uint16_t sourceSize)
+    {
+        static uint8_t const FrameSize = 2u;
+        static uint8_t const CommandSize = 3u;
+        
+        // COBS framing: the command, source and trailer need one code byte per
+        // block of up to 254 bytes; the delimiter ends the frame.
+        if (g_txFraming == Framing_Cobs)
+        {
+            uint16_t cobsSize = 1u + sourceSize + ((g_txCrcEnabled) ? (FRAME_CRC_SIZE) : (0u));
+            return cobsSize + (cobsSize / (COBS_MAX_CODE - 1u)) + 2u;
+        }
+        
+        uint16_t size = FrameSize + sourceSize;
+        if (command != BridgeCommand_None)
+            size += CommandSize;
+        if (g_txCrcEnabled)
+            size += (FRAME_CRC_SIZE << 1);
+        
+        // Each byte that requires an escape character adds one byte.
+        uint16_t s = findEscapeOffset(source, sourceSize);
+        while (s < sourceSize)
+        {
+            size++;
+            s++;
+            s += findEscapeOffset(&source[s], sourceSize - s);
+        }
+        return size;
+    }
+    
+    
+    /// Generates the COBS frame (see Framing_Cobs): the command (BridgeCommand_None
+    /// for data), the source and the CRC-16 trailer if it's enabled followed by
+    /// the delimiter. The source may be located inside the target buffer like
+    /// with encodeData.
+    /// @param[out] target      The target buffer (where the formatted data is
+    ///                         stored).
+    /// @param[in]  targetSize  The number of bytes available in the target.
+    /// @param[in]  command     The command associated with the packet.
+    /// @param[in]  source      The source buffer.
+    /// @param[in]  sourceSize  The number of bytes in the source.
+    /// @return The number of bytes in the target buffer; 0 if the source
+    ///         buffer was invalid or the frame doesn't fit in the target.
+    static uint16_t encodeCobsData(uint8_t target[], uint16_t targetSize, BridgeCommand command, uint8_t const source[], uint16_t sourceSize)
+    {
+        static uint8_t const SegmentCount = 3u;
         
-        if (g_pendingTxEnqueue.dataFlag && processPendingData && (sourceSize > 0) && (source != NULL))
+        uint16_t t = 0;
+        if ((target != NULL) && (targetSize > 1u) && ((source != NULL) || (sourceSize == 0)))
         {
-            // Iterate through the source buffer and copy it into transmit buffer.
-            for (uint32_t s = 0; s < sourceSize; ++s)
+            // Calculate the CRC-16 before the source is overwritten.
+            uint8_t const header[] = { command };
+            uint8_t trailer[FRAME_CRC_SIZE] = { 0u };
+            uint16_t trailerSize = 0;
+            if (g_txCrcEnabled)
+            {
+                uint16_t crc = crc16_updateByte(CRC16_INITIAL_VALUE, command);
+                crc = crc16_update(crc, source, sourceSize);
+                trailer[0] = HI_BYTE_16_BIT(crc);
+                trailer[1] = LO_BYTE_16_BIT(crc);
+                trailerSize = FRAME_CRC_SIZE;
+            }
+            
+            // Each zero byte is replaced by the code byte of the block that
+            // follows; the first code byte is written once its block ends.
+            // Always leave room for the delimiter.
+            uint8_t const* segments[] = { header, source, trailer };
+            uint16_t const segmentSizes[] = { sizeof(header), sourceSize, trailerSize };
+            uint16_t limit = targetSize - 1u;
+            uint16_t codeIndex = t++;
+            uint8_t code = 1u;
+            bool complete = true;
+            for (uint8_t i = 0; complete && (i < SegmentCount); ++i)
             {
-                if (t > targetSize)
+                for (uint16_t s = 0; complete && (s < segmentSizes[i]); ++s)
                 {
-                    t = 0;
-                    break;
+                    uint8_t data = segments[i][s];
+                    if (t >= limit)
+                        complete = false;
+                    else if (data == 0)
+                    {
+                        target[codeIndex] = code;
+                        codeIndex = t++;
+                        code = 1u;
+                    }
+                    else
+                    {
+                        target[t++] = data;
+                        if (++code == COBS_MAX_CODE)
+                        {
+                            if (t >= limit)
+                                complete = false;
+                            else
+                            {
+                                target[codeIndex] = code;
+                                codeIndex = t++;
+                                code = 1u;
+                            }
+                        }
+                    }
                 }
-                uint8_t data = source[s];
-                
-                // Check to see if an escape character is needed.
-                if (requiresEscapeCharacter(data))
+            }
+            
+            if (complete)
+            {
+                target[codeIndex] = code;
+                target[t++] = ControlByte_CobsDelimiter;
+            }
+            else
+                t = 0;
+        }
+        return t;
+    }
+    
+    
+    /// Generates the formatted packet that defines the UART frame protocol. The
+    /// formatted packet will have the 0xaa frame characters and 0x55 escape
+    /// characters as necessary along with command byte if the packet pertains to
+    /// a bridge command and the CRC-16 trailer if it's enabled. The source may be
+    /// located inside the target buffer (the packet is encoded in place) as long
+    /// as the source starts at least (sourceSize + G_TxFrameOverhead) bytes
+    /// after the start of the target.
+    /// @param[out] target      The target buffer (where the formatted data is
+    ///                         stored).
+    /// @param[in]  targetSize  The number of bytes available in the target.
+    /// @param[in]  command     The command associated with the packet; if
+    ///                         BridgeCommand_None, the packet only has data.
+    /// @param[in]  source      The source buffer.
+    /// @param[in]  sourceSize  The number of bytes in the source.
+    /// @return The number of bytes in the target buffer or the number of bytes
+    ///         to transmit.  If 0, then the source buffer was either invalid or
+    ///         there's not enough bytes in target buffer to store the formatted
+    ///         data.
+    static uint16_t encodeData(uint8_t target[], uint16_t targetSize, BridgeCommand command, uint8_t const source[], uint16_t sourceSize)
+    {
+        static uint8_t const CommandSize = 3u;
+        
+        if (g_txFraming == Framing_Cobs)
+            return encodeCobsData(target, targetSize, command, source, sourceSize);
+        
+        uint16_t t = 0;
+        if ((target != NULL) && (targetSize > 1u) && ((source != NULL) || (sourceSize == 0)))
+        {
+            // Always leave room for the end frame control byte.
+            uint16_t limit = targetSize - 1u;
+            bool complete = true;
+            bool crcEnabled = g_txCrcEnabled;
+            uint16_t crc = CRC16_INITIAL_VALUE;
+            
+            // Always put the start frame control byte in the beginning.
+            target[t++] = ControlByte_StartFrame;
+            if (command != BridgeCommand_None)
+            {
+                if ((t + CommandSize) > limit)
+                    complete = false;
+                else
                 {
                     target[t++] = ControlByte_Escape;
-                    if (t > targetSize)
+                    target[t++] = ControlByte_Escape;
+                    target[t++] = command;
+                    crc = crc16_updateByte(crc, command);
+                }
+            }
+            
+            // Iterate through the source buffer and copy it into transmit buffer
+            // as runs of bytes that don't require an escape character, each
+            // followed by the escaped byte that ends the run (if any). The target
+            // never catches up with the unread source so the packet can be
+            // encoded in place.
+            uint16_t s = 0;
+            while (complete && (s < sourceSize))
+            {
+                uint16_t runSize = findEscapeOffset(&source[s], sourceSize - s);
+                uint16_t escapedSize = ((s + runSize) < sourceSize) ? (2u) : (0u);
+                if ((t + runSize + escapedSize) > limit)
+                    complete = false;
+                else
+                {
+                    // Update the CRC-16 before the source is overwritten.
+                    if (crcEnabled)
+                        crc = crc16_update(crc, &source[s], runSize + (escapedSize >> 1));
+                    memcpy(&target[t], &source[s], runSize);
+                    t += runSize;
+                    s += runSize;
+                    if (escapedSize > 0)
+                    {
+                        uint8_t data = source[s++];
+                        target[t++] = ControlByte_Escape;
+                        target[t++] = data;
+                    }
+                }
+            }
+            
+            // Add the CRC-16 trailer (big-endian) before the end frame.
+            if (complete && crcEnabled)
+            {
+                uint8_t const trailer[FRAME_CRC_SIZE] = { HI_BYTE_16_BIT(crc), LO_BYTE_16_BIT(crc) };
+                for (uint8_t i = 0; complete && (i < FRAME_CRC_SIZE); ++i)
+                {
+                    bool escaped = requiresEscapeCharacter(trailer[i]);
+                    if ((t + 1u + escaped) > limit)
+                        complete = false;
+                    else
                     {
-                        t = 0;
-                        break;
+                        if (escaped)
+                            target[t++] = ControlByte_Escape;
+                        target[t++] = trailer[i];
                     }
                 }
-                target[t++] = data;
             }
+            
+            // Always put the end frame control byte in the end; if the packet did
+            // not fit, nothing can be transmitted.
+            if (complete)
+                target[t++] = ControlByte_EndFrame;
+            else
+                t = 0;
         }
-        
-        // Always put the end frame control byte in the end.
-        if ((t > 0) && (t < targetSize))
-            target[t++] = ControlByte_EndFrame;
-        else
-            t = 0;
+        return t;
     }
-    resetPendingTxEnqueue();
-    return t;
-}
+    
+    
+    /// Reserve room in the transmit queue for a packet whose payload is built in
+    /// place: write the payload to reservation->payload and then invoke txCommit.
+    /// @param[out] reservation     The reserved region.
+    /// @param[in]  maxPayloadSize  The maximum number of bytes in the payload.
+    /// @return If the region was successfully reserved.
+    static bool txReserve(TxReservation* reservation, uint16_t maxPayloadSize)
+    {
+        // Worst case, every payload byte (and the sequence ID) must be escaped.
+        // The sequence ID is written right before the payload.
+        uint16_t sequencedSize = maxPayloadSize + ((g_sequenceEnabled) ? (1u) : (0u));
+        uint16_t frameSize = (sequencedSize << 1) + G_TxFrameOverhead;
+        reservation->frame = queue_reserve(&g_heap->txQueue, frameSize);
+        reservation->payload = NULL;
+        reservation->maxPayloadSize = maxPayloadSize;
+        reservation->sequenced = g_sequenceEnabled;
+        if (reservation->frame != NULL)
+            reservation->payload = &reservation->frame[frameSize - maxPayloadSize];
+        return (reservation->frame != NULL);
+    }
+    
+    
+    /// Encode the payload built in a transmit queue reservation (see txReserve)
+    /// in place and enqueue the packet.
+    /// @param[in]  reservation The reserved region with the payload.
+    /// @param[in]  command     The command associated with the transmit packet.
+    /// @param[in]  size        The number of bytes in the payload.
+    /// @return If the packet was successfully enqueued.
+    static bool txCommit(TxReservation const* reservation, BridgeCommand command, uint16_t size)
+    {
+        bool status = false;
+        if ((reservation->frame != NULL) && (size <= reservation->maxPayloadSize))
+        {
+            uint8_t* source = reservation->payload;
+            uint16_t sourceSize = size;
+            if (reservation->sequenced)
+            {
+                *(--source) = g_txSequenceId;
+                sourceSize++;
+            }
+            uint16_t frameSize = (uint16_t)(reservation->payload - reservation->frame) + reservation->maxPayloadSize;
+            uint16_t encodedSize = encodeData(reservation->frame, frameSize, command, source, sourceSize);
+            if (encodedSize > 0)
+                status = queue_commit(&g_heap->txQueue, encodedSize);
+        }
+        return status;
+    }
+    
+    
+    /// Enqueue a packet with a command and/or data into the transmit queue. The
+    /// packet is encoded directly into the transmit queue.
+    /// @param[in]  command The command associated with the transmit packet; if
+    ///                     BridgeCommand_None, the packet only has data.
+    /// @param[in]  data    The data to enqueue; may be NULL if size is 0.
+    /// @param[in]  size    The size of the data.
+    /// @return If the packet was successfully enqueued.
+    static bool txEnqueue(BridgeCommand command, uint8_t const data[], uint16_t size)
+    {
+        bool status = false;
+        if (g_sequenceEnabled)
+        {
+            // The sequence ID precedes the data; build the payload in place.
+            TxReservation reservation;
+            if ((g_heap != NULL) && ((data != NULL) || (size == 0)) && txReserve(&reservation, size))
+            {
+                if (size > 0)
+                    memcpy(reservation.payload, data, size);
+                status = txCommit(&reservation, command, size);
+            }
+        }
+        else if ((g_heap != NULL) && ((data != NULL) || (size == 0)))
+        {
+            uint16_t frameSize = getEncodedSize(command, data, size);
+            uint8_t* frame = queue_reserve(&g_heap->txQueue, frameSize);
+            if (frame != NULL)
+                status = queue_commit(&g_heap->txQueue, encodeData(frame, frameSize, command, data, size));
+        }
+        return status;
+    }
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
 
 
 /// Enqueue a command response and any associated data into the transmit queue.
@@ -889,24 +2296,12 @@ static uint16_t encodeData(uint8_t target[], uint16_t targetSize, uint8_t const
 static bool txEnqueueCommandResponse(BridgeCommand command, uint8_t const data[], uint16_t size)
 {
     bool status = false;
-    if (!queue_isFull(&g_heap->txQueue) && (command != BridgeCommand_None))
+    if (command != BridgeCommand_None)
     {
-        bool isEmptyData = ((data == NULL) || (size <= 0));
-        g_pendingTxEnqueue.command = command;
-        g_pendingTxEnqueue.commandFlag = true;
-        g_pendingTxEnqueue.dataFlag = !isEmptyData;
-        if (isEmptyData)
-        {
-            // The dummyData variables serves as a placeholder to allow for a
-            // successful enqueue of only commands in the txQueue. The data
-            // doesn't matter. This will allow the enqueue callback function,
-            // encodeData(), to populate the enqueue with the command.
-            uint8_t dummyData = 0;
-            queue_enqueue(&g_heap->txQueue, &dummyData, sizeof(dummyData));
-        }
+        if ((data == NULL) || (size <= 0))
+            status = txEnqueue(command, NULL, 0);
         else
-            queue_enqueue(&g_heap->txQueue, data, size);
-        status = true;
+            status = txEnqueue(command, data, size);
     }
     return status;
 }
@@ -916,27 +2311,18 @@ static bool txEnqueueCommandResponse(BridgeCommand command, uint8_t const data[]
 /// @return If the legacy version response was successfully enqueued.
 static bool txEnqueueLegacyVersion(void)
 {
-    uint32_t const UartBaud = 1000000u;
-    static uint8_t const Version[] =
+    uint32_t const uartBaud = calculateBaudRate(g_baud.divider);
+    uint8_t const version[] =
     {
         (uint8_t)VERSION_MAJOR,
         (uint8_t)VERSION_MINOR,
-        (uint8_t)((UartBaud >> 24) & 0xff),
-        (uint8_t)((UartBaud >> 16) & 0xff),
-        (uint8_t)((UartBaud >>  8) & 0xff),
-        (uint8_t)((UartBaud >>  0) & 0xff),
+        (uint8_t)((uartBaud >> 24) & 0xff),
+        (uint8_t)((uartBaud >> 16) & 0xff),
+        (uint8_t)((uartBaud >>  8) & 0xff),
+        (uint8_t)((uartBaud >>  0) & 0xff),
     };
     
-    bool status = false;
-    if (!queue_isFull(&g_heap->txQueue))
-    {
-        g_pendingTxEnqueue.command = BridgeCommand_LegacyVersion;
-        g_pendingTxEnqueue.commandFlag = true;
-        g_pendingTxEnqueue.dataFlag = true;
-        queue_enqueue(&g_heap->txQueue, Version, sizeof(Version));
-        status = true;
-    }
-    return status;
+    return txEnqueueCommandResponse(BridgeCommand_LegacyVersion, version, sizeof(version));
 }
 
 
@@ -953,16 +2339,7 @@ static bool txEnqueueVersion(void)
         LO_BYTE_16_BIT(VERSION_MINOR),
     };
     
-    bool status = false;
-    if (!queue_isFull(&g_heap->txQueue))
-    {
-        g_pendingTxEnqueue.command = BridgeCommand_Version;
-        g_pendingTxEnqueue.commandFlag = true;
-        g_pendingTxEnqueue.dataFlag = true;
-        queue_enqueue(&g_heap->txQueue, Version, sizeof(Version));
-        status = true;
-    }
-    return status;
+    return txEnqueueCommandResponse(BridgeCommand_Version, Version, sizeof(Version));
 }
 
 
@@ -971,18 +2348,12 @@ static bool txEnqueueVersion(void)
 static bool __attribute__((unused)) txEnqueueUartError(uint16_t callsite)
 {
     bool result = false;
-    if (!queue_isFull(&g_heap->txQueue))
+    TxReservation reservation;
+    if (txReserve(&reservation, G_MaxErrorMessageSize))
     {
-        uint8_t scratch[G_ScratchSize];
-        int size = error_makeUartErrorMessage(scratch, sizeof(scratch), 0, callsite);
+        int size = error_makeUartErrorMessage(reservation.payload, reservation.maxPayloadSize, 0, callsite);
         if (size > 0)
-        {
-            g_pendingTxEnqueue.command = BridgeCommand_Error;
-            g_pendingTxEnqueue.commandFlag = true;
-            g_pendingTxEnqueue.dataFlag = true;
-            queue_enqueue(&g_heap->txQueue, scratch, sizeof(size));
-            result = true;
-        }
+            result = txCommit(&reservation, BridgeCommand_Error, size);
     }
     return result;
 }
@@ -996,23 +2367,28 @@ static bool __attribute__((unused)) txEnqueueUartError(uint16_t callsite)
 static bool txEnqueueI2cError(I2cStatus status, uint16_t callsite)
 {
     bool result = false;
-    if (!queue_isFull(&g_heap->txQueue))
+    TxReservation reservation;
+    if (txReserve(&reservation, G_MaxErrorMessageSize))
     {
-        uint8_t scratch[G_ScratchSize];
-        int size = error_makeI2cErrorMessage(scratch, sizeof(scratch), status, callsite);
+        int size = error_makeI2cErrorMessage(reservation.payload, reservation.maxPayloadSize, status, callsite);
         if (size > 0)
-        {
-            g_pendingTxEnqueue.command = BridgeCommand_Error;
-            g_pendingTxEnqueue.commandFlag = true;
-            g_pendingTxEnqueue.dataFlag = true;
-            queue_enqueue(&g_heap->txQueue, scratch, size);
-            result = true;
-        }
+            result = txCommit(&reservation, BridgeCommand_Error, size);
     }
     return result;
 }
 
 
+/// Checks if the only error of an I2C operation is a full transfer queue.
+/// @param[in]  status  The status of the I2C operation.
+/// @return If the transfer queue was full (and no other error occurred).
+static bool isI2cQueueFull(I2cStatus status)
+{
+    I2cStatus queueFullStatus = { 0u };
+    queueFullStatus.queueFull = true;
+    return (status.mask == queueFullStatus.mask);
+}
+
+
 /// Processes errors from the I2C module, specifically prep an error message to
 /// to the host.
 /// @param[in]  status      Status indicating if an error occured during the I2c
@@ -1020,8 +2396,19 @@ static bool txEnqueueI2cError(I2cStatus status, uint16_t callsite)
 ///                         I2cStatus union.
 /// @param[in]  callsite    Unique callsite ID to distinguish different
 ///                         functions that triggered the error.
-static void processI2cErrors(I2cStatus status, callsite_t callsite)
+/// @param[in]  tag         The sequence ID of the request that queued the
+///                         failed transfer (see i2cTouch_read); 0 to use the
+///                         sequence ID of the request being processed.
+static void processI2cErrors(I2cStatus status, callsite_t callsite, uint8_t tag)
 {
+    // A batch waits for room in the transfer queue instead of failing; see
+    // processBatchCommand.
+    if (g_batch.executing && isI2cQueueFull(status))
+        return;
+    
+    uint8_t sequenceId = g_txSequenceId;
+    if (tag != G_UnsolicitedSequenceId)
+        g_txSequenceId = tag;
     
     if (error_getMode() == ErrorMode_Global)
         txEnqueueI2cError(status, callsite);
@@ -1043,33 +2430,206 @@ static void processI2cErrors(I2cStatus status, callsite_t callsite)
             ;
     }
     error_tally(ErrorType_I2c);
+    g_txSequenceId = sequenceId;
 }
 
 
-/// Enqueue the update-specific error response.
-/// @param[in]  status      The UpdateStatus indicating if an error occurred.
-/// @param[in]  callsite    Unique callsite ID to distinguish different
-///                         functions that triggered the error.
-/// @return If the error response was successfully enqueued.
-static bool txEnqueueUpdateError(UpdateStatus status, uint16_t callsite)
-{
-    bool result = false;
-    if (!queue_isFull(&g_heap->txQueue))
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// Get the reference report of a report command; if there's none, the
+    /// reference report used the longest ago is dropped and assigned to it.
+    /// @param[in]  command The report command (the first byte of the report).
+    /// @return The reference report.
+    static DeltaReference* getDeltaReference(uint8_t command)
     {
-        uint8_t scratch[G_ScratchSize];
-        int size = error_makeUpdateErrorMessage(scratch, sizeof(scratch), status, callsite);
-        if (size > 0)
+        for (uint8_t i = 0; i < UART_DELTA_REFERENCE_COUNT; ++i)
         {
-            g_pendingTxEnqueue.command = BridgeCommand_Error;
-            g_pendingTxEnqueue.commandFlag = true;
-            g_pendingTxEnqueue.dataFlag = true;
-            queue_enqueue(&g_heap->txQueue, scratch, size);
-            result = true;
+            DeltaReference* reference = &g_delta.references[i];
+            if ((reference->size > 0) && (reference->data[0] == command))
+                return reference;
         }
+        
+        DeltaReference* reference = &g_delta.references[g_delta.nextReference];
+        reference->size = 0;
+        g_delta.nextReference = ((g_delta.nextReference + 1u) < UART_DELTA_REFERENCE_COUNT) ? (g_delta.nextReference + 1u) : (0u);
+        return reference;
     }
-    return result;
-}
-
+    
+    
+    /// Encodes a report as a DeltaFrame_Delta payload: the report XORed with the
+    /// reference report, run-length encoded.
+    /// @param[out] target      The buffer to encode into.
+    /// @param[in]  targetSize  The size of the target buffer.
+    /// @param[in]  reference   The reference report; same size as the report.
+    /// @param[in]  data        The report.
+    /// @param[in]  size        The size of the report.
+    /// @return The size of the payload; 0 if it doesn't fit in the target.
+    static uint16_t encodeDelta(uint8_t target[], uint16_t targetSize, uint8_t const reference[], uint8_t const data[], uint16_t size)
+    {
+        static uint8_t const MaxRun = UINT8_MAX;
+        
+        uint16_t offset = 0;
+        if (targetSize < 2u)
+            return 0;
+        target[offset++] = DeltaFrame_Delta;
+        target[offset++] = data[0];
+        
+        uint16_t i = 0;
+        while (i < size)
+        {
+            uint8_t zeroCount = 0;
+            while ((i < size) && (zeroCount < MaxRun) && (data[i] == reference[i]))
+            {
+                ++zeroCount;
+                ++i;
+            }
+            if (i >= size)
+                break;
+            
+            // A single unchanged byte between changed bytes is cheaper as a
+            // literal than as a new pair.
+            uint16_t start = i;
+            while ((i < size) && ((i - start) < MaxRun) &&
+                ((data[i] != reference[i]) || (((i + 1u) < size) && (data[i + 1u] != reference[i + 1u]))))
+                ++i;
+            
+            uint8_t literalCount = i - start;
+            if ((offset + 2u + literalCount) > targetSize)
+                return 0;
+            target[offset++] = zeroCount;
+            target[offset++] = literalCount;
+            for (uint16_t j = start; j < i; ++j)
+                target[offset++] = data[j] ^ reference[j];
+        }
+        return offset;
+    }
+    
+    
+    /// Enqueue a report the slave sent on its own; in delta mode, it's sent as a
+    /// delta from the reference report of its report command unless a keyframe
+    /// is due or the delta isn't smaller than the report. The reference report
+    /// is only updated once the frame is enqueued so a frame that can't be
+    /// enqueued doesn't desynchronize the host.
+    /// @param[in]  data    The report.
+    /// @param[in]  size    The size of the report.
+    /// @return If the frame was successfully enqueued.
+    static bool txEnqueueReport(uint8_t const data[], uint16_t size)
+    {
+        if (!g_delta.enabled || (g_delta.references == NULL) || (data == NULL) || (size == 0) || (size > UART_DELTA_REPORT_MAX_SIZE))
+            return uart_txEnqueueData(data, size);
+        
+        DeltaReference* reference = getDeltaReference(data[0]);
+        bool keyframe = (reference->size != size) ||
+            ((g_delta.keyframeInterval > 0) && (reference->deltaCount >= g_delta.keyframeInterval));
+        
+        TxReservation reservation;
+        bool status = false;
+        if (txReserve(&reservation, size + 1u))
+        {
+            uint16_t payloadSize = 0;
+            if (!keyframe)
+                payloadSize = encodeDelta(reservation.payload, size, reference->data, data, size);
+            if (payloadSize == 0)
+            {
+                keyframe = true;
+                reservation.payload[0] = DeltaFrame_Keyframe;
+                memcpy(&reservation.payload[1], data, size);
+                payloadSize = size + 1u;
+            }
+            status = txCommit(&reservation, BridgeCommand_DeltaReport, payloadSize);
+        }
+        
+        if (status)
+        {
+            memcpy(reference->data, data, size);
+            reference->size = size;
+            reference->deltaCount = (keyframe) ? (0u) : (reference->deltaCount + 1u);
+        }
+        return status;
+    }
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+
+#if (I2C_SLAVE_COUNT > 1)
+    
+    /// Enqueue a report a slave sent on its own in a BridgeCommand_SlaveReport
+    /// frame tagged with the address of the slave.
+    /// @param[in]  address The 7-bit I2C address of the slave.
+    /// @param[in]  data    The report.
+    /// @param[in]  size    The size of the report.
+    /// @return If the frame was successfully enqueued.
+    static bool txEnqueueSlaveReport(uint8_t address, uint8_t const data[], uint16_t size)
+    {
+        TxReservation reservation;
+        bool status = false;
+        if ((data != NULL) && txReserve(&reservation, size + 1u))
+        {
+            reservation.payload[0] = address;
+            memcpy(&reservation.payload[1], data, size);
+            status = txCommit(&reservation, BridgeCommand_SlaveReport, size + 1u);
+        }
+        return status;
+    }
+    
+#endif // (I2C_SLAVE_COUNT > 1)
+
+
+/// Sends the data read from the I2C slave to the host in a data frame (see
+/// txEnqueueReport for the reports in delta mode and txEnqueueSlaveReport for
+/// the reports of several slaves).
+/// @param[in]  data    The data read from the I2C slave.
+/// @param[in]  size    The number of bytes read.
+/// @param[in]  tag     The sequence ID of the request that queued the read (see
+///                     i2cTouch_read); G_UnsolicitedSequenceId for the reads
+///                     triggered by a slave IRQ.
+/// @param[in]  address The 7-bit I2C address the data was read from.
+/// @param[in]  irqRead Flag indicating if the read was triggered by a slave
+///                     IRQ (a report the slave sent on its own) instead of
+///                     requested by the host. The tag can't tell them apart:
+///                     the host's reads are also tagged 0 if the sequence IDs
+///                     are disabled.
+/// @return If the data frame was successfully enqueued.
+static bool processI2cRx(uint8_t const* data, uint16_t size, uint8_t tag, uint8_t address, bool irqRead)
+{
+    uint8_t sequenceId = g_txSequenceId;
+    g_txSequenceId = tag;
+#if (I2C_SLAVE_COUNT > 1)
+    // Only the reports the slaves send on their own are tagged; the host knows
+    // the address of the reads it requested.
+    bool status = irqRead ? (txEnqueueSlaveReport(address, data, size)) : (uart_txEnqueueData(data, size));
+#elif ENABLE_UART_TX_DELTA_REPORTS
+    // Only the reports the slave sends on its own are delta-encoded.
+    (void)address;
+    bool status = irqRead ? (txEnqueueReport(data, size)) : (uart_txEnqueueData(data, size));
+#else
+    (void)address;
+    (void)irqRead;
+    bool status = uart_txEnqueueData(data, size);
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+    g_txSequenceId = sequenceId;
+    return status;
+}
+
+
+/// Enqueue the update-specific error response.
+/// @param[in]  status      The UpdateStatus indicating if an error occurred.
+/// @param[in]  callsite    Unique callsite ID to distinguish different
+///                         functions that triggered the error.
+/// @return If the error response was successfully enqueued.
+static bool txEnqueueUpdateError(UpdateStatus status, uint16_t callsite)
+{
+    bool result = false;
+    TxReservation reservation;
+    if (txReserve(&reservation, G_MaxErrorMessageSize))
+    {
+        int size = error_makeUpdateErrorMessage(reservation.payload, reservation.maxPayloadSize, status, callsite);
+        if (size > 0)
+            result = txCommit(&reservation, BridgeCommand_Error, size);
+    }
+    return result;
+}
+
 
 /// Processes errors from UART update module, specifically prep an error
 /// message to send to the host.
@@ -1096,330 +2656,1993 @@ static bool processErrorCommand(uint8_t const* data, uint16_t size)
         error_setMode((data[0] != 0) ? (ErrorMode_Global) : (ErrorMode_Legacy));
     
     bool status = false;
-    if (!queue_isFull(&g_heap->txQueue))
+    TxReservation reservation;
+    if (txReserve(&reservation, G_MaxErrorMessageSize))
     {
-        uint8_t scratch[G_ScratchSize];
-        int size = error_makeModeMessage(scratch, sizeof(scratch));
-        if (size > 0)
-        {
-            g_pendingTxEnqueue.command = BridgeCommand_Error;
-            g_pendingTxEnqueue.commandFlag = true;
-            g_pendingTxEnqueue.dataFlag = true;
-            queue_enqueue(&g_heap->txQueue, scratch, size);
-            status = true;
-        }
+        int messageSize = error_makeModeMessage(reservation.payload, reservation.maxPayloadSize);
+        if (messageSize > 0)
+            status = txCommit(&reservation, BridgeCommand_Error, messageSize);
     }
     return status;
 }
 
 
-/// Processes the slave update command from the host.
-/// @param[in]  data    The data payload from the error command.
+/// Write the statistics of one queue in the format of the StatsCommand_Queue
+/// response.
+/// @param[out] target  The buffer to write to; must hold G_QueueStatsSize
+///                     bytes.
+/// @param[in]  stats   The queue statistics.
+/// @return The number of bytes written.
+static uint16_t writeQueueStats(uint8_t target[], QueueStats const* stats)
+{
+    uint16_t size = 0;
+    target[size++] = stats->peakSize;
+    target[size++] = stats->maxSize;
+    target[size++] = HI_BYTE_16_BIT(stats->peakDataSize);
+    target[size++] = LO_BYTE_16_BIT(stats->peakDataSize);
+    target[size++] = HI_BYTE_16_BIT(stats->maxDataSize);
+    target[size++] = LO_BYTE_16_BIT(stats->maxDataSize);
+    target[size++] = HI_BYTE_16_BIT(stats->enqueueFailures);
+    target[size++] = LO_BYTE_16_BIT(stats->enqueueFailures);
+    target[size++] = BYTE_3_32_BIT(stats->enqueuedBytes);
+    target[size++] = BYTE_2_32_BIT(stats->enqueuedBytes);
+    target[size++] = BYTE_1_32_BIT(stats->enqueuedBytes);
+    target[size++] = BYTE_0_32_BIT(stats->enqueuedBytes);
+    target[size++] = BYTE_3_32_BIT(stats->dequeuedBytes);
+    target[size++] = BYTE_2_32_BIT(stats->dequeuedBytes);
+    target[size++] = BYTE_1_32_BIT(stats->dequeuedBytes);
+    target[size++] = BYTE_0_32_BIT(stats->dequeuedBytes);
+    return size;
+}
+
+
+/// Processes the stats command from the host and enqueues the appropriate
+/// response.
+/// @param[in]  data    The data payload from the stats command.
 /// @param[in]  size    The size of the data payload.
-/// @return If the slave update command was processed successfully.
-static bool processSlaveUpdateCommand(uint8_t const* data, uint16_t size)
+/// @return If the appropriate response was successfully enqueued.
+static bool processStatsCommand(uint8_t const* data, uint16_t size)
 {
-    static uint16_t const MinChunkDataSize = 8u;
-    static uint16_t const MinChunkHeaderSize = 14u;
-    static uint16_t const MinChunkSize = MinChunkDataSize + MinChunkHeaderSize;
-    static uint16_t const ChunkSizeAdjustment = 256u;
+    StatsCommand command = StatsCommand_Queue;
+    if ((data != NULL) && (size > 0))
+        command = (StatsCommand)data[0];
     
     bool status = false;
-    if (size > UpdateOffset_Flags)
+    TxReservation reservation;
+    switch (command)
     {
-        UpdateFlags flags = { data[UpdateOffset_Flags] };
-        if (flags.initiate)
-        {
-            // @TODO: figure out what this flag is supposed to do.
-        }
-        if (flags.updateFileInfo)
+        case StatsCommand_Queue:
         {
-            if (size > UpdateOffset_DelayMs)
+            if (txReserve(&reservation, 1u + (G_QueueStatsSize * G_QueueStatsCount)))
             {
-                g_updateFile.size = utility_bigEndianUint16(&data[UpdateOffset_FileSize]);
-                g_updateFile.subchunkSize = data[UpdateOffset_SubchunkSize];
-                if (g_updateFile.subchunkSize < MinChunkSize)
-                    g_updateFile.subchunkSize += ChunkSizeAdjustment;
-                g_updateFile.totalChunks = data[UpdateOffset_NumberOfChunks];
-                g_updateFile.delayMs = data[UpdateOffset_DelayMs];
+                QueueStats stats[] =
+                {
+                    queue_getStats(&g_heap->decodedRxQueue),
+                    queue_getStats(&g_heap->txQueue),
+                    i2cTouch_getXferQueueStats(),
+                };
+                
+                uint16_t payloadSize = 0;
+                reservation.payload[payloadSize++] = command;
+                for (uint8_t i = 0; i < G_QueueStatsCount; ++i)
+                    payloadSize += writeQueueStats(&reservation.payload[payloadSize], &stats[i]);
+                status = txCommit(&reservation, BridgeCommand_Stats, payloadSize);
             }
-            status = true;
+            break;
         }
-        if (flags.textStream)
+        
+        case StatsCommand_ResetQueue:
         {
-            // @TODO: figure out what this flag is supposed to do.
+            queue_resetStats(&g_heap->decodedRxQueue);
+            queue_resetStats(&g_heap->txQueue);
+            i2cTouch_resetXferQueueStats();
+            
+            uint8_t const response[] = { command };
+            status = txEnqueueCommandResponse(BridgeCommand_Stats, response, sizeof(response));
+            break;
         }
-    }
-    if (!status)
-    {
-        // @TODO: send an update error message indicating the flag wasn't
-        // recognized.
-    }
-    return status;
-}
-
-
-/// Processes the decoded UART receive packet (where the frame and escape
-/// characters are removed).
-/// @param[in]  data    The decoded received packet.
-/// @param[in]  size    The number of bytes in the decoded received packet.
-/// @return If the UART command was successfully processed or not.
-static bool processDecodedRxPacket(uint8_t* data, uint16_t size)
-{
-    bool status = false;
-    if ((data != NULL) && (size > PacketOffset_BridgeCommand))
-    {
-        status = true;
-        uint8_t command = data[PacketOffset_BridgeCommand];
-        switch (command)
+        
+        case StatsCommand_Rx:
         {
-            case BridgeCommand_Ack:
-            {
-                txEnqueueCommandResponse(BridgeCommand_Ack, NULL, 0);
-                break;
-            }
-            
-            case BridgeCommand_Error:
-            {
-                processErrorCommand(&data[PacketOffset_BridgeData], size - PacketOffset_BridgeData);
-                break;
-            }
-            
-            case BridgeCommand_SlaveAddress:
+            if (txReserve(&reservation, G_RxStatsSize))
             {
-                if (size > PacketOffset_I2cAddress)
-                    i2c_setSlaveAddress(data[PacketOffset_I2cAddress]);
-                else
-                    status = false;
-                break;
+                COMPONENT(HOST_UART, DisableInt)();
+                RxStats stats = g_rxStats;
+                COMPONENT(HOST_UART, EnableInt)();
+                
+                uint8_t* payload = reservation.payload;
+                uint16_t payloadSize = 0;
+                payload[payloadSize++] = command;
+                payload[payloadSize++] = BYTE_3_32_BIT(stats.isrCount);
+                payload[payloadSize++] = BYTE_2_32_BIT(stats.isrCount);
+                payload[payloadSize++] = BYTE_1_32_BIT(stats.isrCount);
+                payload[payloadSize++] = BYTE_0_32_BIT(stats.isrCount);
+                payload[payloadSize++] = BYTE_3_32_BIT(stats.byteCount);
+                payload[payloadSize++] = BYTE_2_32_BIT(stats.byteCount);
+                payload[payloadSize++] = BYTE_1_32_BIT(stats.byteCount);
+                payload[payloadSize++] = BYTE_0_32_BIT(stats.byteCount);
+                payload[payloadSize++] = BYTE_3_32_BIT(stats.isrTicks);
+                payload[payloadSize++] = BYTE_2_32_BIT(stats.isrTicks);
+                payload[payloadSize++] = BYTE_1_32_BIT(stats.isrTicks);
+                payload[payloadSize++] = BYTE_0_32_BIT(stats.isrTicks);
+                payload[payloadSize++] = HI_BYTE_16_BIT(stats.frameErrors);
+                payload[payloadSize++] = LO_BYTE_16_BIT(stats.frameErrors);
+                payload[payloadSize++] = HI_BYTE_16_BIT(stats.overflows);
+                payload[payloadSize++] = LO_BYTE_16_BIT(stats.overflows);
+                payload[payloadSize++] = HI_BYTE_16_BIT(stats.rawOverflows);
+                payload[payloadSize++] = LO_BYTE_16_BIT(stats.rawOverflows);
+                payload[payloadSize++] = HI_BYTE_16_BIT(stats.crcErrors);
+                payload[payloadSize++] = LO_BYTE_16_BIT(stats.crcErrors);
+                payload[payloadSize++] = HI_BYTE_16_BIT(stats.resyncs);
+                payload[payloadSize++] = LO_BYTE_16_BIT(stats.resyncs);
+                status = txCommit(&reservation, BridgeCommand_Stats, payloadSize);
             }
+            break;
+        }
+        
+        case StatsCommand_ResetRx:
+        {
+            COMPONENT(HOST_UART, DisableInt)();
+            memset((void*)&g_rxStats, 0, sizeof(g_rxStats));
+            COMPONENT(HOST_UART, EnableInt)();
             
-            case BridgeCommand_SlaveRead:
+            uint8_t const response[] = { command };
+            status = txEnqueueCommandResponse(BridgeCommand_Stats, response, sizeof(response));
+            break;
+        }
+        
+        case StatsCommand_Lanes:
+        {
+            if (txReserve(&reservation, 1u + (G_LaneStatsSize * I2cLane_Count)))
             {
-                if (size > PacketOffset_I2cData)
-                    i2cTouch_read(data[PacketOffset_I2cAddress], data[PacketOffset_I2cData]);
-                else if (size > PacketOffset_I2cAddress)
-                    // Read at least one byte.
-                    i2cTouch_read(data[PacketOffset_I2cAddress], 1u);
-                break;
+                uint8_t* payload = reservation.payload;
+                uint16_t payloadSize = 0;
+                payload[payloadSize++] = command;
+                for (uint8_t i = 0; i < I2cLane_Count; ++i)
+                {
+                    I2cLaneStats stats = i2cTouch_getLaneStats((I2cLane)i);
+                    payload[payloadSize++] = BYTE_3_32_BIT(stats.serviced);
+                    payload[payloadSize++] = BYTE_2_32_BIT(stats.serviced);
+                    payload[payloadSize++] = BYTE_1_32_BIT(stats.serviced);
+                    payload[payloadSize++] = BYTE_0_32_BIT(stats.serviced);
+                    payload[payloadSize++] = BYTE_3_32_BIT(stats.deferred);
+                    payload[payloadSize++] = BYTE_2_32_BIT(stats.deferred);
+                    payload[payloadSize++] = BYTE_1_32_BIT(stats.deferred);
+                    payload[payloadSize++] = BYTE_0_32_BIT(stats.deferred);
+                }
+                status = txCommit(&reservation, BridgeCommand_Stats, payloadSize);
             }
+            break;
+        }
+        
+        case StatsCommand_ResetLanes:
+        {
+            i2cTouch_resetLaneStats();
             
-            case BridgeCommand_LegacyVersion:
+            uint8_t const response[] = { command };
+            status = txEnqueueCommandResponse(BridgeCommand_Stats, response, sizeof(response));
+            break;
+        }
+    
+    #if ENABLE_UART_COMMAND_STATS
+        case StatsCommand_Commands:
+        {
+            uint16_t commandCount = 0;
+            for (uint8_t i = 0; i < COMMAND_TABLE_SIZE; ++i)
             {
-                txEnqueueLegacyVersion();
-                break;
+                if ((g_commandTable[i] > 0) && (g_commandStats[g_commandTable[i] - 1u].count > 0))
+                    commandCount++;
             }
             
-            case BridgeCommand_SlaveWrite:
+            if (txReserve(&reservation, 1u + (G_CommandStatsSize * commandCount)))
             {
-                if (size > PacketOffset_I2cData)
-                    i2cTouch_write(data[PacketOffset_I2cAddress], &data[PacketOffset_I2cData], size - PacketOffset_I2cData);
-                break;
+                uint8_t* payload = reservation.payload;
+                uint16_t payloadSize = 0;
+                payload[payloadSize++] = command;
+                for (uint8_t i = 0; i < COMMAND_TABLE_SIZE; ++i)
+                {
+                    if (g_commandTable[i] == 0)
+                        continue;
+                    
+                    CommandStats const* stats = &g_commandStats[g_commandTable[i] - 1u];
+                    if (stats->count == 0)
+                        continue;
+                    
+                    payload[payloadSize++] = COMMAND_TABLE_BASE + i;
+                    payload[payloadSize++] = BYTE_3_32_BIT(stats->count);
+                    payload[payloadSize++] = BYTE_2_32_BIT(stats->count);
+                    payload[payloadSize++] = BYTE_1_32_BIT(stats->count);
+                    payload[payloadSize++] = BYTE_0_32_BIT(stats->count);
+                    payload[payloadSize++] = BYTE_3_32_BIT(stats->ticks);
+                    payload[payloadSize++] = BYTE_2_32_BIT(stats->ticks);
+                    payload[payloadSize++] = BYTE_1_32_BIT(stats->ticks);
+                    payload[payloadSize++] = BYTE_0_32_BIT(stats->ticks);
+                }
+                status = txCommit(&reservation, BridgeCommand_Stats, payloadSize);
             }
+            break;
+        }
+        
+        case StatsCommand_ResetCommands:
+        {
+            memset(g_commandStats, 0, sizeof(g_commandStats));
             
-            case BridgeCommand_SlaveAck:
+            uint8_t const response[] = { command };
+            status = txEnqueueCommandResponse(BridgeCommand_Stats, response, sizeof(response));
+            break;
+        }
+    #endif // ENABLE_UART_COMMAND_STATS
+        
+        default:
+        {
+            // Unknown sub-command; no response.
+            break;
+        }
+    }
+    return status;
+}
+
+
+/// Enqueue a credit frame: the number of frames received (up to their end of
+/// frame) followed by the receive credit available once these frames were
+/// received; see processCreditCommand.
+/// @return If the credit frame was successfully enqueued.
+static bool txEnqueueCredit(void)
+{
+    // The frame count is read first: frames received before the credit is
+    // read only reduce the credit reported.
+    COMPONENT(HOST_UART, DisableInt)();
+    uint16_t frameCount = g_rxCreditFrameCount;
+    uint8_t freeFrames = g_heap->decodedRxQueue.maxSize - queue_getSize(&g_heap->decodedRxQueue);
+    uint16_t freeBytes = queue_getFreeDataSize(&g_heap->decodedRxQueue);
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    // The received bytes wait in the raw receive queue until they're parsed.
+    uint16_t rawFreeBytes = byteQueue_getFreeSize(&g_heap->rawRxQueue);
+    if (rawFreeBytes < freeBytes)
+        freeBytes = rawFreeBytes;
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+    COMPONENT(HOST_UART, EnableInt)();
+    
+    uint8_t response[CreditOffset_End];
+    response[CreditOffset_FrameCount] = HI_BYTE_16_BIT(frameCount);
+    response[CreditOffset_FrameCount + 1u] = LO_BYTE_16_BIT(frameCount);
+    response[CreditOffset_FreeFrames] = freeFrames;
+    response[CreditOffset_FreeBytes] = HI_BYTE_16_BIT(freeBytes);
+    response[CreditOffset_FreeBytes + 1u] = LO_BYTE_16_BIT(freeBytes);
+    return txEnqueueCommandResponse(BridgeCommand_Credit, response, sizeof(response));
+}
+
+
+/// Processes the credit command from the host: reports the receive credit of
+/// the host UART link in a credit frame (see CreditOffset) and, with a data
+/// payload, enables (non-zero) or disables (0) the credit frames sent whenever
+/// credit is released (a frame is done or dropped). The credit frame reports
+/// the number of frames received so far (wraps around) and the number of free
+/// decoded receive queue elements and bytes once these frames were received.
+/// The host subtracts the frames (and their size on the wire) it sent after
+/// the frames reported to get the frames (and bytes) it may still send. The
+/// frames the bridge never saw the end of (cut off by a resynchronization) are
+/// not counted; the host realigns its frame count when it has no frames
+/// outstanding.
+/// @param[in]  data    The data payload from the credit command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the credit frame was successfully enqueued.
+static bool processCreditCommand(uint8_t const* data, uint16_t size)
+{
+    if ((data != NULL) && (size > 0))
+        g_creditReportEnabled = (data[0] != 0);
+    return txEnqueueCredit();
+}
+
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// Drops the reference reports of the delta encoding; the next report of
+    /// each report command is sent as a keyframe.
+    static void resetDeltaReferences(void)
+    {
+        if (g_delta.references != NULL)
+        {
+            for (uint8_t i = 0; i < UART_DELTA_REFERENCE_COUNT; ++i)
+                g_delta.references[i].size = 0;
+        }
+        g_delta.nextReference = 0;
+    }
+    
+    
+    /// Processes the delta command from the host; see DeltaCommand.
+    /// @param[in]  data    The data payload from the delta command.
+    /// @param[in]  size    The size of the data payload.
+    /// @return If the command succeeded and the response was successfully
+    ///         enqueued.
+    static bool processDeltaCommand(uint8_t const* data, uint16_t size)
+    {
+        DeltaCommand command = DeltaCommand_Get;
+        if ((data != NULL) && (size > 0))
+            command = (DeltaCommand)data[0];
+        
+        bool status = true;
+        switch (command)
+        {
+            case DeltaCommand_Get:
             {
-                I2cStatus i2cStatus;
-                if (size > PacketOffset_BridgeData)
-                    i2cStatus = i2c_ack(data[PacketOffset_BridgeData], 0);
-                else
-                    i2cStatus = i2c_ackApp(0);
-                if (!i2c_errorOccurred(i2cStatus))
-                    txEnqueueCommandResponse(BridgeCommand_SlaveAck, NULL, 0);
                 break;
             }
             
-            case BridgeCommand_SlaveUpdate:
+            case DeltaCommand_Enable:
             {
-                if (size > PacketOffset_BridgeData)
-                    processSlaveUpdateCommand(&data[PacketOffset_BridgeData], size - PacketOffset_BridgeData);
+                g_delta.keyframeInterval = (size > 1u) ? (data[1]) : (UART_DELTA_KEYFRAME_INTERVAL);
+                if (!g_delta.enabled)
+                    resetDeltaReferences();
+                g_delta.enabled = true;
                 break;
             }
             
-            case BridgeCommand_Reset:
+            case DeltaCommand_Disable:
             {
-                CySoftwareReset();
+                g_delta.enabled = false;
                 break;
             }
             
-            case BridgeCommand_Version:
+            case DeltaCommand_Resync:
             {
-                txEnqueueVersion();
+                resetDeltaReferences();
                 break;
             }
             
             default:
             {
-                // Should not get here.
+                // Unknown sub-command; no response.
                 status = false;
                 break;
             }
         }
+        
+        if (status)
+        {
+            uint8_t const response[] = { command, g_delta.enabled, g_delta.keyframeInterval };
+            status = txEnqueueCommandResponse(BridgeCommand_Delta, response, sizeof(response));
+        }
+        return status;
+    }
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+
+/// Processes the CRC command from the host: enables (non-zero) or disables (0)
+/// the CRC-16 trailer of the frames in both directions. The response (the
+/// setting) is sent with the previous setting; the new setting applies to the
+/// frames the host sends once it receives the response. Without a data payload
+/// the current setting is reported.
+/// @param[in]  data    The data payload from the CRC command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the response was successfully enqueued.
+static bool processCrcCommand(uint8_t const* data, uint16_t size)
+{
+    bool enable = g_rxCrcEnabled;
+    if ((data != NULL) && (size > 0))
+        enable = (data[0] != 0);
+    
+    uint8_t const response[] = { enable };
+    bool status = txEnqueueCommandResponse(BridgeCommand_Crc, response, sizeof(response));
+    if (status)
+    {
+        g_rxCrcEnabled = enable;
+    #if ENABLE_UART_TX_LAZY_ENCODING
+        // The transmit stream switches once the response is sent.
+        g_txCrcRequested = enable;
+    #else
+        g_txCrcEnabled = enable;
+    #endif // ENABLE_UART_TX_LAZY_ENCODING
     }
     return status;
 }
 
 
-/// Processes the received data payload byte from the update packet. These bytes
-/// already have the 0xaa framing and header information parsed out.
-/// @param[in]  data    The byte to process.
-/// @return The RxUpdatebyteStatus indicating success, error, or if the byte
-///         corresponds to the end of a subchunk, chunk or update file.
-static RxUpdateByteStatus processRxUpdateByte(uint8_t data)
+/// Processes the baud command from the host; see BaudCommand.
+/// @param[in]  data    The data payload from the baud command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the command succeeded and the response was successfully
+///         enqueued.
+static bool processBaudCommand(uint8_t const* data, uint16_t size)
 {
-    RxUpdateByteStatus status = RxUpdateByteStatus_Success;
-    if (queue_enqueueByte(&g_heap->decodedRxQueue, data, false))
+    BaudCommand command = BaudCommand_Get;
+    if ((data != NULL) && (size > BaudOffset_Command))
+        command = (BaudCommand)data[BaudOffset_Command];
+    
+    bool status = false;
+    uint32_t divider = g_baud.divider;
+    switch (command)
     {
-        g_updateFile.updateChunk->subchunkSize++;
-        g_updateFile.updateChunk->size++;
-        g_updateFile.size++;
-        if (g_updateFile.size >= g_updateFile.totalSize)
+        case BaudCommand_Get:
         {
-            
-            queue_enqueueFinalize(&g_heap->decodedRxQueue);
-            status = RxUpdateByteStatus_FileComplete;
+            status = true;
+            break;
         }
-        else if (g_updateFile.updateChunk->size >= g_updateFile.updateChunk->totalSize)
+        
+        case BaudCommand_Switch:
         {
-            queue_enqueueFinalize(&g_heap->decodedRxQueue);
-            status = RxUpdateByteStatus_ChunkComplete;
+            if ((size >= BaudOffset_End) && (g_baud.state == BaudState_Idle))
+            {
+                uint32_t switchDivider = calculateClockDivider(utility_bigEndianUint32(&data[BaudOffset_BaudRate]));
+                if (switchDivider > 0)
+                {
+                    divider = switchDivider;
+                    status = true;
+                }
+            }
+            break;
         }
-        else if (g_updateFile.updateChunk->subchunkSize >= g_updateFile.subchunkSize)
+        
+        case BaudCommand_Commit:
         {
-            queue_enqueueFinalize(&g_heap->decodedRxQueue);
-            g_updateFile.updateChunk->subchunkSize = 0;
-            status = RxUpdateByteStatus_SubchunkComplete;
+            if (g_baud.state == BaudState_CommitPending)
+            {
+                alarm_disarm(&g_baud.commitAlarm);
+                g_baud.state = BaudState_Idle;
+                status = true;
+            }
+            break;
+        }
+        
+        default:
+        {
+            // Unknown sub-command; no response.
+            return false;
         }
     }
-    else
-        status = RxUpdateByteStatus_Error;
+    
+    uint32_t baudRate = calculateBaudRate(divider);
+    uint8_t const response[] =
+    {
+        command,
+        BYTE_3_32_BIT(baudRate),
+        BYTE_2_32_BIT(baudRate),
+        BYTE_1_32_BIT(baudRate),
+        BYTE_0_32_BIT(baudRate),
+    };
+    status = txEnqueueCommandResponse(BridgeCommand_Baud, response, sizeof(response)) && status;
+    
+    // Hold the transmit stream once the response is sent so nothing else is
+    // sent while the baud rate switches (see processBaudSwitch).
+    if (status && (command == BaudCommand_Switch))
+    {
+        COMPONENT(HOST_UART, DisableInt)();
+        g_txStream.holdCount = g_txStream.sentCount + queue_getSize(&g_heap->txQueue);
+        g_txStream.hold = true;
+        COMPONENT(HOST_UART, EnableInt)();
+        g_baud.pendingDivider = divider;
+        g_baud.state = BaudState_SwitchPending;
+    }
     return status;
 }
 
 
-/// Processes the received byte and removes the framing protocol to get a pure
+/// Processes the I2C speed command from the host; see I2cSpeedCommand.
+/// @param[in]  data    The data payload from the I2C speed command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the command succeeded and the response was successfully
+///         enqueued.
+static bool processI2cSpeedCommand(uint8_t const* data, uint16_t size)
+{
+    I2cSpeedCommand command = I2cSpeedCommand_Get;
+    if ((data != NULL) && (size > I2cSpeedOffset_Command))
+        command = (I2cSpeedCommand)data[I2cSpeedOffset_Command];
+    
+    bool status = false;
+    switch (command)
+    {
+        case I2cSpeedCommand_Get:
+        {
+            status = true;
+            break;
+        }
+        
+        case I2cSpeedCommand_Set:
+        {
+            if (size >= I2cSpeedOffset_End)
+                status = i2c_setBitRate(utility_bigEndianUint32(&data[I2cSpeedOffset_BitRate]));
+            break;
+        }
+        
+        case I2cSpeedCommand_Save:
+        {
+            // Keep the other saved settings.
+            Settings settings = { 0u };
+            settings_load(&settings);
+            settings.i2cBitRate = i2c_getBitRate();
+            status = settings_save(&settings);
+            break;
+        }
+        
+        default:
+        {
+            // Unknown sub-command; no response.
+            return false;
+        }
+    }
+    
+    uint32_t bitRate = i2c_getBitRate();
+    uint8_t const response[] =
+    {
+        command,
+        BYTE_3_32_BIT(bitRate),
+        BYTE_2_32_BIT(bitRate),
+        BYTE_1_32_BIT(bitRate),
+        BYTE_0_32_BIT(bitRate),
+    };
+    return txEnqueueCommandResponse(BridgeCommand_I2cSpeed, response, sizeof(response)) && status;
+}
+
+
+/// Processes the lane policy command from the host: sets the scheduling policy
+/// between the I2C transfer lanes if the data payload has the policy and the
+/// weights (see LanePolicyOffset); an empty data payload only reports it. The
+/// response is the active policy followed by the slave IRQ and host lane
+/// weights (1 byte each).
+/// @param[in]  data    The data payload from the lane policy command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the command succeeded and the response was successfully
+///         enqueued; false if the policy is invalid.
+static bool processLanePolicyCommand(uint8_t const* data, uint16_t size)
+{
+    if ((data != NULL) && (size >= LanePolicyOffset_End))
+    {
+        if (data[LanePolicyOffset_Policy] > I2cLanePolicy_WeightedRoundRobin)
+            return false;
+        i2cTouch_setLanePolicy((I2cLanePolicy)data[LanePolicyOffset_Policy], data[LanePolicyOffset_SlaveIrqWeight], data[LanePolicyOffset_HostWeight]);
+    }
+    
+    uint8_t slaveIrqWeight = 0;
+    uint8_t hostWeight = 0;
+    I2cLanePolicy policy = i2cTouch_getLanePolicy(&slaveIrqWeight, &hostWeight);
+    uint8_t const response[] = { policy, slaveIrqWeight, hostWeight };
+    return txEnqueueCommandResponse(BridgeCommand_LanePolicy, response, sizeof(response));
+}
+
+
+/// Processes the receive timeout command from the host: sets the receive frame
+/// timeout in microseconds (big-endian, 4 bytes; 0 disables it). If the
+/// receive line is idle for the timeout within a frame, the partial frame is
+/// discarded; a dropped end frame byte then costs one frame instead of
+/// corrupting the frames that follow. Set it to a few character times at the
+/// current baud rate if the host sends each frame without pauses. Without a
+/// data payload (or above G_RxTimeoutMaxUs), the timeout isn't changed. The
+/// response is the receive frame timeout in microseconds.
+/// @param[in]  data    The data payload from the receive timeout command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the response was successfully enqueued.
+static bool processRxTimeoutCommand(uint8_t const* data, uint16_t size)
+{
+    if ((data != NULL) && (size >= sizeof(uint32_t)))
+    {
+        uint32_t timeoutUs = utility_bigEndianUint32(data);
+        if (timeoutUs <= G_RxTimeoutMaxUs)
+        {
+            g_rxTimeoutUs = timeoutUs;
+            g_rxTimeoutTicks = timeoutUs * TICKS_PER_US;
+        }
+    }
+    
+    uint8_t const response[] =
+    {
+        BYTE_3_32_BIT(g_rxTimeoutUs),
+        BYTE_2_32_BIT(g_rxTimeoutUs),
+        BYTE_1_32_BIT(g_rxTimeoutUs),
+        BYTE_0_32_BIT(g_rxTimeoutUs),
+    };
+    return txEnqueueCommandResponse(BridgeCommand_RxTimeout, response, sizeof(response));
+}
+
+
+/// Processes the sequence command from the host: enables (non-zero) or disables
+/// (0) the sequence IDs of the frames in both directions. With sequence IDs,
+/// every frame the host sends has a sequence ID (1 byte) after the command and
+/// every frame the bridge sends has the sequence ID of the request it responds
+/// to after the command (data frames start with it): command responses, the
+/// data of reads and the errors of the transfers the request queued. The frames
+/// the bridge sends on its own have G_UnsolicitedSequenceId. The response (the
+/// setting) is sent with the previous setting. Without a data payload the
+/// current setting is reported.
+/// @param[in]  data    The data payload from the sequence command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the response was successfully enqueued.
+static bool processSequenceCommand(uint8_t const* data, uint16_t size)
+{
+    bool enable = g_sequenceEnabled;
+    if ((data != NULL) && (size > 0))
+        enable = (data[0] != 0);
+    
+    uint8_t const response[] = { enable };
+    bool status = txEnqueueCommandResponse(BridgeCommand_Sequence, response, sizeof(response));
+    if (status)
+        g_sequenceEnabled = enable;
+    return status;
+}
+
+
+/// Processes the framing command from the host: selects the framing protocol
+/// of the frames in both directions (see Framing). The response (the framing)
+/// is sent with the previous framing; the new framing applies to the frames
+/// the host sends once it receives the response. Without a data payload (or
+/// with an unknown framing) the current framing is reported.
+/// @param[in]  data    The data payload from the framing command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the response was successfully enqueued.
+static bool processFramingCommand(uint8_t const* data, uint16_t size)
+{
+    Framing framing = g_rxFraming;
+    if ((data != NULL) && (size > 0) && (data[0] <= Framing_Cobs))
+        framing = (Framing)data[0];
+    
+    uint8_t const response[] = { framing };
+    bool status = txEnqueueCommandResponse(BridgeCommand_Framing, response, sizeof(response));
+    if (status)
+    {
+        // Start the next frame with the new framing; the host doesn't send
+        // anything until it receives the response.
+        COMPONENT(HOST_UART, DisableInt)();
+        queue_enqueueDiscard(&g_heap->decodedRxQueue);
+        g_rxFraming = framing;
+        g_rxState = (framing == Framing_Cobs) ? (RxState_CobsStart) : (RxState_OutOfFrame);
+        COMPONENT(HOST_UART, EnableInt)();
+    #if ENABLE_UART_TX_LAZY_ENCODING
+        // The transmit stream switches once the response is sent.
+        g_txFramingRequested = framing;
+    #else
+        g_txFraming = framing;
+    #endif // ENABLE_UART_TX_LAZY_ENCODING
+    }
+    return status;
+}
+
+
+/// Executes a sub-command of a BridgeCommand_Batch command. The sub-commands
+/// behave like the standalone commands except that BridgeCommand_SlaveAck
+/// doesn't send its own response.
+/// @param[in]  data    The sub-command followed by its data payload.
+/// @param[in]  size    The size of the sub-command and its data payload.
+/// @param[out] i2cStatus   The status of the I2C operation.
+/// @return If the sub-command is allowed in a batch and well-formed.
+static bool processBatchSubcommand(uint8_t const* data, uint16_t size, I2cStatus* i2cStatus)
+{
+    bool status = true;
+    i2cStatus->mask = 0u;
+    switch (data[PacketOffset_BridgeCommand])
+    {
+        case BridgeCommand_SlaveAddress:
+        {
+            if (size > (PacketOffset_I2cAddress + 1u))
+                status = i2c_setSlaveContextAddress(data[PacketOffset_I2cAddress + 1u], data[PacketOffset_I2cAddress]);
+            else if (size > PacketOffset_I2cAddress)
+                i2c_setSlaveAddress(data[PacketOffset_I2cAddress]);
+            else
+                status = false;
+            break;
+        }
+        
+        case BridgeCommand_SlaveRead:
+        {
+            if (size > PacketOffset_I2cData)
+                *i2cStatus = i2cTouch_read(data[PacketOffset_I2cAddress], data[PacketOffset_I2cData], g_txSequenceId);
+            else if (size > PacketOffset_I2cAddress)
+                *i2cStatus = i2cTouch_read(data[PacketOffset_I2cAddress], 1u, g_txSequenceId);
+            else
+                status = false;
+            break;
+        }
+        
+        case BridgeCommand_SlaveWrite:
+        {
+            if (size > PacketOffset_I2cData)
+                *i2cStatus = i2cTouch_write(data[PacketOffset_I2cAddress], &data[PacketOffset_I2cData], size - PacketOffset_I2cData, g_txSequenceId);
+            else
+                status = false;
+            break;
+        }
+        
+        case BridgeCommand_SlaveWriteRead:
+        {
+            if (size > PacketOffset_I2cWriteReadData)
+                *i2cStatus = i2cTouch_writeRead(data[PacketOffset_I2cAddress], &data[PacketOffset_I2cWriteReadData], size - PacketOffset_I2cWriteReadData, data[PacketOffset_I2cData], g_txSequenceId);
+            else
+                status = false;
+            break;
+        }
+        
+        case BridgeCommand_SlaveAck:
+        {
+            if (size > PacketOffset_BridgeData)
+                *i2cStatus = i2c_ack(data[PacketOffset_BridgeData], 0);
+            else
+                *i2cStatus = i2c_ackApp(0);
+            break;
+        }
+        
+        default:
+        {
+            status = false;
+            break;
+        }
+    }
+    return status;
+}
+
+
+/// Processes the batch command from the host: the data payload is a sequence of
+/// sub-commands, each preceded by its size (1 byte: the sub-command and its data
+/// payload). The I2C sub-commands (BridgeCommand_SlaveAddress,
+/// BridgeCommand_SlaveRead, BridgeCommand_SlaveWrite,
+/// BridgeCommand_SlaveWriteRead and BridgeCommand_SlaveAck) are executed in
+/// order; the read data is sent like for the standalone reads. Once the batch
+/// is done, one response reports the number of sub-commands executed
+/// (big-endian, 2 bytes) and the BatchStatus.
+/// If the I2C transfer queue is full, the batch pauses and is resumed by the
+/// next call with the same data payload.
+/// @param[in]  data    The data payload from the batch command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the batch is done; false if it's paused.
+static bool processBatchCommand(uint8_t const* data, uint16_t size)
+{
+    BatchStatus batchStatus = BatchStatus_Complete;
+    if (!g_batch.paused)
+    {
+        g_batch.offset = 0;
+        g_batch.count = 0;
+    }
+    g_batch.paused = false;
+    while ((batchStatus == BatchStatus_Complete) && (g_batch.offset < size))
+    {
+        uint16_t subcommandSize = data[g_batch.offset];
+        uint16_t subcommandOffset = g_batch.offset + 1u;
+        if ((subcommandSize == 0) || ((subcommandOffset + subcommandSize) > size))
+        {
+            batchStatus = BatchStatus_InvalidSubcommand;
+            break;
+        }
+        
+        I2cStatus i2cStatus;
+        g_batch.executing = true;
+        bool valid = processBatchSubcommand(&data[subcommandOffset], subcommandSize, &i2cStatus);
+        g_batch.executing = false;
+        if (!valid)
+            batchStatus = BatchStatus_InvalidSubcommand;
+        else if (isI2cQueueFull(i2cStatus))
+        {
+            // Retry once the I2C module has sent some of the transfers; give
+            // up if it makes no progress.
+            if (!g_batch.stallAlarm.armed)
+                alarm_arm(&g_batch.stallAlarm, G_BatchStallTimeoutMs, AlarmType_ContinuousNotification);
+            if (!alarm_hasElapsed(&g_batch.stallAlarm))
+            {
+                g_batch.paused = true;
+                return false;
+            }
+            batchStatus = BatchStatus_Stalled;
+        }
+        else if (i2c_errorOccurred(i2cStatus))
+            batchStatus = BatchStatus_I2cError;
+        else
+        {
+            alarm_disarm(&g_batch.stallAlarm);
+            g_batch.offset = subcommandOffset + subcommandSize;
+            g_batch.count++;
+        }
+    }
+    
+    alarm_disarm(&g_batch.stallAlarm);
+    uint8_t const response[] = { HI_BYTE_16_BIT(g_batch.count), LO_BYTE_16_BIT(g_batch.count), batchStatus };
+    txEnqueueCommandResponse(BridgeCommand_Batch, response, sizeof(response));
+    return true;
+}
+
+
+/// Processes the slave update command from the host.
+/// @param[in]  data    The data payload from the error command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the slave update command was processed successfully.
+static bool processSlaveUpdateCommand(uint8_t const* data, uint16_t size)
+{
+    static uint16_t const MinChunkDataSize = 8u;
+    static uint16_t const MinChunkHeaderSize = 14u;
+    static uint16_t const MinChunkSize = MinChunkDataSize + MinChunkHeaderSize;
+    static uint16_t const ChunkSizeAdjustment = 256u;
+    
+    bool status = false;
+    if (size > UpdateOffset_Flags)
+    {
+        UpdateFlags flags = { data[UpdateOffset_Flags] };
+        if (flags.initiate)
+        {
+            // @TODO: figure out what this flag is supposed to do.
+        }
+        if (flags.updateFileInfo)
+        {
+            if (size > UpdateOffset_DelayMs)
+            {
+                g_updateFile.size = utility_bigEndianUint16(&data[UpdateOffset_FileSize]);
+                g_updateFile.subchunkSize = data[UpdateOffset_SubchunkSize];
+                if (g_updateFile.subchunkSize < MinChunkSize)
+                    g_updateFile.subchunkSize += ChunkSizeAdjustment;
+                g_updateFile.totalChunks = data[UpdateOffset_NumberOfChunks];
+                g_updateFile.delayMs = data[UpdateOffset_DelayMs];
+            }
+            status = true;
+        }
+        if (flags.textStream)
+        {
+            // @TODO: figure out what this flag is supposed to do.
+        }
+    }
+    if (!status)
+    {
+        // @TODO: send an update error message indicating the flag wasn't
+        // recognized.
+    }
+    return status;
+}
+
+
+/// Processes the ACK command from the host: responds with an ACK.
+/// @param[in]  data    The data payload from the ACK command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the ACK was successfully enqueued.
+static bool processAckCommand(uint8_t const* data, uint16_t size)
+{
+    (void)data;
+    (void)size;
+    return txEnqueueCommandResponse(BridgeCommand_Ack, NULL, 0);
+}
+
+
+/// Processes the slave address command from the host: sets the address of the
+/// I2C slave. The optional byte after the address selects the slave context
+/// (see I2C_SLAVE_COUNT); slave context 0 if omitted.
+/// @param[in]  data    The data payload from the slave address command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the command was processed; false if the slave context doesn't
+///         exist.
+static bool processSlaveAddressCommand(uint8_t const* data, uint16_t size)
+{
+    uint8_t slave = (size > 1u) ? (data[1]) : (0u);
+    return i2c_setSlaveContextAddress(slave, data[0]);
+}
+
+
+/// Processes the slave read command from the host: queues a read of the I2C
+/// slave; the optional byte after the I2C address is the number of bytes to
+/// read (at least one byte is read).
+/// @param[in]  data    The data payload from the slave read command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the read was queued.
+static bool processSlaveReadCommand(uint8_t const* data, uint16_t size)
+{
+    uint16_t readSize = (size > 1u) ? (data[1]) : (1u);
+    return !i2c_errorOccurred(i2cTouch_read(data[0], readSize, g_txSequenceId));
+}
+
+
+/// Processes the slave write command from the host: queues a write of the data
+/// that follows the I2C address to the I2C slave.
+/// @param[in]  data    The data payload from the slave write command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the write was queued.
+static bool processSlaveWriteCommand(uint8_t const* data, uint16_t size)
+{
+    return !i2c_errorOccurred(i2cTouch_write(data[0], &data[1], size - 1u, g_txSequenceId));
+}
+
+
+/// Processes the slave write-read command from the host: queues a write of the
+/// data that follows the I2C address and the number of bytes to read (for
+/// example, a register address) followed by a read with a repeated START. This
+/// takes one I2C transfer and one response frame with the read data instead of
+/// a slave write and a slave read.
+/// @param[in]  data    The data payload from the slave write-read command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the write-read was queued.
+static bool processSlaveWriteReadCommand(uint8_t const* data, uint16_t size)
+{
+    return !i2c_errorOccurred(i2cTouch_writeRead(data[0], &data[2], size - 2u, data[1], g_txSequenceId));
+}
+
+
+/// Processes the slave ACK command from the host: checks if the I2C slave at
+/// the optional I2C address (otherwise, the application address) ACKs and
+/// responds with a slave ACK if it does.
+/// @param[in]  data    The data payload from the slave ACK command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the I2C slave ACKed.
+static bool processSlaveAckCommand(uint8_t const* data, uint16_t size)
+{
+    I2cStatus i2cStatus;
+    if (size > 0)
+        i2cStatus = i2c_ack(data[0], 0);
+    else
+        i2cStatus = i2c_ackApp(0);
+    
+    bool status = !i2c_errorOccurred(i2cStatus);
+    if (status)
+        txEnqueueCommandResponse(BridgeCommand_SlaveAck, NULL, 0);
+    return status;
+}
+
+
+/// Processes the legacy version command from the host.
+/// @param[in]  data    The data payload from the legacy version command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the version response was successfully enqueued.
+static bool processLegacyVersionCommand(uint8_t const* data, uint16_t size)
+{
+    (void)data;
+    (void)size;
+    return txEnqueueLegacyVersion();
+}
+
+
+/// Processes the version command from the host.
+/// @param[in]  data    The data payload from the version command.
+/// @param[in]  size    The size of the data payload.
+/// @return If the version response was successfully enqueued.
+static bool processVersionCommand(uint8_t const* data, uint16_t size)
+{
+    (void)data;
+    (void)size;
+    return txEnqueueVersion();
+}
+
+
+/// Processes the reset command from the host: resets the bridge.
+/// @param[in]  data    The data payload from the reset command.
+/// @param[in]  size    The size of the data payload.
+/// @return Doesn't return.
+static bool processResetCommand(uint8_t const* data, uint16_t size)
+{
+    (void)data;
+    (void)size;
+    CySoftwareReset();
+    return true;
+}
+
+
+/// The built-in command handlers in command order; handler number
+/// COMMAND_REGISTERED_MAX_COUNT + i is G_CommandHandlers[i] (see
+/// initCommandTable).
+static CommandHandler const G_CommandHandlers[] =
+{
+    { processAckCommand,            BridgeCommand_Ack,              0u },
+    { processSlaveUpdateCommand,    BridgeCommand_SlaveUpdate,      1u },
+    { processCrcCommand,            BridgeCommand_Crc,              0u },
+#if ENABLE_UART_TX_DELTA_REPORTS
+    { processDeltaCommand,          BridgeCommand_Delta,            0u },
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+    { processErrorCommand,          BridgeCommand_Error,            0u },
+    { processI2cSpeedCommand,       BridgeCommand_I2cSpeed,         0u },
+    { processSlaveAddressCommand,   BridgeCommand_SlaveAddress,     1u },
+    { processCreditCommand,         BridgeCommand_Credit,           0u },
+    { processLanePolicyCommand,     BridgeCommand_LanePolicy,       0u },
+    { processBatchCommand,          BridgeCommand_Batch,            0u },
+    { processSlaveReadCommand,      BridgeCommand_SlaveRead,        1u },
+    { processStatsCommand,          BridgeCommand_Stats,            0u },
+    { processLegacyVersionCommand,  BridgeCommand_LegacyVersion,    0u },
+    { processSlaveWriteCommand,     BridgeCommand_SlaveWrite,       2u },
+    { processSlaveAckCommand,       BridgeCommand_SlaveAck,         0u },
+    { processBaudCommand,           BridgeCommand_Baud,             0u },
+    { processFramingCommand,        BridgeCommand_Framing,          0u },
+    { processSequenceCommand,       BridgeCommand_Sequence,         0u },
+    { processResetCommand,          BridgeCommand_Reset,            0u },
+    { processRxTimeoutCommand,      BridgeCommand_RxTimeout,        0u },
+    { processVersionCommand,        BridgeCommand_Version,          0u },
+    { processSlaveWriteReadCommand, BridgeCommand_SlaveWriteRead,   3u },
+};
+
+
+/// Get a command handler by handler number: the registered handlers come
+/// first followed by the built-in handlers.
+/// @param[in]  handlerNumber   The handler number.
+/// @return The command handler.
+static CommandHandler const* getCommandHandler(uint8_t handlerNumber)
+{
+    if (handlerNumber < COMMAND_REGISTERED_MAX_COUNT)
+        return &g_registeredCommandHandlers[handlerNumber];
+    return &G_CommandHandlers[handlerNumber - COMMAND_REGISTERED_MAX_COUNT];
+}
+
+
+/// Builds the command table from the built-in handlers and the registered
+/// handlers; a registered handler takes the place of the built-in handler of
+/// its command.
+static void initCommandTable(void)
+{
+    static uint8_t const BuiltInCount = sizeof(G_CommandHandlers) / sizeof(G_CommandHandlers[0]);
+    
+    memset(g_commandTable, 0, sizeof(g_commandTable));
+    for (uint8_t i = 0; (i < BuiltInCount) && ((COMMAND_REGISTERED_MAX_COUNT + i) < COMMAND_HANDLER_MAX_COUNT); ++i)
+        g_commandTable[G_CommandHandlers[i].command - COMMAND_TABLE_BASE] = COMMAND_REGISTERED_MAX_COUNT + i + 1u;
+    for (uint8_t i = 0; i < COMMAND_REGISTERED_MAX_COUNT; ++i)
+    {
+        if (g_registeredCommandHandlers[i].handler != NULL)
+            g_commandTable[g_registeredCommandHandlers[i].command - COMMAND_TABLE_BASE] = i + 1u;
+    }
+}
+
+
+/// Processes the decoded UART receive packet (where the frame and escape
+/// characters are removed): the command byte selects the handler in the
+/// command table (see initCommandTable), which gets the data payload.
+/// @param[in]  data    The decoded received packet.
+/// @param[in]  size    The number of bytes in the decoded received packet.
+/// @return If the UART command was successfully processed or not.
+static bool processDecodedRxPacket(uint8_t* data, uint16_t size)
+{
+    bool status = false;
+    if ((data != NULL) && (size > PacketOffset_BridgeCommand))
+    {
+        uint8_t command = data[PacketOffset_BridgeCommand];
+        
+        // Tag the responses with the sequence ID and skip it so the sequence
+        // ID takes the place of the command and the offsets still apply.
+        if (g_sequenceEnabled)
+        {
+            if (size > PacketOffset_SequenceId)
+            {
+                g_txSequenceId = data[PacketOffset_SequenceId];
+                data += PacketOffset_SequenceId;
+                size -= PacketOffset_SequenceId;
+            }
+            else
+                command = BridgeCommand_None;
+        }
+        
+        uint8_t handlerNumber = 0;
+        if ((command >= COMMAND_TABLE_BASE) && (command < (COMMAND_TABLE_BASE + COMMAND_TABLE_SIZE)))
+            handlerNumber = g_commandTable[command - COMMAND_TABLE_BASE];
+        if (handlerNumber > 0)
+        {
+            CommandHandler const* handler = getCommandHandler(handlerNumber - 1u);
+            uint16_t payloadSize = size - PacketOffset_BridgeData;
+            if (payloadSize >= handler->minSize)
+            {
+            #if ENABLE_UART_COMMAND_STATS
+                uint32_t startTicks = hwSystemTime_getTimestamp();
+            #endif // ENABLE_UART_COMMAND_STATS
+                status = handler->handler(&data[PacketOffset_BridgeData], payloadSize);
+            #if ENABLE_UART_COMMAND_STATS
+                CommandStats* stats = &g_commandStats[handlerNumber - 1u];
+                stats->count++;
+                stats->ticks += hwSystemTime_getTimestamp() - startTicks;
+            #endif // ENABLE_UART_COMMAND_STATS
+            }
+        }
+        g_txSequenceId = G_UnsolicitedSequenceId;
+    }
+    return status;
+}
+
+
+/// Processes the received data payload byte from the update packet. These bytes
+/// already have the 0xaa framing and header information parsed out.
+/// @param[in]  data    The byte to process.
+/// @return The RxUpdatebyteStatus indicating success, error, or if the byte
+///         corresponds to the end of a subchunk, chunk or update file.
+static RxUpdateByteStatus processRxUpdateByte(uint8_t data)
+{
+    RxUpdateByteStatus status = RxUpdateByteStatus_Success;
+    if (queue_enqueueByte(&g_heap->decodedRxQueue, data, false))
+    {
+        g_updateFile.updateChunk->subchunkSize++;
+        g_updateFile.updateChunk->size++;
+        g_updateFile.size++;
+        if (g_updateFile.size >= g_updateFile.totalSize)
+        {
+            
+            queue_enqueueFinalize(&g_heap->decodedRxQueue);
+            status = RxUpdateByteStatus_FileComplete;
+        }
+        else if (g_updateFile.updateChunk->size >= g_updateFile.updateChunk->totalSize)
+        {
+            queue_enqueueFinalize(&g_heap->decodedRxQueue);
+            status = RxUpdateByteStatus_ChunkComplete;
+        }
+        else if (g_updateFile.updateChunk->subchunkSize >= g_updateFile.subchunkSize)
+        {
+            queue_enqueueFinalize(&g_heap->decodedRxQueue);
+            g_updateFile.updateChunk->subchunkSize = 0;
+            status = RxUpdateByteStatus_SubchunkComplete;
+        }
+    }
+    else
+        status = RxUpdateByteStatus_Error;
+    return status;
+}
+
+
+/// Adds the decoded frame received to the decoded receive queue. If the CRC-16
+/// trailer is enabled, the CRC-16 is checked and removed; the frame is dropped
+/// if it doesn't match.
+/// @return If the decoded frame was added to the decoded receive queue.
+static bool finalizeRxFrame(void)
+{
+    bool status = true;
+    if (g_rxCrcEnabled)
+    {
+        // The CRC-16 includes the trailer so it's the residue if it matches.
+        status = (g_rxCrc == CRC16_RESIDUE) && queue_enqueueTruncate(&g_heap->decodedRxQueue, FRAME_CRC_SIZE);
+        if (!status)
+        {
+            queue_enqueueDiscard(&g_heap->decodedRxQueue);
+            if (g_rxStats.crcErrors < UINT16_MAX)
+                g_rxStats.crcErrors++;
+        }
+    }
+    
+    if (status)
+        status = queue_enqueueFinalize(&g_heap->decodedRxQueue);
+    else
+        g_creditReportPending = true;
+    g_rxCreditFrameCount++;
+
+#if ENABLE_UART_AUTO_BAUD
+    if (status)
+        g_rxFrameCount++;
+#endif // ENABLE_UART_AUTO_BAUD
+    return status;
+}
+
+
+/// Adds a decoded byte of the frame being received to the decoded receive
+/// queue and to the CRC-16 of the frame.
+/// @param[in]  data    The decoded byte.
+/// @return If the byte was added to the decoded receive queue.
+static bool enqueueRxFrameByte(uint8_t data)
+{
+    bool status = queue_enqueueByte(&g_heap->decodedRxQueue, data, false);
+    if (!status)
+        handleRxFrameOverflow(data);
+    else if (g_rxCrcEnabled)
+        g_rxCrc = crc16_updateByte(g_rxCrc, data);
+    return status;
+}
+
+
+/// Processes the received byte and removes the framing protocol to get a pure
 /// data buffer.
 /// @param[in]  data    The byte to process.
 /// @return If the byte was valid data when processing through the framing
 ///         protocol.
 static bool processRxByte(uint8_t data)
 {
-    bool status = true;
-    switch (g_rxState)
+    bool status = true;
+    switch (g_rxState)
+    {
+        case RxState_OutOfFrame:
+        {
+            // With COBS framing, the next frame starts after the delimiter.
+            if ((g_rxFraming == Framing_Cobs) && (data == ControlByte_CobsDelimiter))
+                g_rxState = RxState_CobsStart;
+            else if ((g_rxFraming == Framing_Escape) && (data == ControlByte_StartFrame))
+            {
+                if (isUpdateEnabled())
+                    g_rxState = RxState_UpdatePacketSizeHiByte;
+                else
+                {
+                    g_rxCrc = CRC16_INITIAL_VALUE;
+                    g_rxState = RxState_InFrame;
+                }
+            }
+            else
+            {
+                if (g_rxOutOfFrameCallback != NULL)
+                    g_rxOutOfFrameCallback(data);
+                status = false;
+            }
+            break;
+        }
+        
+        case RxState_InFrame:
+        {
+            if (isEscapeCharacter(data))
+                g_rxState = RxState_EscapeCharacter;
+            else if (isEndFrameCharacter(data))
+            {
+                status = finalizeRxFrame();
+                g_rxState = RxState_OutOfFrame;
+            }
+            else
+                status = enqueueRxFrameByte(data);
+            break;
+        }
+        
+        case RxState_EscapeCharacter:
+        {
+            status = enqueueRxFrameByte(data);
+            g_rxState = RxState_InFrame;
+            break;
+        }
+        
+        case RxState_CobsStart:
+        case RxState_CobsCode:
+        {
+            if (data == ControlByte_CobsDelimiter)
+            {
+                // The delimiter ends the frame; empty frames are ignored.
+                if (g_rxState == RxState_CobsCode)
+                    status = finalizeRxFrame();
+                g_rxState = RxState_CobsStart;
+            }
+            else
+            {
+                // The blocks are separated by a zero byte unless the previous
+                // block has the maximum size.
+                if (g_rxState == RxState_CobsStart)
+                    g_rxCrc = CRC16_INITIAL_VALUE;
+                else if (g_rxCobsCode != COBS_MAX_CODE)
+                    status = enqueueRxFrameByte(0u);
+                g_rxCobsCode = data;
+                g_rxCobsSize = data - 1u;
+                g_rxState = (g_rxCobsSize > 0) ? (RxState_CobsData) : (RxState_CobsCode);
+            }
+            break;
+        }
+        
+        case RxState_CobsData:
+        {
+            if (data == ControlByte_CobsDelimiter)
+            {
+                // The frame was cut off; the delimiter starts the next frame.
+                queue_enqueueDiscard(&g_heap->decodedRxQueue);
+                g_rxState = RxState_CobsStart;
+                status = false;
+            }
+            else
+            {
+                status = enqueueRxFrameByte(data);
+                if (--g_rxCobsSize == 0)
+                    g_rxState = RxState_CobsCode;
+            }
+            break;
+        }
+        
+        case RxState_UpdatePacketSizeHiByte:
+        {
+            resetUpdateChunk();
+            g_updateFile.updateChunk->totalSize = (uint16_t)data << 8u;
+            g_rxState = RxState_UpdatePacketSizeLoByte;
+            break;
+        }
+        
+        case RxState_UpdatePacketSizeLoByte:
+        {
+            g_updateFile.updateChunk->totalSize += (uint16_t)data;
+            g_rxState = RxState_UpdatePacketData;
+            break;
+        }
+        
+        case RxState_UpdatePacketData:
+        {
+            RxUpdateByteStatus updateStatus = processRxUpdateByte(data);
+            switch (updateStatus)
+            {
+                case RxUpdateByteStatus_Success:
+                {
+                    break;
+                }
+                
+                case RxUpdateByteStatus_SubchunkComplete:
+                {
+                    break;
+                }
+                
+                case RxUpdateByteStatus_ChunkComplete:
+                {
+                    break;
+                }
+                
+                case RxUpdateByteStatus_FileComplete:
+                {
+                    break;
+                }
+                
+                case RxUpdateByteStatus_Error:
+                {
+                    // @TODO: do some error handling.
+                    break;
+                }
+                
+                default:
+                {
+                    // @TODO: do some error handling.
+                }
+            }
+            break;
+        }
+        
+        default:
+        {
+            // We should never get into this state, if we do, something
+            // wrong happened.  Potentially do some error handling.
+            
+            // Reset to the default state: out of frame.
+            g_rxState = RxState_OutOfFrame;
+            status = false;
+            break;
+        }
+    }
+    return status;
+}
+
+
+/// Discards the partial frame being received and resets the receive state
+/// machine to wait for the next start of frame.
+static void resyncRx(void)
+{
+    if ((g_rxState == RxState_InFrame) || (g_rxState == RxState_EscapeCharacter) ||
+        (g_rxState == RxState_CobsCode) || (g_rxState == RxState_CobsData))
     {
-        case RxState_OutOfFrame:
+        queue_enqueueDiscard(&g_heap->decodedRxQueue);
+        if (g_rxStats.resyncs < UINT16_MAX)
+            g_rxStats.resyncs++;
+    }
+    
+    // With COBS framing, the first byte after the idle time starts a frame.
+    g_rxState = (g_rxFraming == Framing_Cobs) ? (RxState_CobsStart) : (RxState_OutOfFrame);
+}
+
+
+/// Checks if the receive line was idle for the receive frame timeout since the
+/// last byte was received; if so, the partial frame being received is discarded
+/// (see resyncRx). Only applies to translate mode; update packets may pause for
+/// longer while the slave is busy. Only call from the receive ISR or with the
+/// UART interrupt disabled.
+/// @param[in]  currentTicks    The current timestamp (see
+///                             hwSystemTime_getTimestamp).
+static void checkRxTimeout(uint32_t currentTicks)
+{
+    uint32_t timeoutTicks = g_rxTimeoutTicks;
+    if (!g_rxIdle && (timeoutTicks > 0) && ((currentTicks - g_lastRxTicks) > timeoutTicks))
+    {
+        g_rxIdle = true;
+        if ((g_heap != NULL) && !isUpdateEnabled())
         {
-            if (data == ControlByte_StartFrame)
-            {                        
-                resetRxTime();
-                if (isUpdateEnabled())
-                    g_rxState = RxState_UpdatePacketSizeHiByte;
+        #if ENABLE_UART_RX_DEFERRED_PARSING
+            // The bytes before the idle time may not be parsed yet; the main
+            // loop resynchronizes once it parses up to this position. If a
+            // resynchronization is already pending, it's kept.
+            if (!g_rxResyncPending)
+            {
+                g_rxResyncPosition = byteQueue_getTail(&g_heap->rawRxQueue);
+                g_rxResyncPending = true;
+            }
+        #else
+            resyncRx();
+        #endif // ENABLE_UART_RX_DEFERRED_PARSING
+        }
+    }
+}
+
+
+#if ENABLE_UART_RTS
+    
+    /// Deasserts RTS while the receive queue filled by the receive ISR (the raw
+    /// receive queue with deferred parsing; otherwise, the decoded receive
+    /// queue) is nearly full and asserts it again once it has room (see
+    /// UART_RTS_FREE_THRESHOLD). RTS stays asserted in update mode. Only call
+    /// from the receive ISR or with the UART interrupt disabled.
+    static void updateRts(void)
+    {
+        bool ready = true;
+        if ((g_heap != NULL) && !isUpdateEnabled())
+        {
+        #if ENABLE_UART_RX_DEFERRED_PARSING
+            uint16_t freeSize = byteQueue_getFreeSize(&g_heap->rawRxQueue);
+        #else
+            uint16_t freeSize = queue_getFreeDataSize(&g_heap->decodedRxQueue);
+            uint16_t pendingSize = g_heap->decodedRxQueue.pendingEnqueueSize;
+            freeSize = (freeSize > pendingSize) ? (freeSize - pendingSize) : (0u);
+        #endif // ENABLE_UART_RX_DEFERRED_PARSING
+            uint16_t threshold = (g_rtsAsserted) ? (UART_RTS_FREE_THRESHOLD) : (UART_RTS_FREE_THRESHOLD << 1);
+            ready = (freeSize >= threshold);
+        }
+        
+        if (ready != g_rtsAsserted)
+        {
+            // RTS is active low.
+            COMPONENT(HOST_UART_RTS, Write)((ready) ? (0u) : (1u));
+            g_rtsAsserted = ready;
+        }
+    }
+    
+    
+    /// Updates RTS from the main loop once the receive queues were processed
+    /// (see updateRts).
+    static void pollRts(void)
+    {
+        COMPONENT(HOST_UART, DisableInt)();
+        updateRts();
+        COMPONENT(HOST_UART, EnableInt)();
+    }
+    
+#endif // ENABLE_UART_RTS
+
+
+/// Stores a byte read from the receive FIFO. In translate mode with deferred
+/// parsing, the byte is added to the raw receive queue to be parsed by the
+/// main loop; otherwise, the byte is processed through the receive state
+/// machine.
+/// @param[in]  data    The byte read from the receive FIFO.
+static void storeRxByte(uint8_t data)
+{
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    if (isUpdateEnabled())
+        processRxByte(data);
+    else if (g_rawRxOverflowed || !byteQueue_enqueueByte(&g_heap->rawRxQueue, data))
+    {
+        g_rawRxOverflowed = true;
+        if (g_rxStats.rawOverflows < UINT16_MAX)
+            g_rxStats.rawOverflows++;
+    }
+#else
+    processRxByte(data);
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+}
+
+
+/// Reads all the bytes in the receive FIFO (including bytes that arrive while
+/// reading) and stores them (see storeRxByte). Only call from the receive ISR
+/// or with the UART interrupt disabled.
+/// @return The number of bytes read.
+static uint16_t readRxFifo(void)
+{
+    uint16_t count = 0;
+    uint32_t currentTicks = hwSystemTime_getTimestamp();
+    uint32_t size = COMPONENT(HOST_UART, SpiUartGetRxBufferSize)();
+    
+    // With the receive FIFO level trigger, the bytes below the trigger level
+    // may wait in the receive FIFO so only an empty receive FIFO shows that
+    // the receive line is idle. Otherwise, the ISR fires as soon as the first
+    // byte arrives.
+#if ENABLE_UART_RX_FIFO_TRIGGER
+    if (size == 0)
+        checkRxTimeout(currentTicks);
+#else
+    checkRxTimeout(currentTicks);
+#endif // ENABLE_UART_RX_FIFO_TRIGGER
+    
+    while (size > 0)
+    {
+        count += size;
+        for (; size > 0; --size)
+        {
+            uint8_t data = (uint8_t)COMPONENT(HOST_UART, SpiUartReadRxData)();
+            if (g_heap != NULL)
+                storeRxByte(data);
+        }
+        size = COMPONENT(HOST_UART, SpiUartGetRxBufferSize)();
+    }
+    
+    if (count > 0)
+    {
+        g_rxStats.byteCount += count;
+        resetRxTime();
+    #if ENABLE_UART_RTS
+        updateRts();
+    #endif // ENABLE_UART_RTS
+    }
+    return count;
+}
+
+
+/// Reads the bytes left in the receive FIFO below the receive FIFO level
+/// trigger from the main loop. The UART interrupt is disabled while reading
+/// because the ISR is the only producer of the receive queues.
+static void pollRxFifo(void)
+{
+#if ENABLE_UART_RX_FIFO_TRIGGER
+    // An empty receive FIFO is read as well to check the receive frame
+    // timeout.
+    COMPONENT(HOST_UART, DisableInt)();
+    readRxFifo();
+    COMPONENT(HOST_UART, EnableInt)();
+#endif // ENABLE_UART_RX_FIFO_TRIGGER
+}
+
+
+/// Dequeues the transmit queue element being sent once all its bytes have been
+/// read from the transmit stream.
+/// @param[in]  stream  The transmit stream.
+static void releaseTxStream(TxStream* stream)
+{
+#if ENABLE_UART_TX_LAZY_ENCODING
+    // The frames after the BridgeCommand_Crc and BridgeCommand_Framing
+    // responses use the new setting.
+    if (stream->command == BridgeCommand_Crc)
+        g_txCrcEnabled = g_txCrcRequested;
+    else if (stream->command == BridgeCommand_Framing)
+        g_txFraming = g_txFramingRequested;
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+    
+    uint8_t* element;
+    queue_dequeue(&g_heap->txQueue, &element);
+    stream->data = NULL;
+    stream->size = 0;
+    stream->state = TxState_Idle;
+    stream->sentCount++;
+}
+
+
+/// Starts sending the transmit queue element at the head of the transmit
+/// queue.
+/// @param[in]  stream  The transmit stream.
+/// @return If there's a transmit queue element to send.
+static bool loadTxStream(TxStream* stream)
+{
+    uint8_t* data;
+    uint16_t size = queue_peak(&g_heap->txQueue, &data);
+    if (size > 0)
+    {
+    #if ENABLE_UART_TX_LAZY_ENCODING
+        stream->command = data[0];
+        stream->data = &data[1];
+        stream->size = size - 1u;
+        stream->state = (stream->command == G_TxUnframedCommand) ? (TxState_Unframed) : (TxState_StartFrame);
+        stream->crcEnabled = g_txCrcEnabled;
+        stream->crc = CRC16_INITIAL_VALUE;
+        
+        // With COBS framing, the command is the first byte of the frame.
+        if ((stream->state == TxState_StartFrame) && (g_txFraming == Framing_Cobs))
+        {
+            stream->data = data;
+            stream->size = size;
+            stream->cobsTrailer = false;
+            stream->state = TxState_CobsCode;
+        }
+    #else
+        // The transmit queue elements are already encoded.
+        stream->command = BridgeCommand_None;
+        stream->data = data;
+        stream->size = size;
+        stream->state = TxState_Unframed;
+    #endif // ENABLE_UART_TX_LAZY_ENCODING
+    }
+    return (size > 0);
+}
+
+
+#if ENABLE_UART_TX_LAZY_ENCODING
+    
+    /// COBS framing: finds the next block of the frame being sent, the non-zero
+    /// bytes before the next zero byte (at most COBS_MAX_CODE - 1 bytes), and
+    /// sets its code. The scanned bytes are added to the CRC-16 (each byte is
+    /// scanned once); the CRC-16 trailer is set once the end of the transmit
+    /// queue element is scanned so the block can continue into the trailer.
+    /// @param[in]  stream  The transmit stream.
+    static void scanCobsBlock(TxStream* stream)
+    {
+        uint8_t const* data = stream->data;
+        uint16_t size = stream->size;
+        bool trailer = stream->cobsTrailer;
+        uint16_t blockSize = 0;
+        bool scan = true;
+        while (scan)
+        {
+            uint16_t scanSize = COBS_MAX_CODE - 1u - blockSize;
+            if (scanSize > size)
+                scanSize = size;
+            uint8_t const* zero = memchr(data, ControlByte_CobsDelimiter, scanSize);
+            uint16_t runSize = (zero != NULL) ? (uint16_t)(zero - data) : (scanSize);
+            blockSize += runSize;
+            scan = false;
+            if (!trailer && stream->crcEnabled)
+            {
+                // The zero byte that ends the block is part of the CRC-16.
+                uint16_t crcSize = runSize + ((zero != NULL) ? (1u) : (0u));
+                stream->crc = crc16_update(stream->crc, data, crcSize);
+                if (crcSize == size)
+                {
+                    stream->crcTrailer[0] = HI_BYTE_16_BIT(stream->crc);
+                    stream->crcTrailer[1] = LO_BYTE_16_BIT(stream->crc);
+                    if ((zero == NULL) && (blockSize < (COBS_MAX_CODE - 1u)))
+                    {
+                        data = stream->crcTrailer;
+                        size = FRAME_CRC_SIZE;
+                        trailer = true;
+                        scan = true;
+                    }
+                }
+            }
+        }
+        stream->cobsCode = (uint8_t)(blockSize + 1u);
+        stream->cobsSize = (uint8_t)blockSize;
+    }
+    
+    
+    /// COBS framing: continues with the CRC-16 trailer (if it's enabled) once
+    /// the transmit queue element is written.
+    /// @param[in]  stream  The transmit stream.
+    static void advanceCobsStream(TxStream* stream)
+    {
+        if ((stream->size == 0) && stream->crcEnabled && !stream->cobsTrailer)
+        {
+            stream->data = stream->crcTrailer;
+            stream->size = FRAME_CRC_SIZE;
+            stream->cobsTrailer = true;
+        }
+    }
+    
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+
+
+/// Reads the next bytes to write to the UART from the transmit queue. The data
+/// of the transmit queue elements is read in place and framed and escaped on
+/// the fly (see ENABLE_UART_TX_LAZY_ENCODING). Only call from one context at a
+/// time: the ISR or with the UART interrupt disabled when the interrupt-driven
+/// transmitter is used, otherwise the main loop.
+/// @param[out] target      The buffer to read the bytes into.
+/// @param[in]  targetSize  The number of bytes available in the target.
+/// @return The number of bytes read; less than targetSize if the transmit
+///         queue is empty.
+static uint16_t readTxStream(uint8_t target[], uint16_t targetSize)
+{
+    // Only one context accesses the stream at a time so work on it directly.
+    TxStream* stream = (TxStream*)&g_txStream;
+    uint16_t t = 0;
+    while (t < targetSize)
+    {
+        if (stream->state == TxState_Idle)
+        {
+            // The stream is held between elements while the baud rate
+            // switches.
+            if (stream->hold && (stream->sentCount == stream->holdCount))
+                break;
+            if (!loadTxStream(stream))
+                break;
+        }
+        
+        switch (stream->state)
+        {
+            case TxState_StartFrame:
+            {
+                target[t++] = ControlByte_StartFrame;
+                stream->state = (stream->command != BridgeCommand_None) ? (TxState_CommandEscape) : (TxState_Payload);
+                break;
+            }
+            
+            case TxState_CommandEscape:
+            {
+                target[t++] = ControlByte_Escape;
+                stream->state = TxState_CommandEscapeData;
+                break;
+            }
+            
+            case TxState_CommandEscapeData:
+            {
+                target[t++] = ControlByte_Escape;
+                stream->state = TxState_Command;
+                break;
+            }
+            
+            case TxState_Command:
+            {
+                target[t++] = stream->command;
+                if (stream->crcEnabled)
+                    stream->crc = crc16_updateByte(stream->crc, stream->command);
+                stream->state = TxState_Payload;
+                break;
+            }
+            
+            case TxState_Payload:
+            case TxState_Crc:
+            {
+                // Copy the run of bytes that don't require an escape
+                // character; if the run is empty, the next byte needs one.
+                // The payload is added to the CRC-16 as it's copied.
+                bool payload = (stream->state == TxState_Payload);
+                uint16_t size = stream->size;
+                if (size == 0)
+                {
+                    if (payload && stream->crcEnabled)
+                    {
+                        stream->crcTrailer[0] = HI_BYTE_16_BIT(stream->crc);
+                        stream->crcTrailer[1] = LO_BYTE_16_BIT(stream->crc);
+                        stream->data = stream->crcTrailer;
+                        stream->size = FRAME_CRC_SIZE;
+                        stream->state = TxState_Crc;
+                    }
+                    else
+                        stream->state = TxState_EndFrame;
+                }
                 else
-                    g_rxState = RxState_InFrame;
+                {
+                    if (size > (targetSize - t))
+                        size = targetSize - t;
+                    uint16_t runSize = findEscapeOffset(stream->data, size);
+                    if (runSize > 0)
+                    {
+                        if (payload && stream->crcEnabled)
+                            stream->crc = crc16_update(stream->crc, stream->data, runSize);
+                        memcpy(&target[t], stream->data, runSize);
+                        t += runSize;
+                        stream->data += runSize;
+                        stream->size -= runSize;
+                    }
+                    else
+                    {
+                        target[t++] = ControlByte_Escape;
+                        stream->state = (payload) ? (TxState_PayloadEscapeData) : (TxState_CrcEscapeData);
+                    }
+                }
+                break;
             }
-            else
+            
+            case TxState_PayloadEscapeData:
+            {
+                if (stream->crcEnabled)
+                    stream->crc = crc16_updateByte(stream->crc, *stream->data);
+                target[t++] = *stream->data++;
+                stream->size--;
+                stream->state = TxState_Payload;
+                break;
+            }
+            
+            case TxState_CrcEscapeData:
+            {
+                target[t++] = *stream->data++;
+                stream->size--;
+                stream->state = TxState_Crc;
+                break;
+            }
+            
+            case TxState_EndFrame:
+            {
+                target[t++] = ControlByte_EndFrame;
+                releaseTxStream(stream);
+                break;
+            }
+        
+        #if ENABLE_UART_TX_LAZY_ENCODING
+            case TxState_CobsCode:
+            {
+                scanCobsBlock(stream);
+                target[t++] = stream->cobsCode;
+                stream->state = TxState_CobsData;
+                break;
+            }
+            
+            case TxState_CobsData:
+            {
+                // After the data bytes of the block, skip the zero byte that
+                // the next code byte replaces; the block that ends the frame
+                // isn't followed by a zero byte.
+                uint16_t size = stream->cobsSize;
+                if (size > 0)
+                {
+                    if (size > stream->size)
+                        size = stream->size;
+                    if (size > (targetSize - t))
+                        size = targetSize - t;
+                    memcpy(&target[t], stream->data, size);
+                    t += size;
+                    stream->data += size;
+                    stream->size -= size;
+                    stream->cobsSize -= size;
+                }
+                else if (stream->cobsCode == COBS_MAX_CODE)
+                    stream->state = TxState_CobsCode;
+                else if (stream->size > 0)
+                {
+                    stream->data++;
+                    stream->size--;
+                    stream->state = TxState_CobsCode;
+                }
+                else
+                    stream->state = TxState_CobsDelimiter;
+                advanceCobsStream(stream);
+                break;
+            }
+            
+            case TxState_CobsDelimiter:
             {
-                if (g_rxOutOfFrameCallback != NULL)
-                    g_rxOutOfFrameCallback(data);
-                status = false;
+                target[t++] = ControlByte_CobsDelimiter;
+                releaseTxStream(stream);
+                break;
             }
-            break;
-        }
-        
-        case RxState_InFrame:
-        {
-            if (isEscapeCharacter(data))
-                g_rxState = RxState_EscapeCharacter;
-            else if (isEndFrameCharacter(data))
+        #endif // ENABLE_UART_TX_LAZY_ENCODING
+            
+            case TxState_Unframed:
             {
-                status = queue_enqueueFinalize(&g_heap->decodedRxQueue);
-                g_rxState = RxState_OutOfFrame;
+                uint16_t size = stream->size;
+                if (size > (targetSize - t))
+                    size = targetSize - t;
+                memcpy(&target[t], stream->data, size);
+                t += size;
+                stream->data += size;
+                stream->size -= size;
+                if (stream->size == 0)
+                    releaseTxStream(stream);
+                break;
             }
-            else
+            
+            default:
             {
-                status = queue_enqueueByte(&g_heap->decodedRxQueue, data, false);
-                if (!status)
-                    handleRxFrameOverflow(data);
+                // We should never get into this state; drop the element.
+                releaseTxStream(stream);
+                break;
             }
-            break;
-        }
-        
-        case RxState_EscapeCharacter:
-        {
-            status = queue_enqueueByte(&g_heap->decodedRxQueue, data, false);
-            if (!status)
-                handleRxFrameOverflow(data);
-            g_rxState = RxState_InFrame;
-            break;
         }
-        
-        case RxState_UpdatePacketSizeHiByte:
+    }
+    return t;
+}
+
+
+#if ENABLE_UART_TX_INTERRUPT
+    
+    /// Writes the transmit stream to the transmit FIFO until the transmit FIFO
+    /// is full. Once the transmit queue is empty, the transmit interrupt is
+    /// disabled until startTx is called. Only call from the ISR or with the
+    /// UART interrupt disabled.
+    static void writeTxFifo(void)
+    {
+        bool idle = true;
+        if (uartTranslate_isActivated())
         {
-            resetUpdateChunk();
-            g_updateFile.updateChunk->totalSize = (uint16_t)data << 8u;
-            g_rxState = RxState_UpdatePacketSizeLoByte;
-            break;
+            uint8_t buffer[COMPONENT(HOST_UART, SPI_UART_FIFO_SIZE)];
+            uint16_t space = COMPONENT(HOST_UART, SPI_UART_FIFO_SIZE) - COMPONENT(HOST_UART, SpiUartGetTxBufferSize)();
+            uint16_t size = readTxStream(buffer, space);
+            for (uint16_t i = 0; i < size; ++i)
+                COMPONENT(HOST_UART, SpiUartWriteTxData)(buffer[i]);
+            idle = (size < space);
         }
         
-        case RxState_UpdatePacketSizeLoByte:
+        if (idle)
+            COMPONENT(HOST_UART, SetTxInterruptMode)(0u);
+        COMPONENT(HOST_UART, ClearTxInterruptSource)(COMPONENT(HOST_UART, INTR_TX_TRIGGER));
+    }
+    
+    
+    /// Starts the interrupt-driven transmitter if there is data in the
+    /// transmit queue. The transmit interrupt fires immediately if the
+    /// transmit FIFO is below the trigger level. The ISR disables the transmit
+    /// interrupt once the transmit queue is empty; because the ISR can't
+    /// interrupt itself, the transmitter can't be stopped between the check of
+    /// the transmit queue and the start.
+    static void startTx(void)
+    {
+        if (!queue_isEmpty(&g_heap->txQueue))
+            COMPONENT(HOST_UART, SetTxInterruptMode)(COMPONENT(HOST_UART, INTR_TX_TRIGGER));
+    }
+    
+#endif // ENABLE_UART_TX_INTERRUPT
+
+
+/// Stops the transmitter; the transmit queue element being sent is abandoned.
+static void stopTx(void)
+{
+#if ENABLE_UART_TX_INTERRUPT
+    COMPONENT(HOST_UART, DisableInt)();
+    COMPONENT(HOST_UART, SetTxInterruptMode)(0u);
+#endif // ENABLE_UART_TX_INTERRUPT
+    
+    g_txStream.data = NULL;
+    g_txStream.size = 0;
+    g_txStream.state = TxState_Idle;
+
+#if ENABLE_UART_TX_INTERRUPT
+    COMPONENT(HOST_UART, EnableInt)();
+#endif // ENABLE_UART_TX_INTERRUPT
+}
+
+
+/// Writes a string to the UART. When the interrupt-driven transmitter is
+/// running in translate mode, the string is added to the transmit queue as is
+/// (no framing) so it isn't written in the middle of a frame being sent and
+/// the main loop doesn't wait on the transmit FIFO; otherwise, the string is
+/// written directly.
+/// @param[in]  string  The null-terminated string to write.
+static void writeString(char const string[])
+{
+#if ENABLE_UART_TX_INTERRUPT
+    bool direct = !uartTranslate_isActivated();
+    if (!direct)
+    {
+    #if ENABLE_UART_TX_LAZY_ENCODING
+        txEnqueueElement(G_TxUnframedCommand, (uint8_t const*)string, strlen(string));
+    #else
+        queue_enqueue(&g_heap->txQueue, (uint8_t const*)string, strlen(string));
+    #endif // ENABLE_UART_TX_LAZY_ENCODING
+        startTx();
+    }
+#else
+    bool direct = true;
+#endif // ENABLE_UART_TX_INTERRUPT
+    
+    if (direct)
+        COMPONENT(HOST_UART, UartPutString)(string);
+}
+
+
+/// Processes the baud rate switch: switches once the switch response has been
+/// sent and rolls back if the host doesn't commit the new baud rate in time.
+/// Only call from the main loop.
+static void processBaudSwitch(void)
+{
+    if (g_baud.state == BaudState_SwitchPending)
+    {
+        // The transmit stream is held after the switch response; wait until
+        // the response has left the transmit FIFO and then for the last
+        // character to leave the shift register.
+        if ((g_txStream.state == TxState_Idle) && (g_txStream.sentCount == g_txStream.holdCount) &&
+            (COMPONENT(HOST_UART, SpiUartGetTxBufferSize)() == 0))
         {
-            g_updateFile.updateChunk->totalSize += (uint16_t)data;
-            g_rxState = RxState_UpdatePacketData;
-            break;
+            CyDelayUs((uint16_t)(((uint32_t)G_UartCharacterBits * 1000000u) / calculateBaudRate(g_baud.divider)) + 1u);
+            g_baud.previousDivider = g_baud.divider;
+            applyClockDivider(g_baud.pendingDivider);
+            alarm_arm(&g_baud.commitAlarm, G_BaudCommitTimeoutMs, AlarmType_SingleNotification);
+            g_baud.state = BaudState_CommitPending;
+            g_txStream.hold = false;
+        #if ENABLE_UART_TX_INTERRUPT
+            startTx();
+        #endif // ENABLE_UART_TX_INTERRUPT
         }
-        
-        case RxState_UpdatePacketData:
+    }
+    else if ((g_baud.state == BaudState_CommitPending) && alarm_hasElapsed(&g_baud.commitAlarm))
+    {
+        applyClockDivider(g_baud.previousDivider);
+        g_baud.state = BaudState_Idle;
+    }
+}
+
+
+/// Cancels a baud rate switch in progress; if the bridge already switched,
+/// it rolls back to the previous baud rate.
+static void cancelBaudSwitch(void)
+{
+    if (g_baud.state == BaudState_CommitPending)
+        applyClockDivider(g_baud.previousDivider);
+    alarm_disarm(&g_baud.commitAlarm);
+    g_baud.state = BaudState_Idle;
+    g_txStream.hold = false;
+}
+
+
+#if ENABLE_UART_AUTO_BAUD
+    
+    /// Auto-baud detection: if there were G_AutoBaudErrorThreshold receive
+    /// frame errors without a valid frame in between, the host is most likely
+    /// sending at a different baud rate so switch to the next baud rate in
+    /// G_AutoBaudRates. The host keeps sending frames (starting with the 0xaa
+    /// start frame byte) until it gets a response. Only call from the main
+    /// loop.
+    static void processAutoBaud(void)
+    {
+        uint16_t frameErrors = g_rxStats.frameErrors;
+        uint16_t frameCount = g_rxFrameCount;
+        if (frameCount != g_baud.frameCount)
+            g_baud.errorCount = 0;
+        else if (g_baud.state == BaudState_Idle)
         {
-            RxUpdateByteStatus updateStatus = processRxUpdateByte(data);
-            switch (updateStatus)
+            // The receive statistics may have been reset.
+            uint16_t errors = (frameErrors >= g_baud.frameErrors) ? (frameErrors - g_baud.frameErrors) : (frameErrors);
+            if (errors >= (G_AutoBaudErrorThreshold - g_baud.errorCount))
             {
-                case RxUpdateByteStatus_Success:
-                {
-                    break;
-                }
-                
-                case RxUpdateByteStatus_SubchunkComplete:
-                {
-                    break;
-                }
-                
-                case RxUpdateByteStatus_ChunkComplete:
-                {
-                    break;
-                }
-                
-                case RxUpdateByteStatus_FileComplete:
-                {
-                    break;
-                }
-                
-                case RxUpdateByteStatus_Error:
-                {
-                    // @TODO: do some error handling.
-                    break;
-                }
-                
-                default:
+                uint8_t const count = sizeof(G_AutoBaudRates) / sizeof(G_AutoBaudRates[0]);
+                uint32_t divider = 0;
+                for (uint8_t i = 0; (divider == 0) && (i < count); ++i)
                 {
-                    // @TODO: do some error handling.
+                    g_baud.autoBaudIndex = ((g_baud.autoBaudIndex + 1u) < count) ? (g_baud.autoBaudIndex + 1u) : (0);
+                    divider = calculateClockDivider(G_AutoBaudRates[g_baud.autoBaudIndex]);
                 }
+                if (divider > 0)
+                    applyClockDivider(divider);
+                g_baud.errorCount = 0;
             }
-            break;
-        }
-        
-        default:
-        {
-            // We should never get into this state, if we do, something
-            // wrong happened.  Potentially do some error handling.
-            
-            // Reset to the default state: out of frame.
-            g_rxState = RxState_OutOfFrame;
-            status = false;
-            break;
+            else
+                g_baud.errorCount += errors;
         }
+        g_baud.frameErrors = frameErrors;
+        g_baud.frameCount = frameCount;
     }
-    return status;
-}
+    
+#endif // ENABLE_UART_AUTO_BAUD
 
 
 /// Update finite state machine (FSM) to process any received decoded packets
@@ -1440,13 +4663,13 @@ static UpdateStatus processUpdateFsm(uint32_t timeoutMs)
         alarm_arm(alarm, timeoutMs, AlarmType_ContinuousNotification);
     else
         alarm_disarm(alarm);
-        
+    
     if (*state == UpdateState_Waiting)
     {
         // @TODO: add some logic here to determine what should be the next state
         // when in the waiting state.
     }
-        
+    
     while (*state != UpdateState_Waiting)
     {
         if (alarm->armed && alarm_hasElapsed(alarm))
@@ -1455,45 +4678,233 @@ static UpdateStatus processUpdateFsm(uint32_t timeoutMs)
             break;
         }
     }
-        
+    
     return status;
 }
 
 
 /// Processes the receive buffer with the intent of parsing out valid frames of
-/// data.
+/// data. The bytes between control characters (start/end frame and escape) are
+/// added to the decoded receive queue as a block instead of byte-by-byte.
+/// Processing stops after the end of a frame if the decoded receive queue is
+/// full so the remaining bytes can be processed once a decoded packet has been
+/// dequeued.
 /// @param[in]  source          The buffer to process and parse to find full
 ///                             valid frames of data.
 /// @param[in]  sourceSize      The size of the source buffer in bytes.
-/// @param[in]  sourceOffset    The offset to start parsing.
 /// @return The number of bytes that were processed.
-static uint16_t __attribute__((unused)) processReceivedData(uint8_t const source[], uint16_t sourceSize, uint16_t sourceOffset)
+static uint16_t processReceivedData(uint8_t const source[], uint16_t sourceSize)
 {
-    // Track the number of bytes that was processed.
-    uint32_t size = 0;
-    
-    if (g_heap != NULL)
+    uint16_t offset = 0;
+    while (offset < sourceSize)
     {
-        // Iterate through all the received bytes via UART.
-        for (uint32_t i = sourceOffset; i < sourceSize; ++i)
+        if (g_rxState == RxState_InFrame)
+        {
+            uint16_t runSize = findEscapeOffset(&source[offset], sourceSize - offset);
+            if (runSize > 0)
+            {
+                // If the run doesn't fit, process it byte-by-byte so every
+                // byte that overflows is reported.
+                if (queue_enqueueBytes(&g_heap->decodedRxQueue, &source[offset], runSize, false))
+                {
+                    if (g_rxCrcEnabled)
+                        g_rxCrc = crc16_update(g_rxCrc, &source[offset], runSize);
+                }
+                else
+                {
+                    for (uint16_t i = 0; i < runSize; ++i)
+                        processRxByte(source[offset + i]);
+                }
+                offset += runSize;
+                continue;
+            }
+        }
+        else if (g_rxState == RxState_CobsData)
         {
-            uint8_t data = source[i];
-            if (processRxByte(data))
-                ++size;
+            // Add the rest of the block as a block; a zero byte (the block
+            // was cut off) is processed byte-by-byte.
+            uint16_t size = sourceSize - offset;
+            if (size > g_rxCobsSize)
+                size = g_rxCobsSize;
+            uint8_t const* zero = memchr(&source[offset], ControlByte_CobsDelimiter, size);
+            uint16_t runSize = (zero != NULL) ? (uint16_t)(zero - &source[offset]) : (size);
+            if (runSize > 0)
+            {
+                if (queue_enqueueBytes(&g_heap->decodedRxQueue, &source[offset], runSize, false))
+                {
+                    if (g_rxCrcEnabled)
+                        g_rxCrc = crc16_update(g_rxCrc, &source[offset], runSize);
+                    g_rxCobsSize -= runSize;
+                    if (g_rxCobsSize == 0)
+                        g_rxState = RxState_CobsCode;
+                }
+                else
+                {
+                    for (uint16_t i = 0; i < runSize; ++i)
+                        processRxByte(source[offset + i]);
+                }
+                offset += runSize;
+                continue;
+            }
         }
+        
+        processRxByte(source[offset++]);
+        if (queue_isFull(&g_heap->decodedRxQueue))
+            break;
     }
-    return size;
+    return offset;
 }
 
 
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    
+    /// Parses the bytes in the raw receive queue into the decoded receive queue.
+    /// The bytes that can't be parsed because the decoded receive queue is full
+    /// stay in the raw receive queue.
+    static void processRawRxQueue(void)
+    {
+        bool overflowed = g_rawRxOverflowed;
+        while (!queue_isFull(&g_heap->decodedRxQueue))
+        {
+            // Only parse up to where the receive line was idle (see
+            // checkRxTimeout). The flag is read after the span so a position
+            // set in the meantime is always past the span.
+            uint8_t const* data;
+            uint16_t size = byteQueue_peakSpan(&g_heap->rawRxQueue, &data);
+            if (g_rxResyncPending)
+            {
+                uint16_t offset = byteQueue_getOffset(&g_heap->rawRxQueue, g_rxResyncPosition);
+                if (offset == 0)
+                {
+                    resyncRx();
+                    g_rxResyncPending = false;
+                    continue;
+                }
+                if (size > offset)
+                    size = offset;
+            }
+            if (size == 0)
+                break;
+            
+            uint16_t processedSize = processReceivedData(data, size);
+            byteQueue_dequeueSpan(&g_heap->rawRxQueue, processedSize);
+            if (processedSize < size)
+                break;
+        }
+        
+        // Once the bytes received before the overflow are parsed, drop the
+        // frame that was cut off and wait for the next start of frame.
+        if (overflowed && byteQueue_isEmpty(&g_heap->rawRxQueue))
+        {
+            queue_enqueueDiscard(&g_heap->decodedRxQueue);
+            g_rxState = RxState_OutOfFrame;
+            g_rawRxOverflowed = false;
+        }
+    }
+    
+    
+    /// Initializes the raw receive queue when in translate/normal mode.
+    /// @param[in]  heap    Pointer to the specific translate heap data structure
+    ///                     that defines the address offset for the heap data,
+    ///                     specifically the queue data.
+    static void initTranslateRawRxQueue(TranslateHeap* heap)
+    {
+        g_heap->rawRxQueue.data = heap->heapData.rawRxQueueData;
+        g_heap->rawRxQueue.maxSize = TRANSLATE_RAW_RX_QUEUE_SIZE;
+        byteQueue_empty(&g_heap->rawRxQueue);
+        g_rawRxOverflowed = false;
+    }
+    
+    
+    /// Disables the raw receive queue when in update mode.
+    static void disableRawRxQueue(void)
+    {
+        g_heap->rawRxQueue.data = NULL;
+        g_heap->rawRxQueue.maxSize = 0;
+        byteQueue_empty(&g_heap->rawRxQueue);
+    }
+    
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+
+
 /// Initializes the basic receive variables
 static void initRx(void)
 {
     g_rxState = RxState_OutOfFrame;
+    g_batch.paused = false;
+    g_batch.executing = false;
+    alarm_disarm(&g_batch.stallAlarm);
+#if ENABLE_UART_RX_DEFERRED_PARSING
+    g_rxResyncPending = false;
+#endif // ENABLE_UART_RX_DEFERRED_PARSING
+#if ENABLE_UART_RTS
+    COMPONENT(HOST_UART_RTS, Write)(0u);
+    g_rtsAsserted = true;
+#endif // ENABLE_UART_RTS
     resetRxTime();
 }
 
 
+/// Disables the CRC-16 frame trailer; the host must enable it again after
+/// every activation (see BridgeCommand_Crc).
+static void initCrc(void)
+{
+    g_rxCrcEnabled = false;
+    g_txCrcEnabled = false;
+#if ENABLE_UART_TX_LAZY_ENCODING
+    g_txCrcRequested = false;
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+}
+
+
+/// Selects the escape framing; the host must select the COBS framing again
+/// after every activation (see BridgeCommand_Framing).
+static void initFraming(void)
+{
+    g_rxFraming = Framing_Escape;
+    g_txFraming = Framing_Escape;
+#if ENABLE_UART_TX_LAZY_ENCODING
+    g_txFramingRequested = Framing_Escape;
+#endif // ENABLE_UART_TX_LAZY_ENCODING
+}
+
+
+/// Disables the sequence IDs; the host must enable them again after every
+/// activation (see BridgeCommand_Sequence).
+static void initSequence(void)
+{
+    g_sequenceEnabled = false;
+    g_txSequenceId = G_UnsolicitedSequenceId;
+}
+
+
+#if ENABLE_UART_TX_DELTA_REPORTS
+    
+    /// Disables the delta mode; the host must enable it again after every
+    /// activation (see BridgeCommand_Delta).
+    /// @param[in]  references  The reference reports; NULL in update mode.
+    static void initDelta(DeltaReference* references)
+    {
+        g_delta.references = references;
+        g_delta.keyframeInterval = UART_DELTA_KEYFRAME_INTERVAL;
+        g_delta.enabled = false;
+        resetDeltaReferences();
+    }
+    
+#endif // ENABLE_UART_TX_DELTA_REPORTS
+
+
+/// Disables the credit frames and restarts the count of the frames received;
+/// the host must enable them again after every activation (see
+/// BridgeCommand_Credit).
+static void initCredit(void)
+{
+    g_rxCreditFrameCount = 0u;
+    g_creditReportEnabled = false;
+    g_creditReportPending = false;
+}
+
+
 /// Initializes the decoded receive queue when in translate/normal mode.
 /// @param[in]  heap    Pointer to the specific translate heap data structure
 ///                     that defines the address offset for the heap data,
@@ -1506,6 +4917,7 @@ static void initTranslateDecodedRxQueue(TranslateHeap* heap)
     g_heap->decodedRxQueue.maxDataSize = TRANSLATE_RX_QUEUE_DATA_SIZE;
     g_heap->decodedRxQueue.maxSize = TRANSLATE_RX_QUEUE_MAX_SIZE;
     queue_empty(&g_heap->decodedRxQueue);
+    queue_resetStats(&g_heap->decodedRxQueue);
     resetRxTime();
 }
 
@@ -1516,13 +4928,13 @@ static void initTranslateDecodedRxQueue(TranslateHeap* heap)
 ///                     specifically the queue data.
 static void initTranslateTxQueue(TranslateHeap* heap)
 {
-    queue_registerEnqueueCallback(&g_heap->txQueue, encodeData);
+    queue_deregisterEnqueueCallback(&g_heap->txQueue);
     g_heap->txQueue.data = heap->heapData.txQueueData;
     g_heap->txQueue.elements = heap->heapData.txQueueElements;
     g_heap->txQueue.maxDataSize = TRANSLATE_TX_QUEUE_DATA_SIZE;
     g_heap->txQueue.maxSize = TRANSLATE_TX_QUEUE_MAX_SIZE;
     queue_empty(&g_heap->txQueue);
-    resetPendingTxEnqueue();
+    queue_resetStats(&g_heap->txQueue);
 }
 
 
@@ -1538,6 +4950,7 @@ static void initUpdateDecodedRxQueue(UpdateHeap* heap)
     g_heap->decodedRxQueue.maxDataSize = UPDATE_RX_QUEUE_DATA_SIZE;
     g_heap->decodedRxQueue.maxSize = UPDATE_RX_QUEUE_MAX_SIZE;
     queue_empty(&g_heap->decodedRxQueue);
+    queue_resetStats(&g_heap->decodedRxQueue);
     resetRxTime();
 }
 
@@ -1548,13 +4961,13 @@ static void initUpdateDecodedRxQueue(UpdateHeap* heap)
 ///                     specifically the queue data.
 static void initUpdateTxQueue(UpdateHeap* heap)
 {
-    queue_registerEnqueueCallback(&g_heap->txQueue, encodeData);
+    queue_deregisterEnqueueCallback(&g_heap->txQueue);
     g_heap->txQueue.data = heap->heapData.txQueueData;
     g_heap->txQueue.elements = heap->heapData.txQueueElements;
     g_heap->txQueue.maxDataSize = UPDATE_TX_QUEUE_DATA_SIZE;
     g_heap->txQueue.maxSize = UPDATE_TX_QUEUE_MAX_SIZE;
     queue_empty(&g_heap->txQueue);
-    resetPendingTxEnqueue();
+    queue_resetStats(&g_heap->txQueue);
 }
 
 
@@ -1572,7 +4985,7 @@ static void initUpdatePacket(UpdateHeap* heap)
 /// Register the callback functions for I2C-related events.
 static void registerI2cCallbacks(void)
 {
-    i2c_registerRxCallback(uart_txEnqueueData);
+    i2c_registerRxCallback(processI2cRx);
     i2c_registerErrorCallback(processI2cErrors);
 }
 
@@ -1583,6 +4996,9 @@ static void registerI2cCallbacks(void)
 ///         was already deactivated.
 static bool deactivate(void)
 {
+    stopTx();
+    cancelBaudSwitch();
+    
     bool deactivate = false;
     if (g_heap != NULL)
     {
@@ -1684,28 +5100,36 @@ static bool processBootloaderStatus(uint8_t bootloaderStatus, UpdateStatus* upda
 
 // === ISR =====================================================================
 
-/// ISR for UART IRQ's in general.
+/// ISR for UART IRQ's in general. The whole receive FIFO is drained on every
+/// receive interrupt and the transmit FIFO is refilled on every transmit
+/// interrupt.
 static void isr(void)
 {
-    uint32_t source = COMPONENT(HOST_UART, GetRxInterruptSource)();
-    if ((source & COMPONENT(HOST_UART, INTR_RX_NOT_EMPTY)) != 0)
-    {
-        uint32_t data = COMPONENT(HOST_UART, UartGetByte)();
-        if (data > 0xff)
-        {
-            // @TODO: Error handling.
-        }
-        else if (g_heap != NULL)
-            processRxByte(data);
-        COMPONENT(HOST_UART, ClearRxInterruptSource)(COMPONENT(HOST_UART, INTR_RX_NOT_EMPTY));
-    }
-    else if ((source & COMPONENT(HOST_UART, INTR_RX_FRAME_ERROR)) != 0)
+    uint32_t startTicks = hwSystemTime_getCurrentTicks();
+    uint32_t source = COMPONENT(HOST_UART, GetRxInterruptSourceMasked)();
+    if (source != 0)
     {
-        // Do some special handling for a frame error; possibly determine baud
-        // rate.
-        COMPONENT(HOST_UART, ClearRxInterruptSource)(COMPONENT(HOST_UART, INTR_RX_FRAME_ERROR));
+        // The frame errors drive the auto-baud detection (see
+        // processAutoBaud).
+        if ((source & COMPONENT(HOST_UART, INTR_RX_FRAME_ERROR)) != 0)
+            g_rxStats.frameErrors++;
+        if ((source & COMPONENT(HOST_UART, INTR_RX_OVERFLOW)) != 0)
+            g_rxStats.overflows++;
+        
+        readRxFifo();
+        
+        // Clear the level-based sources only after the receive FIFO is
+        // drained.
+        COMPONENT(HOST_UART, ClearRxInterruptSource)(source);
+        g_rxStats.isrCount++;
+        g_rxStats.isrTicks += hwSystemTime_getElapsedTicks(startTicks);
     }
-    g_lastRxTimeMs = hwSystemTime_getCurrentMs();
+
+#if ENABLE_UART_TX_INTERRUPT
+    if (COMPONENT(HOST_UART, GetTxInterruptSourceMasked)() != 0)
+        writeTxFifo();
+#endif // ENABLE_UART_TX_INTERRUPT
+    
     COMPONENT(HOST_UART, ClearPendingInt)();
 }
 
@@ -1715,10 +5139,34 @@ static void isr(void)
 void uart_init(void)
 {
     deactivate();
+    initCommandTable();
     
     // Setup the UART hardware.
     COMPONENT(HOST_UART, SetCustomInterruptHandler)(isr);
     COMPONENT(HOST_UART, Start)();
+    g_baud.divider = getUartClockDivider();
+    
+    // Setup the receive interrupt sources after starting the component; the
+    // start function sets up the interrupt sources from the design.
+#if ENABLE_UART_RX_FIFO_TRIGGER
+    COMPONENT(HOST_UART, SetRxFifoLevel)(UART_RX_FIFO_TRIGGER_LEVEL);
+    COMPONENT(HOST_UART, SetRxInterruptMode)(
+        COMPONENT(HOST_UART, INTR_RX_TRIGGER) |
+        COMPONENT(HOST_UART, INTR_RX_OVERFLOW) |
+        COMPONENT(HOST_UART, INTR_RX_FRAME_ERROR));
+#else
+    COMPONENT(HOST_UART, SetRxInterruptMode)(
+        COMPONENT(HOST_UART, INTR_RX_NOT_EMPTY) |
+        COMPONENT(HOST_UART, INTR_RX_OVERFLOW) |
+        COMPONENT(HOST_UART, INTR_RX_FRAME_ERROR));
+#endif // ENABLE_UART_RX_FIFO_TRIGGER
+    
+    // The transmit interrupt is only enabled while there is data to send (see
+    // startTx).
+#if ENABLE_UART_TX_INTERRUPT
+    COMPONENT(HOST_UART, SetTxFifoLevel)(UART_TX_FIFO_TRIGGER_LEVEL);
+    COMPONENT(HOST_UART, SetTxInterruptMode)(0u);
+#endif // ENABLE_UART_TX_INTERRUPT
 }
 
 
@@ -1736,6 +5184,36 @@ void uart_registerRxFrameOverflowCallback(UartRxFrameOverflowCallback callback)
 }
 
 
+bool uart_registerCommandHandler(uint8_t command, uint8_t minSize, UartCommandHandler handler)
+{
+    if ((command < COMMAND_TABLE_BASE) || (command >= (COMMAND_TABLE_BASE + COMMAND_TABLE_SIZE)))
+        return false;
+    
+    // Take the place of the handler registered for the same command, if any;
+    // otherwise, take a free slot.
+    CommandHandler* slot = NULL;
+    for (uint8_t i = 0; i < COMMAND_REGISTERED_MAX_COUNT; ++i)
+    {
+        CommandHandler* registered = &g_registeredCommandHandlers[i];
+        if ((registered->handler != NULL) && (registered->command == command))
+        {
+            slot = registered;
+            break;
+        }
+        if ((slot == NULL) && (registered->handler == NULL))
+            slot = registered;
+    }
+    if (slot == NULL)
+        return false;
+    
+    slot->handler = handler;
+    slot->command = command;
+    slot->minSize = minSize;
+    initCommandTable();
+    return true;
+}
+
+
 bool uart_isTxQueueEmpty(void)
 {
     bool empty = false;
@@ -1748,44 +5226,36 @@ bool uart_isTxQueueEmpty(void)
 bool uart_txEnqueueData(uint8_t const data[], uint16_t size)
 {
     bool status = false;
-    if ((g_heap != NULL) && !queue_isFull(&g_heap->txQueue))
-    {
-        g_pendingTxEnqueue.command = BridgeCommand_None;
-        g_pendingTxEnqueue.commandFlag = false;
-        g_pendingTxEnqueue.dataFlag = true;
-        status = queue_enqueue(&g_heap->txQueue, data, size); 
-    }
+    if ((data != NULL) && (size > 0))
+        status = txEnqueue(BridgeCommand_None, data, size);
     return status;
 }
 
 
+bool uart_txEnqueueResponse(uint8_t command, uint8_t const data[], uint16_t size)
+{
+    return txEnqueueCommandResponse((BridgeCommand)command, data, size);
+}
+
+
 bool uart_txEnqueueError(uint8_t const data[], uint16_t size)
 {
     bool status = false;
     if (error_getMode() == ErrorMode_Global)
-    {
-        if ((g_heap != NULL) && !queue_isFull(&g_heap->txQueue))
-        {
-            g_pendingTxEnqueue.command = BridgeCommand_Error;
-            g_pendingTxEnqueue.commandFlag = true;
-            g_pendingTxEnqueue.dataFlag = true;
-            status = queue_enqueue(&g_heap->txQueue, data, size); 
-        }
-    }
+        status = txEnqueueCommandResponse(BridgeCommand_Error, data, size);
     return status;
 }
 
 
 void uart_write(char const string[])
 {
-    COMPONENT(HOST_UART, UartPutString)(string);
+    writeString(string);
 }
 
 
 void uart_writeNewline(void)
 {
-    COMPONENT(HOST_UART, UartPutChar)('\r');
-    COMPONENT(HOST_UART, UartPutChar)('\n');
+    writeString("\r\n");
 }
 
 
@@ -1801,7 +5271,7 @@ void uart_writeHexUint8(uint8_t value)
         string[offset--] = G_AsciiHexTable[value & ASCII_HEX_CHAR_MASK];
         value >>= ASCII_HEX_CHAR_SHIFT;
     }
-    COMPONENT(HOST_UART, UartPutString)(string);
+    writeString(string);
 }
 
 
@@ -1817,7 +5287,7 @@ void uart_writeHexUint16(uint16_t value)
         string[offset--] = G_AsciiHexTable[value & ASCII_HEX_CHAR_MASK];
         value >>= ASCII_HEX_CHAR_SHIFT;
     }
-    COMPONENT(HOST_UART, UartPutString)(string);
+    writeString(string);
 }
 
 
@@ -1833,7 +5303,7 @@ void uart_writeHexUint32(uint32_t value)
         string[offset--] = G_AsciiHexTable[value & ASCII_HEX_CHAR_MASK];
         value >>= ASCII_HEX_CHAR_SHIFT;
     }
-    COMPONENT(HOST_UART, UartPutString)(string);
+    writeString(string);
 }
 
 
@@ -1855,9 +5325,19 @@ uint16_t uartTranslate_activate(heapWord_t memory[], uint16_t size)
         TranslateHeap* heap = (TranslateHeap*)g_heap;
         initTranslateDecodedRxQueue(heap);
         initTranslateTxQueue(heap);
+    #if ENABLE_UART_RX_DEFERRED_PARSING
+        initTranslateRawRxQueue(heap);
+    #endif // ENABLE_UART_RX_DEFERRED_PARSING
         g_updateFile.updateChunk = NULL;
         g_updateFile.updateFsm = NULL;
         initRx();
+        initCrc();
+        initFraming();
+        initSequence();
+        initCredit();
+    #if ENABLE_UART_TX_DELTA_REPORTS
+        initDelta(heap->heapData.deltaReferences);
+    #endif // ENABLE_UART_TX_DELTA_REPORTS
         registerI2cCallbacks();
         allocatedSize = requiredSize;
     }
@@ -1890,20 +5370,50 @@ uint16_t uartTranslate_processRx(uint32_t timeoutMs)
             alarm_arm(&alarm, timeoutMs, AlarmType_ContinuousNotification);
         else
             alarm_disarm(&alarm);
-            
+        
+        pollRxFifo();
+    #if ENABLE_UART_RX_DEFERRED_PARSING
+        processRawRxQueue();
+    #endif // ENABLE_UART_RX_DEFERRED_PARSING
         while (!queue_isEmpty(&g_heap->decodedRxQueue))
         {
             if (alarm.armed && alarm_hasElapsed(&alarm))
                 break;
             
             uint8_t* data;
-            uint16_t size = queue_dequeue(&g_heap->decodedRxQueue, &data);
+            uint16_t size = queue_peak(&g_heap->decodedRxQueue, &data);
             if (size > 0)
             {
                 if (processDecodedRxPacket(data, size))
                     ++count;
+                
+                // A paused batch resumes from the same element on the next
+                // call once the I2C module has made room.
+                if (g_batch.paused)
+                    break;
+                queue_dequeue(&g_heap->decodedRxQueue, &data);
+                g_creditReportPending = true;
             }
+        #if ENABLE_UART_RX_DEFERRED_PARSING
+            processRawRxQueue();
+        #endif // ENABLE_UART_RX_DEFERRED_PARSING
+        }
+        
+        // One credit frame reports the credit released by this call; it's
+        // retried on the next call if the transmit queue is full.
+        if (g_creditReportEnabled && g_creditReportPending)
+        {
+            g_creditReportPending = false;
+            if (!txEnqueueCredit())
+                g_creditReportPending = true;
         }
+    #if ENABLE_UART_RTS
+        pollRts();
+    #endif // ENABLE_UART_RTS
+    
+    #if ENABLE_UART_AUTO_BAUD
+        processAutoBaud();
+    #endif // ENABLE_UART_AUTO_BAUD
     }
     return count;
 }
@@ -1914,26 +5424,37 @@ uint16_t uartTranslate_processTx(uint32_t timeoutMs)
     uint16_t count = 0;
     if (uartTranslate_isActivated())
     {
+    #if ENABLE_UART_TX_INTERRUPT
+        // The ISR sends the transmit queue so there's nothing to time out;
+        // only start the transmitter.
+        (void)timeoutMs;
+        startTx();
+    #else
         Alarm alarm;
         if (timeoutMs > 0)
             alarm_arm(&alarm, timeoutMs, AlarmType_ContinuousNotification);
         else
             alarm_disarm(&alarm);
-            
-        while (!queue_isEmpty(&g_heap->txQueue))
+        
+        uint8_t buffer[COMPONENT(HOST_UART, SPI_UART_FIFO_SIZE)];
+        while (!(alarm.armed && alarm_hasElapsed(&alarm)))
         {
-            if (alarm.armed && alarm_hasElapsed(&alarm))
+            uint16_t size = readTxStream(buffer, sizeof(buffer));
+            if (size == 0)
                 break;
             
-            uint8_t* data;
-            uint16_t size = queue_dequeue(&g_heap->txQueue, &data);
-            if (size > 0)
-            {
-                for (uint32_t i = 0; i < size; ++i)
-                    COMPONENT(HOST_UART, UartPutChar)(data[i]);
-                ++count;
-            }
+            for (uint16_t i = 0; i < size; ++i)
+                COMPONENT(HOST_UART, UartPutChar)(buffer[i]);
         }
+    #endif // ENABLE_UART_TX_INTERRUPT
+        
+        processBaudSwitch();
+        
+        // Report the number of transmit queue elements sent since the last
+        // call.
+        uint16_t sentCount = g_txStream.sentCount;
+        count = sentCount - g_txStream.reportedCount;
+        g_txStream.reportedCount = sentCount;
     }
     return count;
 }
@@ -1957,9 +5478,19 @@ uint16_t uartUpdate_activate(heapWord_t memory[], uint16_t size)
         UpdateHeap* heap = (UpdateHeap*)g_heap;
         initUpdateDecodedRxQueue(heap);
         initUpdateTxQueue(heap);
+    #if ENABLE_UART_RX_DEFERRED_PARSING
+        disableRawRxQueue();
+    #endif // ENABLE_UART_RX_DEFERRED_PARSING
         initUpdatePacket(heap);
         resetUpdateFile();
         initRx();
+        initCrc();
+        initFraming();
+        initSequence();
+        initCredit();
+    #if ENABLE_UART_TX_DELTA_REPORTS
+        initDelta(NULL);
+    #endif // ENABLE_UART_TX_DELTA_REPORTS
         registerI2cCallbacks();
         allocatedSize = requiredSize;
     }
@@ -1993,15 +5524,17 @@ bool uartUpdate_process(void)
     {
         Alarm alarm;
         alarm_arm(&alarm, TimeoutMs, AlarmType_ContinuousNotification);
+        pollRxFifo();
         while (!queue_isEmpty(&g_heap->decodedRxQueue))
         {
             if (alarm.armed && alarm_hasElapsed(&alarm))
                 break;
             
             uint8_t* data;
+            bool failed = false;
             callsite.value = 0u;
             callsite.topCall += 1;
-            uint16_t size = queue_dequeue(&g_heap->decodedRxQueue, &data);
+            uint16_t size = queue_peak(&g_heap->decodedRxQueue, &data);
             if (size > 0)
             {
                 callsite.topCall += 2u;
@@ -2026,26 +5559,32 @@ bool uartUpdate_process(void)
                         else
                         {
                             status.i2cCommError = true;
-                            break;
+                            failed = true;
                         }
                     }
                     else
                     {
                         status.i2cCommError = true;
-                        break;
+                        failed = true;
                     }
                 }
                 else
                 {
                     status.invalidInputParameters = true;
-                    break;
+                    failed = true;
                 }
             }
             else
             {
                 status.invalidInputParameters = true;
-                break;
+                failed = true;
             }
+            
+            // Release the subchunk only after it has been written to the
+            // bootloader; the ISR may reuse its data once it is dequeued.
+            queue_dequeue(&g_heap->decodedRxQueue, &data);
+            if (failed)
+                break;
         }
         processed = true;
     }
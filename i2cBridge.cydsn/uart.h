@@ -40,6 +40,13 @@
     /// error handling/messaging in the callback function.
     typedef bool (*UartRxFrameOverflowCallback)(uint8_t);
     
+    /// Definition of the bridge command handler function that processes the
+    /// data payload (the bytes after the command byte and the sequence ID) of
+    /// a bridge command received from the host in translate mode. Respond with
+    /// uart_txEnqueueResponse; the response is tagged with the sequence ID of
+    /// the command.
+    typedef bool (*UartCommandHandler)(uint8_t const[], uint16_t);
+    
     
     // === FUNCTIONS ===========================================================
     
@@ -57,6 +64,17 @@
     /// @param[in]  callback    Pointer to the callback function.
     void uart_registerRxFrameOverflowCallback(UartRxFrameOverflowCallback callback);
     
+    /// Registers the handler of a bridge command; it takes the place of the
+    /// built-in handler of the command, if any. Commands with a data payload
+    /// shorter than the min size are dropped without invoking the handler.
+    /// @param[in]  command The bridge command (0x40-0x7f).
+    /// @param[in]  minSize The min size of the data payload.
+    /// @param[in]  handler Pointer to the handler function; NULL to remove the
+    ///                     handler registered for the command.
+    /// @return If the handler was registered; false if the command is out of
+    ///         range or too many handlers are registered.
+    bool uart_registerCommandHandler(uint8_t command, uint8_t minSize, UartCommandHandler handler);
+    
     /// Checks to see if the transmit queue is empty. If the transmit queue is
     /// empty, there is nothing to send.
     /// @return If the transmit queue is empty.
@@ -68,6 +86,13 @@
     /// @return If the data was successfully enqueued.
     bool uart_txEnqueueData(uint8_t const data[], uint16_t size);
     
+    /// Enqueue the response to a bridge command into the transmit queue.
+    /// @param[in]  command The bridge command of the response.
+    /// @param[in]  data    The data payload of the response.
+    /// @param[in]  size    The size of the data payload.
+    /// @return If the response was successfully enqueued.
+    bool uart_txEnqueueResponse(uint8_t command, uint8_t const data[], uint16_t size);
+    
     /// Enqueue error with associated data into the transmit queue.
     /// @param[in]  data    The data associated with the error to enqueue.
     /// @param[in]  size    The size of the data.
@@ -0,0 +1,33 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Project configuration of the host tests with ENABLE_CRC16_SLICE_BY_4 set;
+// put ahead of the project's Definitions directory in the include path.
+
+#ifndef CONFIG_CRC16_SLICE_BY_4_H
+    #define CONFIG_CRC16_SLICE_BY_4_H
+    
+    // === DEPENDENCIES ========================================================
+    
+    #include "../../../i2cBridge.cydsn/Definitions/config.h"
+    
+    
+    // === DEFINES =============================================================
+    
+    #undef ENABLE_CRC16_SLICE_BY_4
+    #define ENABLE_CRC16_SLICE_BY_4                         (true)
+    
+    
+#endif // CONFIG_CRC16_SLICE_BY_4_H
+
+
+/* [] END OF FILE */
@@ -0,0 +1,33 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Project configuration of the host tests with I2C_SLAVE_COUNT set to 4;
+// put ahead of the project's Definitions directory in the include path.
+
+#ifndef CONFIG_I2C_MULTI_SLAVE_H
+    #define CONFIG_I2C_MULTI_SLAVE_H
+    
+    // === DEPENDENCIES ========================================================
+    
+    #include "../../../i2cBridge.cydsn/Definitions/config.h"
+    
+    
+    // === DEFINES =============================================================
+    
+    #undef I2C_SLAVE_COUNT
+    #define I2C_SLAVE_COUNT                                 (4u)
+    
+    
+#endif // CONFIG_I2C_MULTI_SLAVE_H
+
+
+/* [] END OF FILE */
@@ -0,0 +1,34 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Project configuration of the host tests with ENABLE_UART_TX_SWAR_ESCAPE_SCAN
+// cleared; put ahead of the project's Definitions directory in the include
+// path.
+
+#ifndef CONFIG_UART_BYTEWISE_ESCAPE_SCAN_H
+    #define CONFIG_UART_BYTEWISE_ESCAPE_SCAN_H
+    
+    // === DEPENDENCIES ========================================================
+    
+    #include "../../../i2cBridge.cydsn/Definitions/config.h"
+    
+    
+    // === DEFINES =============================================================
+    
+    #undef ENABLE_UART_TX_SWAR_ESCAPE_SCAN
+    #define ENABLE_UART_TX_SWAR_ESCAPE_SCAN                 (false)
+    
+    
+#endif // CONFIG_UART_BYTEWISE_ESCAPE_SCAN_H
+
+
+/* [] END OF FILE */
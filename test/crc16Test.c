@@ -0,0 +1,196 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host test of the CRC-16: crc16_update and crc16_updateByte are checked
+// against a bitwise CRC-16/CCITT-FALSE for the check string and for random
+// data of every length up to MAX_DATA_SIZE, split at every offset and followed
+// by their own CRC-16. Also reports the throughput and the per-frame cost of
+// crc16_update. Built with ENABLE_CRC16_SLICE_BY_4 off (crc16Test) and on
+// (crc16SliceBy4Test).
+
+// === DEPENDENCIES ============================================================
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "config.h"
+#include "crc16.h"
+
+
+// === DEFINES =================================================================
+
+/// The max number of bytes of the random data.
+#define MAX_DATA_SIZE                   (300u)
+
+/// The CRC-16/CCITT-FALSE of the check string "123456789".
+#define CHECK_VALUE                     (0x29b1u)
+
+/// The number of bytes of data per frame of the throughput measurement.
+#define THROUGHPUT_FRAME_SIZE           (4096u)
+
+/// The number of bytes the CRC-16 is calculated over per measurement.
+#define BENCHMARK_BYTE_COUNT            (64000000ul)
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The random data.
+static uint8_t g_data[THROUGHPUT_FRAME_SIZE];
+
+/// State of the pseudo-random number generator.
+static uint32_t g_random = 0x12345678u;
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Get the next pseudo-random number (xorshift32).
+/// @return The pseudo-random number.
+static uint32_t nextRandom(void)
+{
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 17;
+    g_random ^= g_random << 5;
+    return g_random;
+}
+
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        if (g_failures < 10)
+            printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Get the current time of the monotonic clock.
+/// @return The current time (ns).
+static double getTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+
+/// Calculate the CRC-16/CCITT-FALSE of a block of data bit by bit.
+/// @param[in]  crc     The CRC-16 so far.
+/// @param[in]  data    The data to add to the CRC-16.
+/// @param[in]  size    The number of bytes of data.
+/// @return The updated CRC-16.
+static uint16_t referenceCrc16(uint16_t crc, uint8_t const data[], uint16_t size)
+{
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (uint8_t bit = 0; bit < 8u; ++bit)
+            crc = ((crc & 0x8000u) > 0) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+
+/// Check the CRC-16 of the check string and of random data of every length
+/// against the bitwise reference.
+static void runReferenceTest(void)
+{
+    static uint8_t const CheckString[] = "123456789";
+    
+    check(crc16_update(CRC16_INITIAL_VALUE, CheckString, 9u) == CHECK_VALUE, "check value");
+    check(referenceCrc16(CRC16_INITIAL_VALUE, CheckString, 9u) == CHECK_VALUE, "reference check value");
+    check(crc16_update(CRC16_INITIAL_VALUE, NULL, 9u) == CRC16_INITIAL_VALUE, "no data");
+    
+    for (uint16_t i = 0; i < sizeof(g_data); ++i)
+        g_data[i] = (uint8_t)nextRandom();
+    for (uint16_t size = 0; size < MAX_DATA_SIZE; ++size)
+    {
+        // Cycle the start of the data through the 4 byte alignments.
+        uint8_t const* data = &g_data[size & 3u];
+        uint16_t expected = referenceCrc16(CRC16_INITIAL_VALUE, data, size);
+        check(crc16_update(CRC16_INITIAL_VALUE, data, size) == expected, "block CRC-16");
+        
+        uint16_t crc = CRC16_INITIAL_VALUE;
+        for (uint16_t i = 0; i < size; ++i)
+            crc = crc16_updateByte(crc, data[i]);
+        check(crc == expected, "byte-by-byte CRC-16");
+        
+        for (uint16_t split = 0; split <= size; ++split)
+        {
+            crc = crc16_update(CRC16_INITIAL_VALUE, data, split);
+            crc = crc16_update(crc, &data[split], size - split);
+            check(crc == expected, "incremental CRC-16");
+        }
+        
+        uint8_t trailer[2] = { (uint8_t)(expected >> 8), (uint8_t)expected };
+        check(crc16_update(expected, trailer, sizeof(trailer)) == CRC16_RESIDUE, "residue");
+    }
+}
+
+
+/// Measure the time crc16_update takes for frames of a size.
+/// @param[in]  size    The number of bytes per frame.
+/// @return The time per frame (ns).
+static double measureFrame(uint16_t size)
+{
+    unsigned long frameCount = BENCHMARK_BYTE_COUNT / (size + 16u);
+    uint16_t crc = CRC16_INITIAL_VALUE;
+    double start = getTimeNs();
+    for (unsigned long i = 0; i < frameCount; ++i)
+        crc = crc16_update(crc, g_data, size);
+    double elapsed = getTimeNs() - start;
+    
+    // Keep the result so the calculation isn't optimized out.
+    g_random ^= crc;
+    return elapsed / frameCount;
+}
+
+
+/// Report the throughput of crc16_update on large frames and its cost per
+/// frame: the time of a frame minus the time its bytes take at the throughput
+/// rate.
+static void runBenchmark(void)
+{
+    static uint16_t const FrameSizes[] = { 0u, 8u, 64u, 260u };
+    
+    double byteNs = measureFrame(THROUGHPUT_FRAME_SIZE) / THROUGHPUT_FRAME_SIZE;
+    printf("slice-by-4 %s: %.0f MB/s (%.2f ns/byte)\n",
+        ENABLE_CRC16_SLICE_BY_4 ? "on" : "off", 1e3 / byteNs, byteNs);
+    for (uint8_t i = 0; i < (sizeof(FrameSizes) / sizeof(FrameSizes[0])); ++i)
+    {
+        double frameNs = measureFrame(FrameSizes[i]);
+        printf("%3u byte frames: %6.1f ns/frame, %5.1f ns overhead\n",
+            FrameSizes[i], frameNs, frameNs - (FrameSizes[i] * byteNs));
+    }
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    runReferenceTest();
+    runBenchmark();
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,531 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host simulation of the communication state machine with several slaves on
+// one bus (built with I2C_SLAVE_COUNT = 4, see config/i2cMultiSlave). A model
+// of the SCB I2C master and of the slaves runs on simulated time: each slave
+// asserts its IRQ line when it has a report, the bridge reads the report and
+// the slave's IRQ is cleared by the write that acknowledges it. Checks that
+// the slaves are serviced round-robin, that every report is forwarded once as
+// a slave IRQ read with the address of the slave that raised the IRQ, and
+// reports the aggregate report rate and the IRQ-to-forward latency at 400 kHz
+// and 1 MHz.
+
+// === DEPENDENCIES ============================================================
+
+#include "i2c.c"
+
+#include <stdio.h>
+
+
+// === DEFINES =================================================================
+
+/// The number of slaves on the bus.
+#define SLAVE_COUNT                     (I2C_SLAVE_COUNT)
+
+/// The mask of all the slaves.
+#define ALL_SLAVES                      ((1u << SLAVE_COUNT) - 1u)
+
+/// The I2C address of the first slave (the default address of the slave
+/// contexts is consecutive).
+#define FIRST_SLAVE_ADDRESS             (0x48u)
+
+/// The number of bytes of a report; a report starts with the command, the
+/// payload size and the index of the slave that sent it.
+#define REPORT_SIZE                     (12u)
+
+/// The amount of simulated time a call to i2cTouch_process is given (us).
+#define STEP_US                         (20l)
+
+/// The amount of simulated time each scenario runs (us).
+#define RUN_US                          (1000000l)
+
+/// The period of the reports of the periodic scenarios: 200 Hz per slave.
+#define REPORT_PERIOD_US                (5000l)
+
+
+// === TYPE DEFINES ============================================================
+
+/// Model of a slave on the bus.
+typedef struct SlaveModel
+{
+    /// The report the slave returns when read.
+    uint8_t report[REPORT_SIZE];
+    
+    /// The time the slave asserts its IRQ for the next report (us); negative
+    /// if it has no report.
+    long nextReportUs;
+    
+    /// The time between the reports (us); 0 if the slave has the next report
+    /// as soon as its IRQ is cleared.
+    long periodUs;
+    
+    /// The time the slave asserted its IRQ (us).
+    long assertedUs;
+    
+    /// The longest time between the IRQ and the report being forwarded (us).
+    long maxLatencyUs;
+    
+    /// The number of reports forwarded.
+    unsigned long reports;
+    
+} SlaveModel;
+
+
+/// Model of the SCB I2C master.
+typedef struct MasterModel
+{
+    /// The buffer of the read in progress.
+    uint8_t* readBuffer;
+    
+    /// The number of bytes of the read in progress.
+    uint32_t readSize;
+    
+    /// The time left until the transfer in progress completes (us).
+    long remainingUs;
+    
+    /// The index of the slave of the transfer in progress; -1 if no slave
+    /// answers the address.
+    int slave;
+    
+    /// The master status (slaveI2c_I2CMasterStatus).
+    uint32_t status;
+    
+    /// Flag indicating if a transfer is in progress.
+    bool busy;
+    
+    /// Flag indicating if the transfer in progress is a read.
+    bool read;
+    
+} MasterModel;
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The simulated time (us).
+static long g_simUs = 0;
+
+/// The slaves.
+static SlaveModel g_slaveModels[SLAVE_COUNT];
+
+/// The SCB I2C master.
+static MasterModel g_master;
+
+/// Mask of the slaves that assert their IRQ line.
+static uint8_t g_irqLines = 0u;
+
+/// Mask of the IRQ lines with a falling edge not yet cleared by the ISR.
+static uint8_t g_irqEdges = 0u;
+
+/// Mask of the slaves that send reports.
+static uint8_t g_activeSlaves = 0u;
+
+/// Flag indicating if the slave IRQ interrupt is enabled.
+static bool g_irqEnabled = true;
+
+/// The number of reads forwarded that weren't a slave IRQ read of the slave
+/// they came from.
+static unsigned long g_badReads = 0;
+
+/// The number of errors reported.
+static unsigned long g_errors = 0;
+
+/// The heap of the I2C module.
+static heapWord_t g_heapMemory[1000];
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Get the slave at an I2C address.
+/// @param[in]  address The 7-bit I2C address.
+/// @return The index of the slave; -1 if no slave has the address.
+static int findSlave(uint32_t address)
+{
+    int slave = (int)address - (int)FIRST_SLAVE_ADDRESS;
+    return ((slave >= 0) && (slave < (int)SLAVE_COUNT)) ? slave : -1;
+}
+
+
+/// Assert the IRQ of a slave and run the slave IRQ ISR.
+/// @param[in]  slave   The index of the slave.
+static void assertIrq(int slave)
+{
+    g_irqLines |= (uint8_t)(1u << slave);
+    g_irqEdges |= (uint8_t)(1u << slave);
+    g_slaveModels[slave].assertedUs = g_simUs;
+    if (g_irqEnabled)
+        slaveIsr();
+}
+
+
+/// Advance the simulated time: the slaves with a new report assert their IRQ
+/// and the transfer in progress completes once its bytes have been clocked.
+/// @param[in]  us  The amount of time to advance (us).
+static void advance(long us)
+{
+    g_simUs += us;
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+    {
+        SlaveModel* slave = &g_slaveModels[i];
+        bool asserted = (g_irqLines & (1u << i)) > 0;
+        if (((g_activeSlaves & (1u << i)) > 0) && !asserted && (slave->nextReportUs >= 0) && (g_simUs >= slave->nextReportUs))
+        {
+            slave->nextReportUs = -1;
+            assertIrq(i);
+        }
+    }
+    
+    if (g_master.busy)
+    {
+        g_master.remainingUs -= us;
+        if (g_master.remainingUs <= 0)
+        {
+            g_master.busy = false;
+            if (g_master.read && (g_master.slave >= 0))
+                memcpy(g_master.readBuffer, g_slaveModels[g_master.slave].report, g_master.readSize);
+            g_master.status |= g_master.read ? slaveI2c_I2C_MSTAT_RD_CMPLT : slaveI2c_I2C_MSTAT_WR_CMPLT;
+            slaveI2c_I2C_ISR_ExitCallback();
+        }
+    }
+}
+
+
+/// Start a transfer on the bus; it takes the time to clock its bytes and the
+/// address at the bit rate of the bridge.
+/// @param[in]  slaveAddress    The 7-bit I2C address.
+/// @param[in]  data            The data of the transfer.
+/// @param[in]  size            The number of bytes of the transfer.
+/// @param[in]  read            Flag indicating if the transfer is a read.
+/// @return The driver return value.
+static uint32_t startTransfer(uint32_t slaveAddress, uint8_t* data, uint32_t size, bool read)
+{
+    if (g_master.busy)
+        return slaveI2c_I2C_MSTR_BUS_BUSY;
+    g_master.busy = true;
+    g_master.read = read;
+    g_master.readBuffer = data;
+    g_master.readSize = size;
+    g_master.slave = findSlave(slaveAddress);
+    g_master.remainingUs = 10l + (long)(((size + 1u) * 9u * 1000000ull) / i2c_getBitRate());
+    return slaveI2c_I2C_MSTR_NO_ERROR;
+}
+
+
+/// Receive callback: records a report forwarded by the bridge.
+/// @param[in]  data    The data read.
+/// @param[in]  size    The number of bytes read.
+/// @param[in]  tag     The tag of the read.
+/// @param[in]  address The 7-bit I2C address the data was read from.
+/// @param[in]  irqRead Flag indicating if the read was triggered by a slave IRQ.
+/// @return Always true.
+static bool receive(uint8_t const* data, uint16_t size, uint8_t tag, uint8_t address, bool irqRead)
+{
+    (void)size;
+    (void)tag;
+    int slave = findSlave(address);
+    if ((slave < 0) || (data[2] != slave) || !irqRead)
+    {
+        g_badReads++;
+        return true;
+    }
+    
+    SlaveModel* model = &g_slaveModels[slave];
+    model->reports++;
+    if ((g_simUs - model->assertedUs) > model->maxLatencyUs)
+        model->maxLatencyUs = g_simUs - model->assertedUs;
+    return true;
+}
+
+
+/// Error callback: counts the errors.
+/// @param[in]  status      The status of the error.
+/// @param[in]  callsite    The callsite of the error.
+/// @param[in]  tag         The tag of the transfer that failed.
+static void reportError(I2cStatus status, callsite_t callsite, uint8_t tag)
+{
+    (void)status;
+    (void)callsite;
+    (void)tag;
+    g_errors++;
+}
+
+
+/// Run the communication state machine until the bus is idle and no slave
+/// asserts its IRQ.
+static void settle(void)
+{
+    for (int i = 0; (i < 5000) && ((g_commFsm.state != CommState_Waiting) || g_master.busy || (g_irqLines != 0u)); ++i)
+    {
+        i2cTouch_process(5u);
+        advance(STEP_US);
+    }
+}
+
+
+/// Run a scenario for RUN_US.
+/// @param[in]  slaves      Mask of the slaves that send reports.
+/// @param[in]  periodUs    The time between the reports of each slave (us); 0
+///                         if each slave has the next report as soon as its
+///                         IRQ is cleared.
+/// @param[in]  staggered   Flag indicating if the first reports of the slaves
+///                         are spread over the period.
+/// @return The number of reports forwarded.
+static unsigned long run(uint8_t slaves, long periodUs, bool staggered)
+{
+    g_activeSlaves = slaves;
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+    {
+        SlaveModel* slave = &g_slaveModels[i];
+        slave->reports = 0;
+        slave->maxLatencyUs = 0;
+        slave->periodUs = periodUs;
+        slave->nextReportUs = -1;
+        if ((slaves & (1u << i)) > 0)
+            slave->nextReportUs = g_simUs + (staggered ? ((periodUs * i) / (long)SLAVE_COUNT) : 0l);
+    }
+    
+    long start = g_simUs;
+    while ((g_simUs - start) < RUN_US)
+    {
+        i2cTouch_process(5u);
+        advance(STEP_US);
+    }
+    g_activeSlaves = 0u;
+    settle();
+    
+    unsigned long reports = 0;
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+        reports += g_slaveModels[i].reports;
+    return reports;
+}
+
+
+/// Run the scenarios at a bit rate.
+/// @param[in]  bitRate The I2C bit rate.
+static void runBitRate(uint32_t bitRate)
+{
+    i2c_setBitRate(bitRate);
+    
+    unsigned long single = run(0x01u, 0l, true);
+    unsigned long all = run(ALL_SLAVES, 0l, true);
+    unsigned long least = g_slaveModels[0].reports;
+    unsigned long most = g_slaveModels[0].reports;
+    for (int i = 1; i < (int)SLAVE_COUNT; ++i)
+    {
+        if (g_slaveModels[i].reports < least)
+            least = g_slaveModels[i].reports;
+        if (g_slaveModels[i].reports > most)
+            most = g_slaveModels[i].reports;
+    }
+    printf("%7u Hz saturated: 1 slave %lu reports/s, %u slaves %lu reports/s (%lu to %lu per slave)\n",
+        bitRate, single, SLAVE_COUNT, all, least, most);
+    check((most - least) <= 1u, "round-robin service");
+    check((all * 100u) >= (single * 95u), "aggregate rate keeps up with one slave");
+    
+    for (int staggered = 1; staggered >= 0; --staggered)
+    {
+        unsigned long reports = run(ALL_SLAVES, REPORT_PERIOD_US, staggered > 0);
+        long maxLatencyUs = 0;
+        for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+        {
+            if (g_slaveModels[i].maxLatencyUs > maxLatencyUs)
+                maxLatencyUs = g_slaveModels[i].maxLatencyUs;
+        }
+        printf("%7u Hz 200 Hz per slave, %s: %lu reports/s, max latency %ld us\n",
+            bitRate, (staggered > 0) ? "staggered" : "in phase", reports, maxLatencyUs);
+        check(reports >= (SLAVE_COUNT * ((RUN_US / REPORT_PERIOD_US) - 1u)), "periodic reports forwarded");
+    }
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    i2c_init();
+    i2c_registerRxCallback(receive);
+    i2c_registerErrorCallback(reportError);
+    i2cTouch_activate(g_heapMemory, sizeof(g_heapMemory) / sizeof(g_heapMemory[0]));
+    check(g_slaves[0].address == FIRST_SLAVE_ADDRESS, "default address of the first slave");
+    check(g_slaves[SLAVE_COUNT - 1u].address == (FIRST_SLAVE_ADDRESS + SLAVE_COUNT - 1u), "default address of the last slave");
+    check(!i2c_setSlaveContextAddress(SLAVE_COUNT, 0x30u), "invalid slave context");
+    
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+    {
+        g_slaveModels[i].report[0] = 0x10u;
+        g_slaveModels[i].report[1] = REPORT_SIZE - 2u;
+        g_slaveModels[i].report[2] = (uint8_t)i;
+    }
+    runBitRate(400000u);
+    runBitRate(1000000u);
+    
+    // All the IRQs asserted at once, like after a shared reset.
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+    {
+        g_slaveModels[i].reports = 0;
+        g_slaveModels[i].nextReportUs = -1;
+    }
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+        assertIrq(i);
+    settle();
+    for (int i = 0; i < (int)SLAVE_COUNT; ++i)
+        check(g_slaveModels[i].reports == 1u, "simultaneous IRQs read once");
+    
+    check(g_badReads == 0, "reads forwarded as slave IRQ reads of their slave");
+    check(g_errors == 0, "no errors");
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+// === COMPONENT MODEL =========================================================
+
+uint32_t hwSystemTime_getCurrentMs(void)
+{
+    return (uint32_t)(g_simUs / 1000l);
+}
+
+
+uint32_t hwSystemTime_getCurrentTicks(void)
+{
+    return 0u;
+}
+
+
+uint32_t hwSystemTime_getElapsedTicks(uint32_t startTicks)
+{
+    (void)startTicks;
+    return 0u;
+}
+
+
+uint32_t hwSystemTime_getTimestamp(void)
+{
+    return (uint32_t)(g_simUs * 48l);
+}
+
+
+void slaveI2c_Start(void) { }
+void slaveI2c_Stop(void) { }
+void slaveI2c_Init(void) { }
+void slaveI2c_Enable(void) { }
+void slaveI2c_SCBCLK_Start(void) { }
+void slaveI2c_SCBCLK_Stop(void) { }
+
+
+void slaveI2c_SCBCLK_SetFractionalDividerRegister(uint16_t clkDivider, uint8_t clkFractional)
+{
+    (void)clkDivider;
+    (void)clkFractional;
+}
+
+
+uint32_t slaveI2c_I2CMasterStatus(void)
+{
+    // Polling the driver takes time.
+    advance(1l);
+    return g_master.status | (g_master.busy ? slaveI2c_I2C_MSTAT_XFER_INP : 0u);
+}
+
+
+uint32_t slaveI2c_I2CMasterClearStatus(void)
+{
+    g_master.status = slaveI2c_I2C_MSTAT_CLEAR;
+    return 0u;
+}
+
+
+uint32_t slaveI2c_I2CMasterReadBuf(uint32_t slaveAddress, uint8_t* rdData, uint32_t cnt, uint32_t mode)
+{
+    (void)mode;
+    return startTransfer(slaveAddress, rdData, cnt, true);
+}
+
+
+uint32_t slaveI2c_I2CMasterWriteBuf(uint32_t slaveAddress, uint8_t* wrData, uint32_t cnt, uint32_t mode)
+{
+    (void)mode;
+    uint32_t result = startTransfer(slaveAddress, wrData, cnt, false);
+    
+    // The write that acknowledges the report clears the IRQ of the slave; the
+    // slave has its next report after its period.
+    int slave = findSlave(slaveAddress);
+    if ((result == slaveI2c_I2C_MSTR_NO_ERROR) && (cnt == 2u) && (wrData[0] == 0x20u) && (slave >= 0) && ((g_irqLines & (1u << slave)) > 0))
+    {
+        SlaveModel* model = &g_slaveModels[slave];
+        g_irqLines &= (uint8_t)~(1u << slave);
+        model->nextReportUs = (model->periodUs > 0) ? (model->assertedUs + model->periodUs) : g_simUs;
+    }
+    return result;
+}
+
+
+uint32_t slaveI2c_I2CMasterSendStop(uint32_t timeoutMs)
+{
+    (void)timeoutMs;
+    return slaveI2c_I2C_MSTR_NO_ERROR;
+}
+
+
+void slaveIrq_StartEx(cyisraddress isr)
+{
+    (void)isr;
+}
+
+
+void slaveIrq_Enable(void)
+{
+    g_irqEnabled = true;
+}
+
+
+void slaveIrq_Disable(void)
+{
+    g_irqEnabled = false;
+}
+
+
+void slaveIrq_ClearPending(void) { }
+
+
+uint8_t slaveIrqPin_Read(void)
+{
+    // The IRQ lines are active low.
+    return (uint8_t)~g_irqLines;
+}
+
+
+uint8_t slaveIrqPin_ClearInterrupt(void)
+{
+    uint8_t edges = g_irqEdges;
+    g_irqEdges = 0u;
+    return edges;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,226 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host micro-benchmark of the Queue consumer: a full queue of 1, 8 and 260
+// byte elements is drained one element at a time (queue_peak/queue_dequeue)
+// and in batches (queue_peakBatch/queue_dequeueBatch); reports the frames
+// drained per second of both methods. Both methods must drain the same frames
+// with the same data.
+
+// === DEPENDENCIES ============================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "queue.h"
+
+
+// === DEFINES =================================================================
+
+/// The max number of elements of the queue under test.
+#define ELEMENT_COUNT                   (8u)
+
+/// The max size of an element.
+#define MAX_ELEMENT_SIZE                (260u)
+
+/// The size of the data array of the queue under test; fits ELEMENT_COUNT
+/// elements of the max size.
+#define DATA_SIZE                       (ELEMENT_COUNT * MAX_ELEMENT_SIZE)
+
+/// The max number of elements peaked per batch (like XFER_BATCH_SIZE of the
+/// I2C transfer queue).
+#define BATCH_SIZE                      (4u)
+
+/// The number of times the queue is filled and drained per measurement.
+#define ROUND_COUNT                     (2000000ul)
+
+
+// === TYPE DEFINES ============================================================
+
+/// Result of draining the queue ROUND_COUNT times.
+typedef struct Result
+{
+    /// The number of frames drained.
+    unsigned long frames;
+    
+    /// Checksum of the sizes and the data of the frames drained.
+    uint32_t checksum;
+    
+    /// The time spent draining the queue (ns).
+    double drainNs;
+    
+} Result;
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The data array of the queue under test.
+static uint8_t g_data[DATA_SIZE];
+
+/// The element array of the queue under test.
+static QueueElement g_elements[ELEMENT_COUNT];
+
+/// The queue under test.
+static Queue g_queue;
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Get the current time of the monotonic clock.
+/// @return The current time (ns).
+static double getTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+
+/// Process the data of a drained frame like a consumer that forwards it: the
+/// size and the first and last bytes are folded into the checksum.
+/// @param[in]  checksum    The running checksum.
+/// @param[in]  data        The data of the frame.
+/// @param[in]  size        The number of bytes of the frame.
+/// @return The updated checksum.
+static uint32_t consumeFrame(uint32_t checksum, uint8_t const data[], uint16_t size)
+{
+    checksum = (checksum * 31u) + size;
+    checksum = (checksum * 31u) + data[0];
+    return (checksum * 31u) + data[size - 1u];
+}
+
+
+/// Fill the queue with elements of a size until it's full.
+/// @param[in]  frame   The data of the elements.
+/// @param[in]  size    The number of bytes of each element.
+/// @param[in]  round   The round number; stamped into the data.
+static void fill(uint8_t frame[], uint16_t size, unsigned long round)
+{
+    frame[0] = (uint8_t)round;
+    frame[size - 1u] = (uint8_t)(round >> 8);
+    while (queue_enqueue(&g_queue, frame, size))
+        frame[0]++;
+}
+
+
+/// Reset the queue under test.
+static void resetQueue(void)
+{
+    memset(&g_queue, 0, sizeof(g_queue));
+    g_queue.data = g_data;
+    g_queue.elements = g_elements;
+    g_queue.maxDataSize = DATA_SIZE;
+    g_queue.maxSize = ELEMENT_COUNT;
+}
+
+
+/// Drain the full queue ROUND_COUNT times. The time spent filling the queue is
+/// measured in a separate pass (filled and emptied) and subtracted so the
+/// clock isn't read per round.
+/// @param[in]  size    The number of bytes of each element.
+/// @param[in]  batch   Flag indicating if the queue is drained in batches.
+/// @return The frames drained, their checksum and the time spent draining.
+static Result run(uint16_t size, bool batch)
+{
+    uint8_t frame[MAX_ELEMENT_SIZE];
+    memset(frame, 0x5a, sizeof(frame));
+    
+    resetQueue();
+    double start = getTimeNs();
+    for (unsigned long i = 0; i < ROUND_COUNT; ++i)
+    {
+        fill(frame, size, i);
+        queue_empty(&g_queue);
+    }
+    double fillNs = getTimeNs() - start;
+    
+    resetQueue();
+    Result result = { 0 };
+    start = getTimeNs();
+    for (unsigned long i = 0; i < ROUND_COUNT; ++i)
+    {
+        fill(frame, size, i);
+        if (batch)
+        {
+            QueueSpan spans[BATCH_SIZE];
+            uint8_t count;
+            while ((count = queue_peakBatch(&g_queue, spans, BATCH_SIZE)) > 0)
+            {
+                for (uint8_t j = 0; j < count; ++j)
+                    result.checksum = consumeFrame(result.checksum, spans[j].data, spans[j].size);
+                result.frames += queue_dequeueBatch(&g_queue, count);
+            }
+        }
+        else
+        {
+            uint8_t* data = NULL;
+            uint16_t dataSize;
+            while ((dataSize = queue_peak(&g_queue, &data)) > 0)
+            {
+                result.checksum = consumeFrame(result.checksum, data, dataSize);
+                queue_dequeue(&g_queue, &data);
+                result.frames++;
+            }
+        }
+    }
+    result.drainNs = getTimeNs() - start - fillNs;
+    return result;
+}
+
+
+/// Compare the single and the batch drain of elements of a size.
+/// @param[in]  size    The number of bytes of each element.
+static void compare(uint16_t size)
+{
+    Result single = run(size, false);
+    Result batch = run(size, true);
+    check(single.frames == (ROUND_COUNT * ELEMENT_COUNT), "single drain frame count");
+    check(batch.frames == single.frames, "batch drain frame count");
+    check(batch.checksum == single.checksum, "batch drain data");
+    
+    double singleRate = single.frames / (single.drainNs / 1e9);
+    double batchRate = batch.frames / (batch.drainNs / 1e9);
+    printf("%3u byte elements: single %6.1f Mframes/s, batch %6.1f Mframes/s (x%.2f)\n",
+        size, singleRate / 1e6, batchRate / 1e6, batchRate / singleRate);
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    compare(1u);
+    compare(8u);
+    compare(MAX_ELEMENT_SIZE);
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,412 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host stress test of the Queue ring: random element sizes are enqueued
+// (whole, byte-by-byte and in chunks) and dequeued (single and batch) while
+// every element is checked to be a contiguous span inside the data array with
+// the data it was enqueued with. An enqueue must only fail if there's no
+// contiguous region large enough after the newest element or at the start of
+// the data array. Also reports the sustained occupancy of a bursty stream.
+
+// === DEPENDENCIES ============================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+
+
+// === DEFINES =================================================================
+
+/// The size of the data array of the queue under test.
+#define DATA_SIZE                       (256u)
+
+/// The max number of elements of the queue under test.
+#define ELEMENT_COUNT                   (16u)
+
+/// The max size of a random element.
+#define MAX_ELEMENT_SIZE                (100u)
+
+/// The number of random operations of the stress test.
+#define OPERATION_COUNT                 (2000000ul)
+
+
+// === TYPE DEFINES ============================================================
+
+/// Expected contents of the elements in the queue (a FIFO of the element
+/// sizes and the seeds of their data).
+typedef struct Model
+{
+    /// The size of each element.
+    uint16_t sizes[ELEMENT_COUNT];
+    
+    /// The seed the data of each element was generated from.
+    uint32_t seeds[ELEMENT_COUNT];
+    
+    /// The index of the oldest element.
+    uint8_t head;
+    
+    /// The number of elements.
+    uint8_t count;
+    
+} Model;
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The data array of the queue under test.
+static uint8_t g_data[DATA_SIZE];
+
+/// The element array of the queue under test.
+static QueueElement g_elements[ELEMENT_COUNT];
+
+/// The queue under test.
+static Queue g_queue;
+
+/// The expected contents of the queue.
+static Model g_model;
+
+/// State of the pseudo-random number generator.
+static uint32_t g_random = 0x12345678u;
+
+/// The number of elements placed at the start of the data array after the
+/// newest element (the data wrapped around the end of the data array).
+static unsigned long g_wraps = 0;
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Get the next pseudo-random number (xorshift32).
+/// @return The pseudo-random number.
+static uint32_t nextRandom(void)
+{
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 17;
+    g_random ^= g_random << 5;
+    return g_random;
+}
+
+
+/// Get the byte of an element's data at an index.
+/// @param[in]  seed    The seed of the element's data.
+/// @param[in]  index   The index of the byte.
+/// @return The expected byte.
+static uint8_t getDataByte(uint32_t seed, uint16_t index)
+{
+    return (uint8_t)((seed * 31u) + (index * 7u) + (index >> 3));
+}
+
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        if (g_failures < 10)
+            printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Reset the queue under test and its model.
+static void resetQueue(void)
+{
+    memset(&g_queue, 0, sizeof(g_queue));
+    g_queue.data = g_data;
+    g_queue.elements = g_elements;
+    g_queue.maxDataSize = DATA_SIZE;
+    g_queue.maxSize = ELEMENT_COUNT;
+    memset(&g_model, 0, sizeof(g_model));
+}
+
+
+/// Find the number of contiguous bytes a new element can use from the spans of
+/// the elements in the queue: the region after the newest element (up to the
+/// oldest element if the data is wrapped, otherwise up to the end of the data
+/// array) or the region at the start of the data array (up to the oldest
+/// element) if the data isn't wrapped.
+/// @return The size of the largest region; 0 if the queue is full.
+static uint16_t findExpectedFreeSize(void)
+{
+    QueueSpan spans[ELEMENT_COUNT];
+    uint8_t count = queue_peakBatch(&g_queue, spans, ELEMENT_COUNT);
+    if (count == 0)
+        return DATA_SIZE;
+    if (count >= ELEMENT_COUNT)
+        return 0;
+    
+    uint16_t first = spans[0].data - g_data;
+    uint16_t last = spans[count - 1].data - g_data;
+    uint16_t end = last + spans[count - 1].size;
+    uint16_t after = DATA_SIZE - end;
+    uint16_t start = first;
+    if (last < first)
+    {
+        after = first - end;
+        start = 0;
+    }
+    return (after > start) ? (after) : (start);
+}
+
+
+/// Check the elements in the queue against the model: each element is a
+/// contiguous span inside the data array, the spans don't overlap and the
+/// data matches.
+static void checkContents(void)
+{
+    QueueSpan spans[ELEMENT_COUNT];
+    uint8_t count = queue_peakBatch(&g_queue, spans, ELEMENT_COUNT);
+    check(count == g_model.count, "element count");
+    check(count == queue_getSize(&g_queue), "queue_getSize");
+    
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        uint8_t index = (g_model.head + i) % ELEMENT_COUNT;
+        uint16_t offset = spans[i].data - g_data;
+        check(spans[i].size == g_model.sizes[index], "element size");
+        check((spans[i].data >= g_data) && ((offset + spans[i].size) <= DATA_SIZE), "span inside data array");
+        for (uint8_t j = 0; j < i; ++j)
+        {
+            uint16_t other = spans[j].data - g_data;
+            check(((offset + spans[i].size) <= other) || ((other + spans[j].size) <= offset), "spans overlap");
+        }
+        for (uint16_t k = 0; k < spans[i].size; ++k)
+        {
+            if (spans[i].data[k] != getDataByte(g_model.seeds[index], k))
+            {
+                check(false, "element data");
+                break;
+            }
+        }
+    }
+}
+
+
+/// Add an element to the model.
+/// @param[in]  size    The size of the element.
+/// @param[in]  seed    The seed of the element's data.
+static void pushModel(uint16_t size, uint32_t seed)
+{
+    uint8_t index = (g_model.head + g_model.count) % ELEMENT_COUNT;
+    g_model.sizes[index] = size;
+    g_model.seeds[index] = seed;
+    g_model.count++;
+}
+
+
+/// Remove elements from the model.
+/// @param[in]  count   The number of elements to remove.
+static void popModel(uint8_t count)
+{
+    g_model.head = (g_model.head + count) % ELEMENT_COUNT;
+    g_model.count -= count;
+}
+
+
+/// Enqueue a random element with one of the enqueue functions and check that
+/// the enqueue only fails if the element doesn't fit.
+/// @param[in]  method  0: queue_enqueue; 1: queue_enqueueByte; 2: chunks with
+///                     queue_enqueueBytes.
+static void enqueueRandom(uint8_t method)
+{
+    uint16_t size = 1u + (nextRandom() % MAX_ELEMENT_SIZE);
+    uint32_t seed = nextRandom();
+    uint8_t buffer[MAX_ELEMENT_SIZE];
+    for (uint16_t i = 0; i < size; ++i)
+        buffer[i] = getDataByte(seed, i);
+    
+    uint16_t freeSize = findExpectedFreeSize();
+    check(queue_getFreeDataSize(&g_queue) == freeSize, "queue_getFreeDataSize");
+    
+    bool status = true;
+    if (method == 0)
+        status = queue_enqueue(&g_queue, buffer, size);
+    else
+    {
+        uint16_t offset = 0;
+        while (status && (offset < size))
+        {
+            uint16_t chunk = (method == 1) ? (1u) : (1u + (nextRandom() % 16u));
+            if (chunk > (size - offset))
+                chunk = size - offset;
+            bool finalize = ((offset + chunk) >= size);
+            if (chunk == 1)
+                status = queue_enqueueByte(&g_queue, buffer[offset], finalize);
+            else
+                status = queue_enqueueBytes(&g_queue, &buffer[offset], chunk, finalize);
+            offset += chunk;
+        }
+        if (!status)
+            queue_enqueueDiscard(&g_queue);
+    }
+    
+    check(status == (size <= freeSize), (status) ? ("enqueue of an element that doesn't fit") : ("enqueue failed with room"));
+    if (status)
+    {
+        QueueSpan spans[ELEMENT_COUNT];
+        uint8_t count = queue_peakBatch(&g_queue, spans, ELEMENT_COUNT);
+        if ((count > 1) && (spans[count - 1].data < spans[count - 2].data))
+            g_wraps++;
+        pushModel(size, seed);
+    }
+}
+
+
+/// Dequeue a random number of elements (single or batch).
+static void dequeueRandom(void)
+{
+    if (g_model.count == 0)
+        return;
+    if ((nextRandom() & 1u) > 0)
+    {
+        uint8_t* data = NULL;
+        uint16_t size = queue_dequeue(&g_queue, &data);
+        check(size == g_model.sizes[g_model.head], "dequeued size");
+        popModel(1);
+    }
+    else
+    {
+        uint8_t count = 1u + (nextRandom() % g_model.count);
+        check(queue_dequeueBatch(&g_queue, count) == count, "dequeued count");
+        popModel(count);
+    }
+}
+
+
+/// Random mix of enqueues and dequeues with the contents checked after every
+/// operation.
+static void runStressTest(void)
+{
+    resetQueue();
+    for (unsigned long i = 0; i < OPERATION_COUNT; ++i)
+    {
+        uint32_t operation = nextRandom() % 8u;
+        if (operation < 2u)
+            dequeueRandom();
+        else
+            enqueueRandom(operation % 3u);
+        checkContents();
+    }
+    printf("stress: %lu operations, %lu wrapped elements\n", OPERATION_COUNT, g_wraps);
+    check(g_wraps > 0, "data wrapped");
+}
+
+
+/// A commit is only accepted for a live reservation: not after a failed
+/// reservation, not after another enqueue abandoned the reservation and not
+/// twice for the same reservation.
+static void runReservationTest(void)
+{
+    resetQueue();
+    uint8_t* reservation = queue_reserve(&g_queue, 200u);
+    check(reservation != NULL, "reservation");
+    memset(reservation, 0x5a, 200u);
+    check(queue_commit(&g_queue, 200u), "commit");
+    check(!queue_commit(&g_queue, 10u), "second commit of a reservation");
+    
+    // No room for the reservation: the commit must not publish the stale
+    // offset (inside the element just committed).
+    check(queue_reserve(&g_queue, 100u) == NULL, "reservation that doesn't fit");
+    check(!queue_commit(&g_queue, 10u), "commit after a failed reservation");
+    
+    uint8_t data[8] = { 0u };
+    check(queue_reserve(&g_queue, 40u) != NULL, "small reservation");
+    check(queue_enqueue(&g_queue, data, sizeof(data)), "enqueue after a reservation");
+    check(!queue_commit(&g_queue, 40u), "commit of an abandoned reservation");
+    check(queue_reserve(&g_queue, 20u) != NULL, "reservation after an enqueue");
+    check(queue_enqueueByte(&g_queue, data[0], false), "byte enqueue after a reservation");
+    check(!queue_commit(&g_queue, 20u), "commit of a reservation abandoned by a byte enqueue");
+    queue_enqueueDiscard(&g_queue);
+    check(queue_getSize(&g_queue) == 2, "element count after the reservations");
+}
+
+
+/// Stream of touch report sized frames produced in bursts and drained one frame
+/// per tick: reports the average share of the data array in use and the share
+/// of the frames dropped.
+/// @param[in]  burstSize   The number of frames produced per burst.
+/// @param[in]  burstPeriod The number of ticks between the bursts.
+/// @param[out] occupancy   The average number of bytes in use.
+/// @return The share of the frames dropped (per million).
+static unsigned long runStream(uint8_t burstSize, uint8_t burstPeriod, unsigned long* occupancy)
+{
+    static unsigned long const TickCount = 1000000ul;
+    
+    resetQueue();
+    unsigned long frames = 0;
+    unsigned long dropped = 0;
+    unsigned long used = 0;
+    for (unsigned long i = 0; i < TickCount; ++i)
+    {
+        for (uint8_t j = 0; (j < burstSize) && ((i % burstPeriod) == 0); ++j)
+        {
+            uint8_t frame[MAX_ELEMENT_SIZE];
+            uint16_t size = 20u + (nextRandom() % 45u);
+            memset(frame, (uint8_t)i, size);
+            frames++;
+            if (queue_enqueue(&g_queue, frame, size))
+                pushModel(size, 0u);
+            else
+                dropped++;
+        }
+        
+        if (g_model.count > 0)
+        {
+            uint8_t* data = NULL;
+            queue_dequeue(&g_queue, &data);
+            popModel(1);
+        }
+        
+        for (uint8_t j = 0; j < g_model.count; ++j)
+            used += g_model.sizes[(g_model.head + j) % ELEMENT_COUNT];
+    }
+    *occupancy = used / TickCount;
+    unsigned long droppedPpm = (unsigned long)((1000000ull * dropped) / frames);
+    printf("stream %u/%u: %.1f%% of %u bytes in use, %.2f%% of the frames dropped\n",
+        burstSize, burstPeriod, 100.0 * *occupancy / DATA_SIZE, DATA_SIZE, droppedPpm / 10000.0);
+    return droppedPpm;
+}
+
+
+/// Sustained occupancy of the data array. A queue that only reuses the start
+/// of the data array once it's empty drops about 11% of the frames of the
+/// stream that averages 80% of the drain rate, and keeps about 29% of the data
+/// array in use (36% of the frames dropped) when the stream is overloaded.
+static void runOccupancyTest(void)
+{
+    unsigned long occupancy = 0;
+    check(runStream(4, 5, &occupancy) == 0, "frames dropped below the drain rate");
+    runStream(4, 3, &occupancy);
+    check(occupancy > (DATA_SIZE / 2u), "sustained occupancy when overloaded");
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    runStressTest();
+    runReservationTest();
+    runOccupancyTest();
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,254 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host torture test of the Queue single-producer/single-consumer contract: a
+// producer thread stands in for the UART ISR and enqueues millions of frames
+// (whole, byte-by-byte and reserve/commit) into a small queue while the main
+// thread peaks, checks and dequeues them (single and batch). Every frame must
+// arrive once, in order and unchanged.
+
+// === DEPENDENCIES ============================================================
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "queue.h"
+
+
+// === DEFINES =================================================================
+
+/// The size of the data array of the queue under test; small so the data
+/// wraps and the queue is full often.
+#define DATA_SIZE                       (192u)
+
+/// The max number of elements of the queue under test.
+#define ELEMENT_COUNT                   (8u)
+
+/// The max size of a frame.
+#define MAX_FRAME_SIZE                  (64u)
+
+/// The number of frames sent through the queue.
+#define FRAME_COUNT                     (3000000ul)
+
+/// Each thread yields after about 1 in YIELD_INTERVAL operations so the
+/// threads interleave at any occupancy even on a single core host.
+#define YIELD_INTERVAL                  (4u)
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The data array of the queue under test.
+static uint8_t g_data[DATA_SIZE];
+
+/// The element array of the queue under test.
+static QueueElement g_elements[ELEMENT_COUNT];
+
+/// The queue under test; shared by the producer and the consumer threads.
+static Queue volatile g_queue;
+
+/// The number of times the producer found the queue full.
+static unsigned long g_producerStalls = 0;
+
+/// The number of frames that were missing, out of order or corrupt.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Get a pseudo-random value from a frame's sequence number and an index.
+/// @param[in]  sequence    The sequence number of the frame.
+/// @param[in]  index       The index.
+/// @return The pseudo-random value.
+static uint32_t hash(uint32_t sequence, uint32_t index)
+{
+    uint32_t value = (sequence * 0x9e3779b1u) ^ (index * 0x85ebca6bu);
+    value ^= value >> 15;
+    value *= 0x2c1b3c6du;
+    value ^= value >> 12;
+    return value;
+}
+
+
+/// Build a frame: the sequence number (little endian) followed by
+/// pseudo-random bytes.
+/// @param[in]  sequence    The sequence number of the frame.
+/// @param[out] frame       The frame.
+/// @return The size of the frame.
+static uint16_t buildFrame(uint32_t sequence, uint8_t frame[])
+{
+    uint16_t size = 4u + (hash(sequence, 0u) % (MAX_FRAME_SIZE - 3u));
+    for (uint16_t i = 0; i < 4u; ++i)
+        frame[i] = (uint8_t)(sequence >> (i * 8u));
+    for (uint16_t i = 4u; i < size; ++i)
+        frame[i] = (uint8_t)hash(sequence, i);
+    return size;
+}
+
+
+/// Record a failed check.
+/// @param[in]  sequence    The sequence number of the expected frame.
+/// @param[in]  message     Description of the check.
+static void fail(uint32_t sequence, char const* message)
+{
+    if (g_failures < 10)
+        printf("FAIL: frame %u: %s\n", (unsigned)sequence, message);
+    g_failures++;
+}
+
+
+/// Check a received frame against the expected frame.
+/// @param[in]  sequence    The expected sequence number.
+/// @param[in]  data        The received frame.
+/// @param[in]  size        The size of the received frame.
+static void checkFrame(uint32_t sequence, uint8_t const data[], uint16_t size)
+{
+    uint8_t frame[MAX_FRAME_SIZE];
+    uint16_t frameSize = buildFrame(sequence, frame);
+    if ((size != frameSize) || (memcmp(data, frame, size) != 0))
+        fail(sequence, "lost or corrupt");
+}
+
+
+/// Enqueue a frame with one of the enqueue functions used by the firmware.
+/// @param[in]  method  0: queue_enqueue; 1: queue_enqueueByte (like the
+///                     receive ISR); 2: queue_reserve and queue_commit.
+/// @param[in]  frame   The frame.
+/// @param[in]  size    The size of the frame.
+/// @return If the frame was enqueued.
+static bool enqueueFrame(uint8_t method, uint8_t const frame[], uint16_t size)
+{
+    bool status = false;
+    if (method == 0)
+        status = queue_enqueue(&g_queue, frame, size);
+    else if (method == 1)
+    {
+        status = true;
+        for (uint16_t i = 0; status && (i < size); ++i)
+            status = queue_enqueueByte(&g_queue, frame[i], (i + 1u) >= size);
+        if (!status)
+            queue_enqueueDiscard(&g_queue);
+    }
+    else
+    {
+        uint8_t* reservation = queue_reserve(&g_queue, MAX_FRAME_SIZE);
+        if (reservation != NULL)
+        {
+            memcpy(reservation, frame, size);
+            status = queue_commit(&g_queue, size);
+        }
+    }
+    return status;
+}
+
+
+/// The producer thread: enqueues every frame, retrying while the queue is
+/// full.
+/// @param[in]  argument    Unused.
+/// @return NULL.
+static void* produce(void* argument)
+{
+    (void)argument;
+    for (uint32_t sequence = 0; sequence < FRAME_COUNT; ++sequence)
+    {
+        uint8_t frame[MAX_FRAME_SIZE];
+        uint16_t size = buildFrame(sequence, frame);
+        uint8_t method = hash(sequence, 1u) % 3u;
+        while (!enqueueFrame(method, frame, size))
+        {
+            g_producerStalls++;
+            sched_yield();
+        }
+        if ((hash(sequence, 2u) % YIELD_INTERVAL) == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+
+/// The consumer: peaks, checks and dequeues every frame, alternating between
+/// single and batch dequeues.
+/// @return The number of times the consumer found the queue empty.
+static unsigned long consume(void)
+{
+    unsigned long stalls = 0;
+    uint32_t sequence = 0;
+    while (sequence < FRAME_COUNT)
+    {
+        uint8_t count = 0;
+        if ((sequence & 1u) > 0)
+        {
+            uint8_t* data = NULL;
+            uint16_t size = queue_peak(&g_queue, &data);
+            if (size > 0)
+            {
+                checkFrame(sequence, data, size);
+                if (queue_dequeue(&g_queue, &data) != size)
+                    fail(sequence, "dequeue");
+                count = 1;
+            }
+        }
+        else
+        {
+            QueueSpan spans[ELEMENT_COUNT];
+            count = queue_peakBatch(&g_queue, spans, ELEMENT_COUNT);
+            for (uint8_t i = 0; i < count; ++i)
+                checkFrame(sequence + i, spans[i].data, spans[i].size);
+            if (queue_dequeueBatch(&g_queue, count) != count)
+                fail(sequence, "batch dequeue");
+        }
+        
+        sequence += count;
+        if (count == 0)
+            stalls++;
+        if ((count == 0) || ((hash(sequence, 3u) % YIELD_INTERVAL) == 0))
+            sched_yield();
+    }
+    return stalls;
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    g_queue.data = g_data;
+    g_queue.elements = g_elements;
+    g_queue.maxDataSize = DATA_SIZE;
+    g_queue.maxSize = ELEMENT_COUNT;
+    
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, produce, NULL) != 0)
+    {
+        printf("FAIL: pthread_create\n");
+        return 1;
+    }
+    unsigned long consumerStalls = consume();
+    pthread_join(producer, NULL);
+    
+    QueueStats stats = queue_getStats(&g_queue);
+    bool empty = queue_isEmpty(&g_queue);
+#if ENABLE_QUEUE_STATS
+    bool balanced = (stats.enqueuedBytes == stats.dequeuedBytes);
+#else
+    bool balanced = (stats.maxDataSize == DATA_SIZE);
+#endif // ENABLE_QUEUE_STATS
+    printf("frames=%lu failures=%lu producer stalls=%lu consumer stalls=%lu empty=%d balanced=%d\n",
+        FRAME_COUNT, g_failures, g_producerStalls, consumerStalls, empty, balanced);
+    bool status = (g_failures == 0) && empty && balanced;
+    printf("%s\n", (status) ? "PASS" : "FAIL");
+    return (status) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,38 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// === DEPENDENCIES ============================================================
+
+#include "project.h"
+
+
+// === GLOBALS =================================================================
+
+uint32_t volatile g_stubRegisters[32];
+
+SysTick_Type g_stubSysTick;
+
+SCB_Type g_stubScb;
+
+
+// === PUBLIC FUNCTIONS ========================================================
+
+uint32_t CySysFlashWriteRow(uint32_t rowNum, uint8_t const rowData[])
+{
+    // The flash isn't modeled; the settings can't be saved.
+    (void)rowNum;
+    (void)rowData;
+    return CY_SYS_FLASH_SUCCESS + 1u;
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,274 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host stand-in for the project.h that PSoC Creator generates: declares the
+// parts of the CPU, the system and the component APIs the firmware modules
+// use so they can be built into the host simulations. The simulations define
+// the component functions they exercise; the registers and the core
+// peripherals are plain memory (see project.c).
+
+#ifndef PROJECT_H
+    #define PROJECT_H
+    
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+    
+    // === DEPENDENCIES ========================================================
+    
+    #ifndef __cplusplus
+        #include <stdbool.h>
+    #endif
+    #include <stdint.h>
+    
+    
+    // === DEFINES: CPU AND SYSTEM =============================================
+    
+    #define CY_ISR(name)                                    void name(void)
+    #define CY_ISR_PROTO(name)                              void name(void)
+    
+    #define CyGlobalIntEnable
+    #define CyGlobalIntDisable
+    
+    #define CYDEV_BCLK__HFCLK__HZ                           (48000000u)
+    #define CYDEV_BCLK__HFCLK__KHZ                          (48000u)
+    #define CYDEV_BCLK__SYSCLK__KHZ                         (48000u)
+    
+    #define SysTick_IRQn                                    (-1)
+    #define SCB_ICSR_PENDSTSET_Msk                          (1ul << 26)
+    #define SysTick                                         (&g_stubSysTick)
+    #define SCB                                             (&g_stubScb)
+    
+    #define CY_SYS_WDT_COUNTER0                             (0)
+    #define CY_SYS_WDT_MODE_INT                             (1)
+    
+    #define CY_FLASH_BASE                                   (0u)
+    #define CY_FLASH_SIZEOF_ROW                             (128u)
+    #define CY_SYS_FLASH_SUCCESS                            (0u)
+    
+    #define CY_GET_REG32(address)                           (*(uint32_t volatile*)(address))
+    #define CY_SET_REG32(address, value)                    (*(uint32_t volatile*)(address) = (value))
+    
+    
+    // === DEFINES: hostUart (SCB UART) ========================================
+    
+    #define hostUart_FIFO_SIZE                              (8u)
+    #define hostUart_SPI_UART_FIFO_SIZE                     (8u)
+    #define hostUart_UART_BYTE_MODE_ENABLE                  (0)
+    
+    #define hostUart_INTR_RX_TRIGGER                        (1u << 0)
+    #define hostUart_INTR_RX_NOT_EMPTY                      (1u << 2)
+    #define hostUart_INTR_RX_FULL                           (1u << 3)
+    #define hostUart_INTR_RX_OVERFLOW                       (1u << 5)
+    #define hostUart_INTR_RX_UNDERFLOW                      (1u << 6)
+    #define hostUart_INTR_RX_FRAME_ERROR                    (1u << 8)
+    #define hostUart_INTR_RX_PARITY_ERROR                   (1u << 9)
+    #define hostUart_UART_RX_ERROR_MASK                     (0xffu << 8)
+    
+    #define hostUart_INTR_TX_TRIGGER                        (1u << 0)
+    #define hostUart_INTR_TX_NOT_FULL                       (1u << 1)
+    #define hostUart_INTR_TX_EMPTY                          (1u << 4)
+    #define hostUart_INTR_TX_OVERFLOW                       (1u << 5)
+    #define hostUart_INTR_TX_UART_DONE                      (1u << 9)
+    
+    #define hostUart_CTRL_OVS_MASK                          (0xfu)
+    #define hostUart_RX_FIFO_STATUS_USED_MASK               (0xfu)
+    #define hostUart_TX_FIFO_STATUS_USED_MASK               (0xfu)
+    
+    #define hostUart_TX_FIFO_STATUS_REG                     (g_stubRegisters[0])
+    #define hostUart_RX_FIFO_STATUS_REG                     (g_stubRegisters[1])
+    #define hostUart_RX_FIFO_RD_REG                         (g_stubRegisters[2])
+    #define hostUart_TX_FIFO_WR_REG                         (g_stubRegisters[3])
+    #define hostUart_RX_FIFO_CTRL_REG                       (g_stubRegisters[4])
+    #define hostUart_TX_FIFO_CTRL_REG                       (g_stubRegisters[5])
+    #define hostUart_INTR_RX_MASK_REG                       (g_stubRegisters[6])
+    #define hostUart_INTR_TX_MASK_REG                       (g_stubRegisters[7])
+    #define hostUart_CTRL_REG                               (g_stubRegisters[8])
+    
+    
+    // === DEFINES: slaveI2c (SCB I2C MASTER) ==================================
+    
+    #define slaveI2c_I2C_WRITE_XFER_MODE                    (0u)
+    #define slaveI2c_I2C_READ_XFER_MODE                     (1u)
+    
+    #define slaveI2c_I2C_MODE_COMPLETE_XFER                 (0u)
+    #define slaveI2c_I2C_MODE_REPEAT_START                  (1u)
+    #define slaveI2c_I2C_MODE_NO_STOP                       (2u)
+    
+    #define slaveI2c_I2C_MSTAT_CLEAR                        (0u)
+    #define slaveI2c_I2C_MSTAT_RD_CMPLT                     (1u << 0)
+    #define slaveI2c_I2C_MSTAT_WR_CMPLT                     (1u << 1)
+    #define slaveI2c_I2C_MSTAT_XFER_INP                     (1u << 2)
+    #define slaveI2c_I2C_MSTAT_XFER_HALT                    (1u << 3)
+    #define slaveI2c_I2C_MSTAT_ERR_ADDR_NAK                 (1u << 5)
+    #define slaveI2c_I2C_MSTAT_ERR_MASK                     (0x3f0u)
+    
+    #define slaveI2c_I2C_MSTR_NO_ERROR                      (0u)
+    #define slaveI2c_I2C_MSTR_ERR_LB_NAK                    (1u << 0)
+    #define slaveI2c_I2C_MSTR_ERR_TIMEOUT                   (1u << 1)
+    #define slaveI2c_I2C_MSTR_BUS_BUSY                      (1u << 2)
+    #define slaveI2c_I2C_MSTR_NOT_READY                     (1u << 3)
+    
+    #define slaveI2c_INTR_MASTER_I2C_ARB_LOST               (1u << 0)
+    #define slaveI2c_INTR_MASTER_I2C_NACK                   (1u << 1)
+    #define slaveI2c_INTR_MASTER_I2C_STOP                   (1u << 4)
+    #define slaveI2c_INTR_MASTER_I2C_BUS_ERROR              (1u << 8)
+    
+    #define slaveI2c_I2C_CTRL_HIGH_PHASE_OVS_MASK           (0x0fu)
+    #define slaveI2c_I2C_CTRL_LOW_PHASE_OVS_MASK            (0xf0u)
+    #define slaveI2c_I2C_CTRL_LOW_PHASE_OVS_POS             (4u)
+    #define slaveI2c_I2C_CFG_SDA_IN_FILT_SEL                (1u << 4)
+    #define slaveI2c_I2C_CFG_SCL_IN_FILT_SEL                (1u << 12)
+    #define slaveI2c_RX_CTRL_MEDIAN                         (1u << 9)
+    
+    #define slaveI2c_I2C_STATUS_REG                         (g_stubRegisters[16])
+    #define slaveI2c_I2C_CTRL_REG                           (g_stubRegisters[17])
+    #define slaveI2c_I2C_CFG_REG                            (g_stubRegisters[18])
+    #define slaveI2c_INTR_MASTER_MASK_REG                   (g_stubRegisters[19])
+    #define slaveI2c_RX_CTRL_REG                            (g_stubRegisters[20])
+    
+    
+    // === TYPE DEFINES ========================================================
+    
+    /// Address of an interrupt service routine.
+    typedef void (*cyisraddress)(void);
+    
+    /// The SysTick registers.
+    typedef struct SysTick_Type
+    {
+        uint32_t volatile CTRL;
+        uint32_t volatile LOAD;
+        uint32_t volatile VAL;
+        uint32_t volatile CALIB;
+        
+    } SysTick_Type;
+    
+    /// The System Control Block registers used by the firmware.
+    typedef struct SCB_Type
+    {
+        uint32_t volatile CPUID;
+        uint32_t volatile ICSR;
+        
+    } SCB_Type;
+    
+    
+    // === GLOBALS =============================================================
+    
+    /// The component registers; see the *_REG defines.
+    extern uint32_t volatile g_stubRegisters[32];
+    
+    /// The SysTick registers.
+    extern SysTick_Type g_stubSysTick;
+    
+    /// The System Control Block registers.
+    extern SCB_Type g_stubScb;
+    
+    
+    // === FUNCTIONS: CPU AND SYSTEM ===========================================
+    
+    static inline uint8_t CyEnterCriticalSection(void) { return 0u; }
+    static inline void CyExitCriticalSection(uint8_t state) { (void)state; }
+    static inline void CyDelayUs(uint16_t us) { (void)us; }
+    static inline void CySoftwareReset(void) { }
+    static inline void CyIntEnable(int number) { (void)number; }
+    static inline void CyIntSetVector(int number, cyisraddress isr) { (void)number; (void)isr; }
+    static inline void CyIntSetSysVector(int number, cyisraddress isr) { (void)number; (void)isr; }
+    static inline uint32_t SysTick_Config(uint32_t ticks) { (void)ticks; return 0u; }
+    static inline void CySysWdtWriteMode(int counter, int mode) { (void)counter; (void)mode; }
+    
+    uint32_t CySysFlashWriteRow(uint32_t rowNum, uint8_t const rowData[]);
+    
+    
+    // === FUNCTIONS: hostUart (SCB UART) ======================================
+    
+    void hostUart_Start(void);
+    void hostUart_Stop(void);
+    void hostUart_Init(void);
+    void hostUart_Enable(void);
+    void hostUart_EnableInt(void);
+    void hostUart_DisableInt(void);
+    void hostUart_ClearPendingInt(void);
+    void hostUart_SetCustomInterruptHandler(cyisraddress isr);
+    
+    uint32_t hostUart_GetRxInterruptSource(void);
+    uint32_t hostUart_GetRxInterruptSourceMasked(void);
+    void hostUart_ClearRxInterruptSource(uint32_t mask);
+    uint32_t hostUart_GetRxInterruptMode(void);
+    void hostUart_SetRxInterruptMode(uint32_t mask);
+    void hostUart_SetRxFifoLevel(uint32_t level);
+    
+    uint32_t hostUart_GetTxInterruptSource(void);
+    uint32_t hostUart_GetTxInterruptSourceMasked(void);
+    void hostUart_ClearTxInterruptSource(uint32_t mask);
+    uint32_t hostUart_GetTxInterruptMode(void);
+    void hostUart_SetTxInterruptMode(uint32_t mask);
+    void hostUart_SetTxFifoLevel(uint32_t level);
+    
+    uint32_t hostUart_UartGetByte(void);
+    uint32_t hostUart_UartGetChar(void);
+    void hostUart_UartPutChar(uint32_t txDataByte);
+    void hostUart_UartPutString(char const string[]);
+    uint32_t hostUart_SpiUartReadRxData(void);
+    void hostUart_SpiUartWriteTxData(uint32_t txData);
+    uint32_t hostUart_SpiUartGetRxBufferSize(void);
+    uint32_t hostUart_SpiUartGetTxBufferSize(void);
+    void hostUart_SpiUartClearRxBuffer(void);
+    void hostUart_SpiUartClearTxBuffer(void);
+    
+    void hostUart_SCBCLK_Start(void);
+    void hostUart_SCBCLK_Stop(void);
+    void hostUart_SCBCLK_SetFractionalDividerRegister(uint16_t clkDivider, uint8_t clkFractional);
+    uint32_t hostUart_SCBCLK_GetDividerRegister(void);
+    uint8_t hostUart_SCBCLK_GetFractionalDividerRegister(void);
+    
+    void hostUartRts_Write(uint8_t value);
+    
+    
+    // === FUNCTIONS: slaveI2c (SCB I2C MASTER) ================================
+    
+    void slaveI2c_Start(void);
+    void slaveI2c_Stop(void);
+    void slaveI2c_Init(void);
+    void slaveI2c_Enable(void);
+    void slaveI2c_SetCustomInterruptHandler(cyisraddress isr);
+    
+    uint32_t slaveI2c_I2CMasterStatus(void);
+    uint32_t slaveI2c_I2CMasterClearStatus(void);
+    uint32_t slaveI2c_I2CMasterReadBuf(uint32_t slaveAddress, uint8_t* rdData, uint32_t cnt, uint32_t mode);
+    uint32_t slaveI2c_I2CMasterWriteBuf(uint32_t slaveAddress, uint8_t* wrData, uint32_t cnt, uint32_t mode);
+    uint32_t slaveI2c_I2CMasterSendStop(uint32_t timeoutMs);
+    
+    void slaveI2c_SCBCLK_Start(void);
+    void slaveI2c_SCBCLK_Stop(void);
+    void slaveI2c_SCBCLK_SetFractionalDividerRegister(uint16_t clkDivider, uint8_t clkFractional);
+    
+    
+    // === FUNCTIONS: SLAVE IRQ AND RESET ======================================
+    
+    void slaveIrq_StartEx(cyisraddress isr);
+    void slaveIrq_Enable(void);
+    void slaveIrq_Disable(void);
+    void slaveIrq_ClearPending(void);
+    uint8_t slaveIrqPin_Read(void);
+    uint8_t slaveIrqPin_ClearInterrupt(void);
+    uint8_t slaveReset_Read(void);
+    void slaveReset_Write(uint8_t value);
+    
+    
+    #ifdef __cplusplus
+        } // extern "C"
+    #endif
+
+#endif // PROJECT_H
+
+
+/* [] END OF FILE */
@@ -0,0 +1,368 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host stubs of the components and the modules uart.c uses: the host UART,
+// its RTS pin, the system time and the I2C module. The host tests of uart.c
+// call its encoders and decoders directly; the stubs only let it link and
+// initialize: the UART has no data to receive and drops the data written to
+// it, and the I2C module accepts every request without a bus.
+
+// === DEPENDENCIES ============================================================
+
+#include <string.h>
+
+#include "hwSystemTime.h"
+#include "i2c.h"
+#include "i2cTouch.h"
+#include "i2cUpdate.h"
+#include "project.h"
+#include "utility.h"
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The custom interrupt handler of the host UART.
+static cyisraddress g_uartIsr = NULL;
+
+/// The interrupt modes of the host UART.
+static uint32_t g_rxInterruptMode = 0u;
+static uint32_t g_txInterruptMode = 0u;
+
+/// The SCB clock divider of the host UART.
+static uint16_t g_clockDivider = 0u;
+static uint8_t g_clockFractional = 0u;
+
+/// The I2C bit rate.
+static uint32_t g_bitRate = 100000u;
+
+/// The lane policy of the I2C transfers.
+static I2cLanePolicy g_lanePolicy = I2cLanePolicy_WeightedRoundRobin;
+
+
+// === UTILITY =================================================================
+
+// Out-of-line definitions of the inline functions of utility.h for the builds
+// that don't inline them.
+extern inline uint16_t utility_bigEndianUint16(uint8_t const* data);
+extern inline uint32_t utility_bigEndianUint32(uint8_t const* data);
+
+
+// === SYSTEM TIME =============================================================
+
+uint32_t hwSystemTime_getCurrentMs(void)
+{
+    return 0u;
+}
+
+
+uint32_t hwSystemTime_getCurrentTicks(void)
+{
+    return 0u;
+}
+
+
+uint32_t hwSystemTime_getElapsedTicks(uint32_t startTicks)
+{
+    (void)startTicks;
+    return 0u;
+}
+
+
+uint32_t hwSystemTime_getTimestamp(void)
+{
+    return 0u;
+}
+
+
+// === hostUart ================================================================
+
+void hostUart_Start(void) { }
+void hostUart_EnableInt(void) { }
+void hostUart_DisableInt(void) { }
+void hostUart_ClearPendingInt(void) { }
+void hostUart_SCBCLK_Start(void) { }
+void hostUart_SCBCLK_Stop(void) { }
+
+
+void hostUart_SetCustomInterruptHandler(cyisraddress isr)
+{
+    g_uartIsr = isr;
+}
+
+
+uint32_t hostUart_GetRxInterruptSourceMasked(void)
+{
+    return 0u;
+}
+
+
+void hostUart_ClearRxInterruptSource(uint32_t mask)
+{
+    (void)mask;
+}
+
+
+void hostUart_SetRxInterruptMode(uint32_t mask)
+{
+    g_rxInterruptMode = mask;
+}
+
+
+void hostUart_SetRxFifoLevel(uint32_t level)
+{
+    (void)level;
+}
+
+
+uint32_t hostUart_GetTxInterruptSourceMasked(void)
+{
+    return 0u;
+}
+
+
+void hostUart_ClearTxInterruptSource(uint32_t mask)
+{
+    (void)mask;
+}
+
+
+void hostUart_SetTxInterruptMode(uint32_t mask)
+{
+    g_txInterruptMode = mask;
+}
+
+
+void hostUart_SetTxFifoLevel(uint32_t level)
+{
+    (void)level;
+}
+
+
+void hostUart_UartPutChar(uint32_t txDataByte)
+{
+    (void)txDataByte;
+}
+
+
+void hostUart_UartPutString(char const string[])
+{
+    (void)string;
+}
+
+
+uint32_t hostUart_SpiUartReadRxData(void)
+{
+    return 0u;
+}
+
+
+void hostUart_SpiUartWriteTxData(uint32_t txData)
+{
+    (void)txData;
+}
+
+
+uint32_t hostUart_SpiUartGetRxBufferSize(void)
+{
+    return 0u;
+}
+
+
+uint32_t hostUart_SpiUartGetTxBufferSize(void)
+{
+    return 0u;
+}
+
+
+void hostUart_SCBCLK_SetFractionalDividerRegister(uint16_t clkDivider, uint8_t clkFractional)
+{
+    g_clockDivider = clkDivider;
+    g_clockFractional = clkFractional;
+}
+
+
+uint32_t hostUart_SCBCLK_GetDividerRegister(void)
+{
+    return g_clockDivider;
+}
+
+
+uint8_t hostUart_SCBCLK_GetFractionalDividerRegister(void)
+{
+    return g_clockFractional;
+}
+
+
+void hostUartRts_Write(uint8_t value)
+{
+    (void)value;
+}
+
+
+// === I2C =====================================================================
+
+bool i2c_setBitRate(uint32_t bitRate)
+{
+    g_bitRate = bitRate;
+    return true;
+}
+
+
+uint32_t i2c_getBitRate(void)
+{
+    return g_bitRate;
+}
+
+
+void i2c_registerRxCallback(I2cRxCallback callback)
+{
+    (void)callback;
+}
+
+
+void i2c_registerErrorCallback(I2cErrorCallback callback)
+{
+    (void)callback;
+}
+
+
+void i2c_setSlaveAddress(uint8_t address)
+{
+    (void)address;
+}
+
+
+bool i2c_setSlaveContextAddress(uint8_t slave, uint8_t address)
+{
+    (void)address;
+    return (slave < I2C_SLAVE_COUNT);
+}
+
+
+uint16_t i2c_getLastDriverStatusMask(void)
+{
+    return 0u;
+}
+
+
+uint16_t i2c_getLastDriverReturnValue(void)
+{
+    return 0u;
+}
+
+
+I2cStatus i2c_ack(uint8_t address, uint32_t timeoutMs)
+{
+    (void)address;
+    (void)timeoutMs;
+    return (I2cStatus){ 0u };
+}
+
+
+I2cStatus i2c_ackApp(uint32_t timeoutMs)
+{
+    (void)timeoutMs;
+    return (I2cStatus){ 0u };
+}
+
+
+bool i2c_errorOccurred(I2cStatus const status)
+{
+    return (status.mask != 0u);
+}
+
+
+I2cStatus i2cTouch_read(uint8_t address, uint16_t size, uint8_t tag)
+{
+    (void)address;
+    (void)size;
+    (void)tag;
+    return (I2cStatus){ 0u };
+}
+
+
+I2cStatus i2cTouch_write(uint8_t address, uint8_t const data[], uint16_t size, uint8_t tag)
+{
+    (void)address;
+    (void)data;
+    (void)size;
+    (void)tag;
+    return (I2cStatus){ 0u };
+}
+
+
+I2cStatus i2cTouch_writeRead(uint8_t address, uint8_t const data[], uint16_t size, uint16_t readSize, uint8_t tag)
+{
+    (void)address;
+    (void)data;
+    (void)size;
+    (void)readSize;
+    (void)tag;
+    return (I2cStatus){ 0u };
+}
+
+
+QueueStats i2cTouch_getXferQueueStats(void)
+{
+    return (QueueStats){ 0u };
+}
+
+
+void i2cTouch_resetXferQueueStats(void) { }
+
+
+void i2cTouch_setLanePolicy(I2cLanePolicy policy, uint8_t slaveIrqWeight, uint8_t hostWeight)
+{
+    (void)slaveIrqWeight;
+    (void)hostWeight;
+    g_lanePolicy = policy;
+}
+
+
+I2cLanePolicy i2cTouch_getLanePolicy(uint8_t* slaveIrqWeight, uint8_t* hostWeight)
+{
+    if (slaveIrqWeight != NULL)
+        *slaveIrqWeight = 1u;
+    if (hostWeight != NULL)
+        *hostWeight = 1u;
+    return g_lanePolicy;
+}
+
+
+I2cLaneStats i2cTouch_getLaneStats(I2cLane lane)
+{
+    (void)lane;
+    return (I2cLaneStats){ 0u };
+}
+
+
+void i2cTouch_resetLaneStats(void) { }
+
+
+I2cStatus i2cUpdate_bootloaderRead(uint8_t data[], uint16_t size, uint32_t timeoutMs)
+{
+    (void)timeoutMs;
+    memset(data, 0, size);
+    return (I2cStatus){ 0u };
+}
+
+
+I2cStatus i2cUpdate_bootloaderWrite(uint8_t const data[], uint16_t size, uint32_t timeoutMs)
+{
+    (void)data;
+    (void)size;
+    (void)timeoutMs;
+    return (I2cStatus){ 0u };
+}
+
+
+/* [] END OF FILE */
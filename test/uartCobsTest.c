@@ -0,0 +1,539 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host test of the COBS framing of the UART: the frames readTxStream encodes
+// are checked against a reference COBS encoder, including payloads that end
+// on and around the 254 byte block boundary, and decoded again through
+// processReceivedData. Checks that the receiver drops a frame cut off by the
+// delimiter, a frame with a bad code byte, a frame that fails the CRC-16 and
+// a frame interrupted by the receive timeout, and resyncs on the next frame.
+// Also compares the escape and the COBS framing of raw count, adversarial and
+// sparse delta payloads: the wire bytes per payload byte and the host cycles
+// per payload byte of the encoding and the decoding.
+
+// === DEPENDENCIES ============================================================
+
+#include "uart.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+
+// === DEFINES =================================================================
+
+/// The max number of bytes of a payload.
+#define MAX_PAYLOAD_SIZE                (520u)
+
+/// The max number of bytes of a frame on the wire: the command, the payload,
+/// the CRC-16, a code byte per block and the delimiter.
+#define MAX_WIRE_SIZE                   (MAX_PAYLOAD_SIZE + 16u)
+
+/// The max number of bytes of a random payload.
+#define MAX_RANDOM_PAYLOAD_SIZE         (260u)
+
+/// The number of random payloads per zero byte density.
+#define PAYLOAD_COUNT                   (2000u)
+
+/// The number of sensors of a benchmark payload; 2 bytes per sensor.
+#define SENSOR_COUNT                    (120u)
+
+/// The number of bytes of a benchmark payload.
+#define BENCHMARK_PAYLOAD_SIZE          (SENSOR_COUNT * 2u)
+
+/// The number of different benchmark payloads per kind.
+#define BENCHMARK_FRAME_COUNT           (64u)
+
+/// The number of payload bytes encoded and decoded per measurement.
+#define BENCHMARK_BYTE_COUNT            (32000000ul)
+
+
+// === TYPE DEFINES ============================================================
+
+/// The kinds of benchmark payloads.
+typedef enum PayloadKind
+{
+    /// Big-endian raw counts near a baseline.
+    PayloadKind_Counts,
+    
+    /// Counts made of the escape framing's control bytes.
+    PayloadKind_Adversarial,
+    
+    /// Deltas that are zero except for one sensor.
+    PayloadKind_Sparse,
+    
+    PayloadKind_Count
+    
+} PayloadKind;
+
+
+/// Result of a benchmark of a framing.
+typedef struct Result
+{
+    /// The number of bytes on the wire per payload byte.
+    double wireRatio;
+    
+    /// The encoding cost (cycles per payload byte; ns if the host has no
+    /// cycle counter).
+    double encodeCost;
+    
+    /// The decoding cost (cycles per payload byte; ns if the host has no
+    /// cycle counter).
+    double decodeCost;
+    
+} Result;
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The names of the kinds of benchmark payloads.
+static char const* const G_PayloadKindNames[PayloadKind_Count] =
+{
+    "counts",
+    "adversarial",
+    "sparse",
+};
+
+/// The memory of the UART translator.
+static heapWord_t g_memory[2500u / sizeof(heapWord_t)];
+
+/// The payload.
+static uint8_t g_payload[MAX_PAYLOAD_SIZE];
+
+/// The frame read from the transmit stream.
+static uint8_t g_wire[MAX_WIRE_SIZE];
+
+/// The frame encoded by the reference encoder.
+static uint8_t g_expectedWire[MAX_WIRE_SIZE];
+
+/// The benchmark payloads.
+static uint8_t g_benchmarkPayloads[BENCHMARK_FRAME_COUNT][BENCHMARK_PAYLOAD_SIZE];
+
+/// The benchmark frames read from the transmit stream.
+static uint8_t g_benchmarkWire[BENCHMARK_FRAME_COUNT][(BENCHMARK_PAYLOAD_SIZE * 2u) + 8u];
+
+/// The number of bytes of the benchmark frames.
+static uint16_t g_benchmarkWireSizes[BENCHMARK_FRAME_COUNT];
+
+/// State of the pseudo-random number generator.
+static uint32_t g_random = 0x12345678u;
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Get the next pseudo-random number (xorshift32).
+/// @return The pseudo-random number.
+static uint32_t nextRandom(void)
+{
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 17;
+    g_random ^= g_random << 5;
+    return g_random;
+}
+
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        if (g_failures < 10)
+            printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Get the current time of the monotonic clock.
+/// @return The current time (ns).
+static double getTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+
+/// Get the current count of the CPU cycle counter.
+/// @return The cycle count; 0 if the host has no cycle counter.
+static uint64_t getCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0u;
+#endif
+}
+
+
+/// Get the cost of a measurement: the cycles if the host has a cycle counter,
+/// otherwise the time.
+/// @param[in]  startCycles The cycle count at the start of the measurement.
+/// @param[in]  startNs     The time at the start of the measurement (ns).
+/// @return The cost (cycles or ns).
+static double getCost(uint64_t startCycles, double startNs)
+{
+    uint64_t cycles = getCycles() - startCycles;
+    return (cycles > 0) ? ((double)cycles) : (getTimeNs() - startNs);
+}
+
+
+/// COBS-encode a frame: the command followed by the payload and the optional
+/// CRC-16, and the delimiter. A block that reaches COBS_MAX_CODE - 1 bytes is
+/// closed even if the frame ends with it.
+/// @param[out] target  The buffer to encode the frame into; MAX_WIRE_SIZE
+///                     bytes.
+/// @param[in]  command The command.
+/// @param[in]  source  The payload.
+/// @param[in]  size    The number of bytes of the payload.
+/// @param[in]  crc     If the CRC-16 of the frame is appended.
+/// @return The number of bytes of the encoded frame.
+static uint16_t referenceCobsEncode(uint8_t target[], uint8_t command, uint8_t const source[], uint16_t size, bool crc)
+{
+    uint8_t frame[MAX_PAYLOAD_SIZE + 3u];
+    uint16_t frameSize = 0;
+    frame[frameSize++] = command;
+    memcpy(&frame[frameSize], source, size);
+    frameSize += size;
+    if (crc)
+    {
+        uint16_t value = crc16_update(CRC16_INITIAL_VALUE, frame, frameSize);
+        frame[frameSize++] = HI_BYTE_16_BIT(value);
+        frame[frameSize++] = LO_BYTE_16_BIT(value);
+    }
+    
+    uint16_t t = 1u;
+    uint16_t codeIndex = 0;
+    uint8_t code = 1u;
+    for (uint16_t i = 0; i < frameSize; ++i)
+    {
+        if (frame[i] == 0)
+        {
+            target[codeIndex] = code;
+            codeIndex = t++;
+            code = 1u;
+        }
+        else
+        {
+            target[t++] = frame[i];
+            if (++code == COBS_MAX_CODE)
+            {
+                target[codeIndex] = code;
+                codeIndex = t++;
+                code = 1u;
+            }
+        }
+    }
+    target[codeIndex] = code;
+    target[t++] = 0;
+    return t;
+}
+
+
+/// Switch the framing of both directions the way the host does: with the
+/// BridgeCommand_Framing command, then reading its response.
+/// @param[in]  framing The framing.
+static void selectFraming(Framing framing)
+{
+    uint8_t const data[] = { framing };
+    check(processFramingCommand(data, sizeof(data)), "framing command");
+    while (readTxStream(g_wire, sizeof(g_wire)) > 0)
+        ;
+}
+
+
+/// Read the transmit stream in chunks of random sizes until it's empty.
+/// @param[out] target      The buffer to read the stream into.
+/// @param[in]  targetSize  The number of bytes available in the target.
+/// @return The number of bytes read.
+static uint16_t drainTxStream(uint8_t target[], uint16_t targetSize)
+{
+    uint16_t t = 0;
+    uint16_t size;
+    do
+    {
+        uint16_t chunkSize = 1u + (uint16_t)(nextRandom() % 17u);
+        if (chunkSize > (targetSize - t))
+            chunkSize = targetSize - t;
+        size = readTxStream(&target[t], chunkSize);
+        t += size;
+    }
+    while ((size > 0) && (t < targetSize));
+    return t;
+}
+
+
+/// Feed received bytes to the receiver in chunks of random sizes.
+/// @param[in]  source  The received bytes.
+/// @param[in]  size    The number of received bytes.
+static void receive(uint8_t const source[], uint16_t size)
+{
+    uint16_t offset = 0;
+    while (offset < size)
+    {
+        uint16_t chunkSize = 1u + (uint16_t)(nextRandom() % 64u);
+        if (chunkSize > (size - offset))
+            chunkSize = size - offset;
+        uint16_t processed = processReceivedData(&source[offset], chunkSize);
+        check(processed > 0, "receive progress");
+        if (processed == 0)
+            break;
+        offset += processed;
+    }
+}
+
+
+/// Check that the decoded receive queue holds exactly one frame: the command
+/// followed by the payload; the frame is dequeued.
+/// @param[in]  command The command.
+/// @param[in]  source  The payload.
+/// @param[in]  size    The number of bytes of the payload.
+/// @param[in]  message Description of the check.
+static void checkDecodedFrame(uint8_t command, uint8_t const source[], uint16_t size, char const* message)
+{
+    uint8_t* frame = NULL;
+    check(queue_getSize(&g_heap->decodedRxQueue) == 1u, message);
+    uint16_t frameSize = queue_dequeue(&g_heap->decodedRxQueue, &frame);
+    check((frameSize == (size + 1u)) && (frame != NULL) && (frame[0] == command) &&
+        (memcmp(&frame[1], source, size) == 0), message);
+    while (!queue_isEmpty(&g_heap->decodedRxQueue))
+        queue_dequeue(&g_heap->decodedRxQueue, &frame);
+}
+
+
+/// Check the COBS encoding of a payload against the reference encoder and
+/// decode it again if it fits the decoded receive queue.
+/// @param[in]  size    The number of bytes of the payload.
+/// @param[in]  message Description of the check.
+static void checkCobsFrame(uint16_t size, char const* message)
+{
+    uint16_t expectedSize = referenceCobsEncode(g_expectedWire, BridgeCommand_None, g_payload, size, false);
+    check(uart_txEnqueueData(g_payload, size), message);
+    uint16_t wireSize = drainTxStream(g_wire, sizeof(g_wire));
+    check((wireSize == expectedSize) && (memcmp(g_wire, g_expectedWire, expectedSize) == 0), message);
+    
+    if ((size + 1u) <= g_heap->decodedRxQueue.maxDataSize)
+    {
+        receive(g_wire, wireSize);
+        checkDecodedFrame(BridgeCommand_None, g_payload, size, message);
+    }
+}
+
+
+/// Check the COBS frames of payloads that end on and around the block
+/// boundary, and of random payloads with zero bytes of several densities.
+/// The frames start with the command of data (0) so the first block of the
+/// payload starts with its first byte.
+static void runEncodeTest(void)
+{
+    static uint16_t const BoundarySizes[] = { 1u, 252u, 253u, 254u, 255u, 256u, 507u, 508u, 509u };
+    static uint8_t const ZeroDensities[] = { 0u, 4u, 32u, 128u, 255u };
+    
+    selectFraming(Framing_Cobs);
+    for (uint8_t i = 0; i < (sizeof(BoundarySizes) / sizeof(BoundarySizes[0])); ++i)
+    {
+        for (uint16_t j = 0; j < BoundarySizes[i]; ++j)
+            g_payload[j] = (uint8_t)(1u + (nextRandom() % 255u));
+        checkCobsFrame(BoundarySizes[i], "block boundary");
+        
+        // A zero byte just before the end of the block.
+        if (BoundarySizes[i] > 2u)
+        {
+            g_payload[BoundarySizes[i] - 2u] = 0;
+            checkCobsFrame(BoundarySizes[i], "block boundary with zero");
+        }
+    }
+    
+    for (uint8_t i = 0; i < sizeof(ZeroDensities); ++i)
+    {
+        for (uint16_t j = 0; j < PAYLOAD_COUNT; ++j)
+        {
+            uint16_t size = 1u + (uint16_t)(nextRandom() % MAX_RANDOM_PAYLOAD_SIZE);
+            for (uint16_t k = 0; k < size; ++k)
+            {
+                uint32_t random = nextRandom();
+                g_payload[k] = ((random & 0xffu) < ZeroDensities[i]) ? (0u) : ((uint8_t)(1u + ((random >> 8) % 255u)));
+            }
+            checkCobsFrame(size, "random payload");
+        }
+    }
+    selectFraming(Framing_Escape);
+}
+
+
+/// Check that the receiver drops damaged frames and resyncs on the next frame.
+static void runResyncTest(void)
+{
+    static uint8_t const Payload[] = { 0x12u, 0x00u, 0x34u, 0x56u, 0x78u, 0x9au, 0xbcu, 0xdeu, 0xf0u, 0x11u };
+    
+    uint8_t good[MAX_WIRE_SIZE];
+    uint16_t goodSize = referenceCobsEncode(good, 'W', Payload, sizeof(Payload), false);
+    uint8_t damaged[MAX_WIRE_SIZE];
+    uint16_t damagedSize;
+    
+    selectFraming(Framing_Cobs);
+    
+    // A frame cut off by the delimiter in the middle of a block.
+    damagedSize = referenceCobsEncode(damaged, 'W', Payload, sizeof(Payload), false);
+    damaged[6] = 0;
+    receive(damaged, 7u);
+    receive(good, goodSize);
+    checkDecodedFrame('W', Payload, sizeof(Payload), "cut off frame");
+    
+    // A code byte that points past the delimiter.
+    damagedSize = referenceCobsEncode(damaged, 'W', Payload, sizeof(Payload), false);
+    damaged[3] = 0xf0u;
+    receive(damaged, damagedSize);
+    receive(good, goodSize);
+    checkDecodedFrame('W', Payload, sizeof(Payload), "bad code byte");
+    
+    // A frame that fails the CRC-16.
+    g_rxCrcEnabled = true;
+    uint16_t crcErrors = g_rxStats.crcErrors;
+    damagedSize = referenceCobsEncode(damaged, 'W', Payload, sizeof(Payload), true);
+    damaged[5] ^= 0x01u;
+    receive(damaged, damagedSize);
+    goodSize = referenceCobsEncode(good, 'W', Payload, sizeof(Payload), true);
+    receive(good, goodSize);
+    checkDecodedFrame('W', Payload, sizeof(Payload), "CRC-16 error");
+    check(g_rxStats.crcErrors == (crcErrors + 1u), "CRC-16 error count");
+    g_rxCrcEnabled = false;
+    
+    // A frame interrupted by the receive timeout.
+    uint16_t resyncs = g_rxStats.resyncs;
+    goodSize = referenceCobsEncode(good, 'W', Payload, sizeof(Payload), false);
+    receive(good, 5u);
+    resyncRx();
+    receive(good, goodSize);
+    checkDecodedFrame('W', Payload, sizeof(Payload), "receive timeout");
+    check(g_rxStats.resyncs == (resyncs + 1u), "resync count");
+    
+    selectFraming(Framing_Escape);
+}
+
+
+/// Fill a benchmark payload with a kind of payload.
+/// @param[out] target  The payload; BENCHMARK_PAYLOAD_SIZE bytes.
+/// @param[in]  kind    The kind of payload.
+/// @param[in]  frame   The index of the frame.
+static void makeBenchmarkPayload(uint8_t target[], PayloadKind kind, uint16_t frame)
+{
+    for (uint16_t sensor = 0; sensor < SENSOR_COUNT; ++sensor)
+    {
+        uint32_t random = nextRandom();
+        uint16_t value;
+        if (kind == PayloadKind_Counts)
+            value = (uint16_t)(0x0400u + (random % 64u));
+        else if (kind == PayloadKind_Adversarial)
+            value = ((random & 3u) == 0) ? (0x55aau) : ((uint16_t)(0xaa55u ^ ((random >> 8) & 0x0101u)));
+        else
+            value = (sensor == (frame % SENSOR_COUNT)) ? ((uint16_t)(200u + (random % 50u))) : (0u);
+        target[2u * sensor] = HI_BYTE_16_BIT(value);
+        target[(2u * sensor) + 1u] = LO_BYTE_16_BIT(value);
+    }
+}
+
+
+/// Measure the wire bytes and the encoding and decoding costs of a framing
+/// for a kind of payload.
+/// @param[in]  framing The framing.
+/// @param[in]  kind    The kind of payload.
+/// @return The result.
+static Result measureFraming(Framing framing, PayloadKind kind)
+{
+    Result result = { 0 };
+    selectFraming(framing);
+    for (uint16_t i = 0; i < BENCHMARK_FRAME_COUNT; ++i)
+        makeBenchmarkPayload(g_benchmarkPayloads[i], kind, i);
+    
+    unsigned long roundCount = BENCHMARK_BYTE_COUNT / (BENCHMARK_FRAME_COUNT * BENCHMARK_PAYLOAD_SIZE);
+    unsigned long payloadBytes = roundCount * BENCHMARK_FRAME_COUNT * BENCHMARK_PAYLOAD_SIZE;
+    unsigned long wireBytes = 0;
+    uint64_t startCycles = getCycles();
+    double start = getTimeNs();
+    for (unsigned long round = 0; round < roundCount; ++round)
+    {
+        for (uint16_t i = 0; i < BENCHMARK_FRAME_COUNT; ++i)
+        {
+            (void)uart_txEnqueueData(g_benchmarkPayloads[i], BENCHMARK_PAYLOAD_SIZE);
+            g_benchmarkWireSizes[i] = readTxStream(g_benchmarkWire[i], sizeof(g_benchmarkWire[i]));
+            wireBytes += g_benchmarkWireSizes[i];
+        }
+    }
+    result.encodeCost = getCost(startCycles, start) / payloadBytes;
+    result.wireRatio = (double)wireBytes / payloadBytes;
+    
+    // The receiver decodes the frames the transmitter encoded.
+    unsigned long decodedBytes = 0;
+    startCycles = getCycles();
+    start = getTimeNs();
+    for (unsigned long round = 0; round < roundCount; ++round)
+    {
+        for (uint16_t i = 0; i < BENCHMARK_FRAME_COUNT; ++i)
+        {
+            uint8_t* frame;
+            (void)processReceivedData(g_benchmarkWire[i], g_benchmarkWireSizes[i]);
+            decodedBytes += queue_dequeue(&g_heap->decodedRxQueue, &frame);
+        }
+    }
+    result.decodeCost = getCost(startCycles, start) / payloadBytes;
+    
+    // The COBS frames start with the command.
+    unsigned long expectedBytes = payloadBytes;
+    if (framing == Framing_Cobs)
+        expectedBytes += roundCount * BENCHMARK_FRAME_COUNT;
+    check(decodedBytes == expectedBytes, "benchmark decode");
+    
+    selectFraming(Framing_Escape);
+    return result;
+}
+
+
+/// Report the wire bytes and the encoding and decoding costs of the escape
+/// and the COBS framing for each kind of benchmark payload.
+static void runBenchmark(void)
+{
+    printf("%u byte payloads, %s per payload byte\n", BENCHMARK_PAYLOAD_SIZE, (getCycles() > 0) ? "cycles" : "ns");
+    for (uint8_t kind = 0; kind < PayloadKind_Count; ++kind)
+    {
+        Result escape = measureFraming(Framing_Escape, (PayloadKind)kind);
+        Result cobs = measureFraming(Framing_Cobs, (PayloadKind)kind);
+        printf("%-12s escape: wire %.3f, encode %5.2f, decode %5.2f; COBS: wire %.3f, encode %5.2f, decode %5.2f\n",
+            G_PayloadKindNames[kind], escape.wireRatio, escape.encodeCost, escape.decodeCost,
+            cobs.wireRatio, cobs.encodeCost, cobs.decodeCost);
+    }
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    uart_init();
+    check(uartTranslate_activate(g_memory, sizeof(g_memory) / sizeof(g_memory[0])) > 0, "activate");
+    runEncodeTest();
+    runResyncTest();
+    runBenchmark();
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */
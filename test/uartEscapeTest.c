@@ -0,0 +1,428 @@
+/* ========================================
+ *
+ * UICO, 2021
+ * All Rights Reserved
+ * UNPUBLISHED, LICENSED SOFTWARE.
+ *
+ * CONFIDENTIAL AND PROPRIETARY INFORMATION
+ * WHICH IS THE PROPERTY OF your company.
+ *
+ * ========================================
+*/
+
+// Host test of the escape scan of the UART transmitter: findEscapeOffset is
+// checked against a byte-by-byte scan for every head alignment and size up to
+// MAX_SCAN_SIZE with a control byte in every byte lane, and the frames
+// readTxStream encodes on the fly are checked against a reference escape
+// encoder for report-like, raw dump and control byte heavy payloads. Also
+// reports the host cycles per byte of the scan and of the encoding. Built with
+// ENABLE_UART_TX_SWAR_ESCAPE_SCAN on (uartEscapeTest) and off
+// (uartBytewiseEscapeTest, see config/uartBytewiseEscapeScan).
+
+// === DEPENDENCIES ============================================================
+
+#include "uart.c"
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+
+// === DEFINES =================================================================
+
+/// The max number of bytes scanned by the scan check.
+#define MAX_SCAN_SIZE                   (64u)
+
+/// The max number of bytes the scan check starts past a word boundary.
+#define MAX_HEAD_OFFSET                 (7u)
+
+/// The max number of bytes of a payload; the max size of a touch report.
+#define MAX_PAYLOAD_SIZE                (260u)
+
+/// The max number of bytes of an escaped frame of a payload.
+#define MAX_FRAME_SIZE                  ((2u * MAX_PAYLOAD_SIZE) + 2u)
+
+/// The number of payloads per kind encoded by the encode check.
+#define PAYLOAD_COUNT                   (2000u)
+
+/// The number of bytes per touch of a report-like payload: the touch ID, the
+/// 16-bit X and Y coordinates and the pressure.
+#define TOUCH_SIZE                      (6u)
+
+/// The baseline of the counts of a raw dump payload.
+#define RAW_BASELINE                    (0x0200u)
+
+/// The number of bytes scanned or encoded per measurement.
+#define BENCHMARK_BYTE_COUNT            (64000000ul)
+
+
+// === TYPE DEFINES ============================================================
+
+/// The kinds of payloads.
+typedef enum PayloadKind
+{
+    /// Touch reports with random 12-bit coordinates.
+    PayloadKind_Report,
+    
+    /// Raw dumps of 16-bit counts near a baseline.
+    PayloadKind_RawDump,
+    
+    /// Random bytes with a quarter of them control bytes.
+    PayloadKind_Adversarial,
+    
+    PayloadKind_Count
+    
+} PayloadKind;
+
+
+// === PRIVATE GLOBALS =========================================================
+
+/// The names of the kinds of payloads.
+static char const* const G_PayloadKindNames[PayloadKind_Count] =
+{
+    "report",
+    "raw dump",
+    "adversarial",
+};
+
+/// The memory of the UART translator.
+static heapWord_t g_memory[2500u / sizeof(heapWord_t)];
+
+/// The data of the scan check; word-aligned.
+static uint32_t g_scanWords[(MAX_HEAD_OFFSET + MAX_SCAN_SIZE + 8u) / sizeof(uint32_t)];
+
+/// The payload.
+static uint8_t g_payload[MAX_PAYLOAD_SIZE];
+
+/// The frame of the payload read from the transmit stream.
+static uint8_t g_frame[MAX_FRAME_SIZE];
+
+/// The frame of the payload encoded by the reference encoder.
+static uint8_t g_expectedFrame[MAX_FRAME_SIZE];
+
+/// State of the pseudo-random number generator.
+static uint32_t g_random = 0x12345678u;
+
+/// The number of failed checks.
+static unsigned long g_failures = 0;
+
+
+// === PRIVATE FUNCTIONS =======================================================
+
+/// Get the next pseudo-random number (xorshift32).
+/// @return The pseudo-random number.
+static uint32_t nextRandom(void)
+{
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 17;
+    g_random ^= g_random << 5;
+    return g_random;
+}
+
+
+/// Record a failed check.
+/// @param[in]  condition   The condition that must be true.
+/// @param[in]  message     Description of the check.
+static void check(bool condition, char const* message)
+{
+    if (!condition)
+    {
+        if (g_failures < 10)
+            printf("FAIL: %s\n", message);
+        g_failures++;
+    }
+}
+
+
+/// Get the current time of the monotonic clock.
+/// @return The current time (ns).
+static double getTimeNs(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec * 1e9) + now.tv_nsec;
+}
+
+
+/// Get the current count of the CPU cycle counter.
+/// @return The cycle count; 0 if the host has no cycle counter.
+static uint64_t getCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0u;
+#endif
+}
+
+
+/// Get a random byte that doesn't require an escape character; near misses of
+/// the control bytes are likely.
+/// @return The byte.
+static uint8_t nextFillerByte(void)
+{
+    static uint8_t const NearMisses[] = { 0xa8u, 0xabu, 0xaeu, 0x2au, 0x54u, 0x57u, 0xd5u, 0x00u, 0xffu };
+    
+    uint32_t random = nextRandom();
+    uint8_t data = ((random & 0x300u) == 0) ?
+        NearMisses[(random >> 16) % sizeof(NearMisses)] :
+        (uint8_t)random;
+    if (requiresEscapeCharacter(data))
+        data ^= 0x01u;
+    return data;
+}
+
+
+/// Find the first byte that requires an escape character byte-by-byte.
+/// @param[in]  source  The source buffer.
+/// @param[in]  size    The number of bytes in the source.
+/// @return The offset of the first byte that requires an escape character; if
+///         none of the bytes require an escape character, then size.
+static uint16_t referenceEscapeOffset(uint8_t const source[], uint16_t size)
+{
+    uint16_t offset = 0;
+    while ((offset < size) && (source[offset] != 0xaau) && (source[offset] != 0x55u))
+        offset++;
+    return offset;
+}
+
+
+/// Encode a payload into an escaped frame without a command.
+/// @param[out] target  The buffer to encode the frame into; MAX_FRAME_SIZE
+///                     bytes.
+/// @param[in]  source  The payload.
+/// @param[in]  size    The number of bytes of the payload.
+/// @return The number of bytes of the frame.
+static uint16_t referenceEncode(uint8_t target[], uint8_t const source[], uint16_t size)
+{
+    uint16_t t = 0;
+    target[t++] = 0xaau;
+    for (uint16_t i = 0; i < size; ++i)
+    {
+        if ((source[i] == 0xaau) || (source[i] == 0x55u))
+            target[t++] = 0x55u;
+        target[t++] = source[i];
+    }
+    target[t++] = 0xaau;
+    return t;
+}
+
+
+/// Fill the payload with the bytes of a kind of payload.
+/// @param[in]  kind    The kind of payload.
+/// @param[in]  size    The number of bytes of the payload.
+static void makePayload(PayloadKind kind, uint16_t size)
+{
+    switch (kind)
+    {
+        case PayloadKind_Report:
+        {
+            // Report ID and touch count, then the touches; the touch ID and
+            // the high bytes of the 12-bit coordinates are below 0x10.
+            for (uint16_t i = 0; i < size; ++i)
+            {
+                uint16_t field = (i >= 2u) ? ((i - 2u) % TOUCH_SIZE) : (0u);
+                uint32_t random = nextRandom();
+                if (i == 0)
+                    g_payload[i] = 0x01u;
+                else if (i == 1u)
+                    g_payload[i] = (uint8_t)((size - 2u) / TOUCH_SIZE);
+                else if ((field & 1u) == 0)
+                    g_payload[i] = (uint8_t)(random & 0x0fu);
+                else
+                    g_payload[i] = (uint8_t)random;
+            }
+            break;
+        }
+        
+        case PayloadKind_RawDump:
+        {
+            // Little-endian counts within +-64 of the baseline.
+            for (uint16_t i = 0; i < size; i += 2u)
+            {
+                uint16_t count = (uint16_t)(RAW_BASELINE - 64u + (nextRandom() & 0x7fu));
+                g_payload[i] = LO_BYTE_16_BIT(count);
+                if ((i + 1u) < size)
+                    g_payload[i + 1u] = HI_BYTE_16_BIT(count);
+            }
+            break;
+        }
+        
+        default:
+        {
+            for (uint16_t i = 0; i < size; ++i)
+            {
+                uint32_t random = nextRandom();
+                g_payload[i] = ((random & 0x3u) == 0) ?
+                    (((random & 0x4u) == 0) ? 0xaau : 0x55u) :
+                    (uint8_t)(random >> 8);
+            }
+            break;
+        }
+    }
+}
+
+
+/// Check findEscapeOffset against the byte-by-byte scan for every head
+/// alignment and size with no control byte, with one in every position and
+/// with a second one after it. The bytes past the end are control bytes so a
+/// scan past the end is caught.
+static void runScanTest(void)
+{
+    static uint8_t const ControlBytes[] = { 0xaau, 0x55u };
+    
+    uint8_t* data = (uint8_t*)g_scanWords;
+    for (uint16_t head = 0; head <= MAX_HEAD_OFFSET; ++head)
+    {
+        for (uint16_t size = 0; size <= MAX_SCAN_SIZE; ++size)
+        {
+            uint8_t* source = &data[head];
+            memset(data, 0xaa, sizeof(g_scanWords));
+            for (uint16_t i = 0; i < size; ++i)
+                source[i] = nextFillerByte();
+            check(findEscapeOffset(source, size) == size, "no control byte");
+            check(referenceEscapeOffset(source, size) == size, "reference no control byte");
+            
+            for (uint16_t position = 0; position < size; ++position)
+            {
+                for (uint8_t c = 0; c < sizeof(ControlBytes); ++c)
+                {
+                    uint8_t original = source[position];
+                    source[position] = ControlBytes[c];
+                    check(findEscapeOffset(source, size) == position, "one control byte");
+                    check(referenceEscapeOffset(source, size) == position, "reference one control byte");
+                    
+                    uint16_t second = position + 1u + (uint16_t)(nextRandom() % 8u);
+                    if (second < size)
+                    {
+                        uint8_t secondOriginal = source[second];
+                        source[second] = ControlBytes[c ^ 1u];
+                        check(findEscapeOffset(source, size) == position, "two control bytes");
+                        source[second] = secondOriginal;
+                    }
+                    source[position] = original;
+                }
+            }
+        }
+    }
+}
+
+
+/// Read the transmit stream in chunks of random sizes until it's empty.
+/// @param[out] target      The buffer to read the stream into.
+/// @param[in]  targetSize  The number of bytes available in the target.
+/// @return The number of bytes read.
+static uint16_t drainTxStream(uint8_t target[], uint16_t targetSize)
+{
+    uint16_t t = 0;
+    uint16_t size;
+    do
+    {
+        uint16_t chunkSize = 1u + (uint16_t)(nextRandom() % 17u);
+        if (chunkSize > (targetSize - t))
+            chunkSize = targetSize - t;
+        size = readTxStream(&target[t], chunkSize);
+        t += size;
+    }
+    while ((size > 0) && (t < targetSize));
+    return t;
+}
+
+
+/// Check the frames readTxStream encodes against the reference encoder for
+/// each kind of payload of random sizes, read in chunks of random sizes.
+static void runEncodeTest(void)
+{
+    for (uint8_t kind = 0; kind < PayloadKind_Count; ++kind)
+    {
+        for (uint16_t i = 0; i < PAYLOAD_COUNT; ++i)
+        {
+            uint16_t size = 1u + (uint16_t)(nextRandom() % MAX_PAYLOAD_SIZE);
+            makePayload((PayloadKind)kind, size);
+            uint16_t expectedSize = referenceEncode(g_expectedFrame, g_payload, size);
+            
+            check(uart_txEnqueueData(g_payload, size), "enqueue payload");
+            uint16_t frameSize = drainTxStream(g_frame, sizeof(g_frame));
+            check(frameSize == expectedSize, G_PayloadKindNames[kind]);
+            check(memcmp(g_frame, g_expectedFrame, expectedSize) == 0, G_PayloadKindNames[kind]);
+            check(readTxStream(g_frame, 1u) == 0, "stream empty");
+        }
+    }
+}
+
+
+/// Print the cost per byte of a measurement.
+/// @param[in]  name        The name of the measurement.
+/// @param[in]  byteCount   The number of bytes processed.
+/// @param[in]  cycles      The cycles spent; 0 if unknown.
+/// @param[in]  ns          The time spent (ns).
+static void printCost(char const* name, unsigned long byteCount, uint64_t cycles, double ns)
+{
+    if (cycles > 0)
+        printf("%-24s %6.2f cycles/byte, %6.3f ns/byte\n", name, (double)cycles / byteCount, ns / byteCount);
+    else
+        printf("%-24s %6.3f ns/byte\n", name, ns / byteCount);
+}
+
+
+/// Report the cost per byte of findEscapeOffset on a payload that doesn't
+/// require an escape character and of encoding report-like and raw dump
+/// payloads of the max size through the transmit stream.
+static void runBenchmark(void)
+{
+    printf("SWAR escape scan %s\n", ENABLE_UART_TX_SWAR_ESCAPE_SCAN ? "on" : "off");
+    
+    // Scan a clean payload at each head alignment.
+    uint8_t* data = (uint8_t*)g_scanWords;
+    for (uint16_t i = 0; i < sizeof(g_scanWords); ++i)
+        data[i] = nextFillerByte();
+    unsigned long scanCount = BENCHMARK_BYTE_COUNT / MAX_SCAN_SIZE;
+    unsigned long offsetSum = 0;
+    uint64_t startCycles = getCycles();
+    double start = getTimeNs();
+    for (unsigned long i = 0; i < scanCount; ++i)
+        offsetSum += findEscapeOffset(&data[i & 3u], MAX_SCAN_SIZE);
+    double elapsed = getTimeNs() - start;
+    printCost("scan (clean)", scanCount * MAX_SCAN_SIZE, getCycles() - startCycles, elapsed);
+    check(offsetSum == (scanCount * MAX_SCAN_SIZE), "clean scan");
+    
+    // Encode payloads of the max size; the cost includes the enqueue.
+    for (uint8_t kind = 0; kind <= PayloadKind_RawDump; ++kind)
+    {
+        makePayload((PayloadKind)kind, MAX_PAYLOAD_SIZE);
+        unsigned long frameCount = BENCHMARK_BYTE_COUNT / MAX_PAYLOAD_SIZE / 4u;
+        unsigned long frameBytes = 0;
+        startCycles = getCycles();
+        start = getTimeNs();
+        for (unsigned long i = 0; i < frameCount; ++i)
+        {
+            (void)uart_txEnqueueData(g_payload, MAX_PAYLOAD_SIZE);
+            frameBytes += readTxStream(g_frame, sizeof(g_frame));
+        }
+        elapsed = getTimeNs() - start;
+        char name[32];
+        snprintf(name, sizeof(name), "encode (%s)", G_PayloadKindNames[kind]);
+        printCost(name, frameCount * MAX_PAYLOAD_SIZE, getCycles() - startCycles, elapsed);
+        check(frameBytes == (frameCount * referenceEncode(g_expectedFrame, g_payload, MAX_PAYLOAD_SIZE)), name);
+    }
+}
+
+
+// === MAIN ====================================================================
+
+int main(void)
+{
+    uart_init();
+    check(uartTranslate_activate(g_memory, sizeof(g_memory) / sizeof(g_memory[0])) > 0, "activate");
+    runScanTest();
+    runEncodeTest();
+    runBenchmark();
+    printf("%s\n", (g_failures == 0) ? "PASS" : "FAIL");
+    return (g_failures == 0) ? 0 : 1;
+}
+
+
+/* [] END OF FILE */